@@ -608,6 +608,87 @@ XcursorFileLoadImages (FILE *file, int size)
     return XcursorXcFileLoadImages (&f, size);
 }
 
+typedef struct _XcursorMemoryFile {
+    const unsigned char	*data;
+    long		length;
+    long		position;
+} XcursorMemoryFile;
+
+static int
+_XcursorMemoryFileRead (XcursorFile *file, unsigned char *buf, int len)
+{
+    XcursorMemoryFile	*m = file->closure;
+    long		available = m->length - m->position;
+
+    if (len > available)
+	len = available;
+    if (len <= 0)
+	return 0;
+    memcpy (buf, m->data + m->position, len);
+    m->position += len;
+    return len;
+}
+
+static int
+_XcursorMemoryFileWrite (XcursorFile *file, unsigned char *buf, int len)
+{
+    (void) file;
+    (void) buf;
+    (void) len;
+    return EOF;
+}
+
+static int
+_XcursorMemoryFileSeek (XcursorFile *file, long offset, int whence)
+{
+    XcursorMemoryFile	*m = file->closure;
+    long		position;
+
+    switch (whence) {
+    case SEEK_SET:
+	position = offset;
+	break;
+    case SEEK_CUR:
+	position = m->position + offset;
+	break;
+    case SEEK_END:
+	position = m->length + offset;
+	break;
+    default:
+	return EOF;
+    }
+    if (position < 0 || position > m->length)
+	return EOF;
+    m->position = position;
+    return 0;
+}
+
+/** Load a cursor from memory
+ *
+ * This function decodes the images of the given nominal size from the
+ * contents of a cursor file, e.g. a memory mapped one. The name of the
+ * returned XcursorImages object is not set.
+ */
+XcursorImages *
+xcursor_load_images_from_memory(const unsigned char *data, long length, int size)
+{
+	XcursorMemoryFile m;
+	XcursorFile f;
+
+	if (!data || length <= 0)
+		return NULL;
+
+	m.data = data;
+	m.length = length;
+	m.position = 0;
+
+	f.closure = &m;
+	f.read = _XcursorMemoryFileRead;
+	f.write = _XcursorMemoryFileWrite;
+	f.seek = _XcursorMemoryFileSeek;
+	return XcursorXcFileLoadImages (&f, size);
+}
+
 /*
  * From libXcursor/src/library.c
  */
@@ -975,3 +1056,94 @@ xcursor_load_theme(const char *theme, int size,
 	if (inherits)
 		free(inherits);
 }
+
+static void
+index_all_cursors_in_dir(const char *path,
+			 void (*index_callback)(const char *, const char *, void *),
+			 void *user_data)
+{
+	DIR *dir = opendir(path);
+	struct dirent *ent;
+	char *full;
+
+	if (!dir)
+		return;
+
+	for(ent = readdir(dir); ent; ent = readdir(dir)) {
+#ifdef _DIRENT_HAVE_D_TYPE
+		if (ent->d_type != DT_UNKNOWN &&
+		    (ent->d_type != DT_REG && ent->d_type != DT_LNK))
+			continue;
+#endif
+		if (ent->d_name[0] == '.')
+			continue;
+
+		full = _XcursorBuildFullname(path, "", ent->d_name);
+		if (!full)
+			continue;
+
+		index_callback(ent->d_name, full, user_data);
+		free(full);
+	}
+
+	closedir(dir);
+}
+
+/** Index all the cursors of a theme
+ *
+ * This function works like xcursor_load_theme(), except that it doesn't
+ * read the cursor files. The index callback is called with the name of
+ * each cursor and the full path of the file it is stored in. The files
+ * of a theme are reported before the ones of the themes it inherits,
+ * so if a cursor appears more than once, the first file is the one
+ * that should be used.
+ *
+ * \param theme The name of theme that should be indexed
+ * \param index_callback A callback function that will be called
+ * for each cursor file found.
+ * \param user_data The data that should be passed to the index callback
+ */
+void
+xcursor_index_theme(const char *theme,
+		    void (*index_callback)(const char *, const char *, void *),
+		    void *user_data)
+{
+	char *full, *dir;
+	char *inherits = NULL;
+	const char *path, *i;
+
+	if (!theme)
+		theme = "default";
+
+	for (path = XcursorLibraryPath();
+	     path;
+	     path = _XcursorNextPath(path)) {
+		dir = _XcursorBuildThemeDir(path, theme);
+		if (!dir)
+			continue;
+
+		full = _XcursorBuildFullname(dir, "cursors", "");
+
+		if (full) {
+			index_all_cursors_in_dir(full, index_callback,
+						 user_data);
+			free(full);
+		}
+
+		if (!inherits) {
+			full = _XcursorBuildFullname(dir, "", "index.theme");
+			if (full) {
+				inherits = _XcursorThemeInherits(full);
+				free(full);
+			}
+		}
+
+		free(dir);
+	}
+
+	for (i = inherits; i; i = _XcursorNextPath(i))
+		xcursor_index_theme(i, index_callback, user_data);
+
+	if (inherits)
+		free(inherits);
+}
@@ -67,6 +67,14 @@ xcursor_load_theme(const char *theme, int size,
 		    void (*load_callback)(XcursorImages *, void *),
 		    void *user_data);
 
+void
+xcursor_index_theme(const char *theme,
+		    void (*index_callback)(const char *, const char *, void *),
+		    void *user_data);
+
+XcursorImages *
+xcursor_load_images_from_memory(const unsigned char *data, long length, int size);
+
 #ifdef __cplusplus
 }
 #endif
@@ -11,8 +11,27 @@
 #include <QMap>
 #include <QVector>
 
+#include <algorithm>
+
+#include <xf86drm.h>
+
 static QMap<int, QVector<_drmModeProperty>> s_drmProperties{};
 
+struct MockPlane
+{
+    _drmModePlane plane;
+    QVector<uint32_t> formats;
+};
+static QMap<int, QVector<MockPlane>> s_drmPlanes{};
+
+struct MockObjectProperties
+{
+    uint32_t objectId;
+    QVector<uint32_t> properties;
+    QVector<uint64_t> values;
+};
+static QMap<int, QVector<MockObjectProperties>> s_drmObjectProperties{};
+
 namespace MockDrm
 {
 
@@ -21,6 +40,17 @@ void addDrmModeProperties(int fd, const QVector<_drmModeProperty> &properties)
     s_drmProperties.insert(fd, properties);
 }
 
+void addDrmModePlane(int fd, const _drmModePlane &plane, const QVector<uint32_t> &formats)
+{
+    s_drmPlanes[fd].append({plane, formats});
+}
+
+void addDrmModeObjectProperties(int fd, uint32_t objectId,
+                                const QVector<uint32_t> &properties, const QVector<uint64_t> &values)
+{
+    s_drmObjectProperties[fd].append({objectId, properties, values});
+}
+
 }
 
 int drmModeAtomicAddProperty(drmModeAtomicReqPtr req, uint32_t object_id, uint32_t property_id, uint64_t value)
@@ -65,3 +95,98 @@ void drmModeFreeProperty(drmModePropertyPtr ptr)
 {
     delete ptr;
 }
+
+drmModePlanePtr drmModeGetPlane(int fd, uint32_t plane_id)
+{
+    auto it = s_drmPlanes.find(fd);
+    if (it == s_drmPlanes.end()) {
+        return nullptr;
+    }
+    auto it2 = std::find_if(it->constBegin(), it->constEnd(),
+        [plane_id] (const auto &plane) {
+            return plane.plane.plane_id == plane_id;
+        }
+    );
+    if (it2 == it->constEnd()) {
+        return nullptr;
+    }
+
+    auto *plane = new _drmModePlane(it2->plane);
+    plane->count_formats = it2->formats.count();
+    plane->formats = new uint32_t[it2->formats.count()];
+    std::copy(it2->formats.constBegin(), it2->formats.constEnd(), plane->formats);
+
+    return plane;
+}
+
+void drmModeFreePlane(drmModePlanePtr ptr)
+{
+    if (ptr) {
+        delete[] ptr->formats;
+    }
+    delete ptr;
+}
+
+drmModeObjectPropertiesPtr drmModeObjectGetProperties(int fd, uint32_t object_id, uint32_t object_type)
+{
+    Q_UNUSED(object_type)
+    auto it = s_drmObjectProperties.find(fd);
+    if (it == s_drmObjectProperties.end()) {
+        return nullptr;
+    }
+    auto it2 = std::find_if(it->constBegin(), it->constEnd(),
+        [object_id] (const auto &properties) {
+            return properties.objectId == object_id;
+        }
+    );
+    if (it2 == it->constEnd()) {
+        return nullptr;
+    }
+
+    auto *properties = new drmModeObjectProperties;
+    properties->count_props = it2->properties.count();
+    properties->props = new uint32_t[it2->properties.count()];
+    std::copy(it2->properties.constBegin(), it2->properties.constEnd(), properties->props);
+    properties->prop_values = new uint64_t[it2->values.count()];
+    std::copy(it2->values.constBegin(), it2->values.constEnd(), properties->prop_values);
+
+    return properties;
+}
+
+void drmModeFreeObjectProperties(drmModeObjectPropertiesPtr ptr)
+{
+    if (ptr) {
+        delete[] ptr->props;
+        delete[] ptr->prop_values;
+    }
+    delete ptr;
+}
+
+int drmModeAddFB(int fd, uint32_t width, uint32_t height, uint8_t depth,
+                 uint8_t bpp, uint32_t pitch, uint32_t bo_handle, uint32_t *buf_id)
+{
+    Q_UNUSED(fd)
+    Q_UNUSED(width)
+    Q_UNUSED(height)
+    Q_UNUSED(depth)
+    Q_UNUSED(bpp)
+    Q_UNUSED(pitch)
+    Q_UNUSED(bo_handle)
+    Q_UNUSED(buf_id)
+    return -1;
+}
+
+int drmModeRmFB(int fd, uint32_t bufferId)
+{
+    Q_UNUSED(fd)
+    Q_UNUSED(bufferId)
+    return 0;
+}
+
+int drmIoctl(int fd, unsigned long request, void *arg)
+{
+    Q_UNUSED(fd)
+    Q_UNUSED(request)
+    Q_UNUSED(arg)
+    return -1;
+}
@@ -17,5 +17,8 @@ namespace MockDrm
 {
 
 void addDrmModeProperties(int fd, const QVector<_drmModeProperty> &properties);
+void addDrmModePlane(int fd, const _drmModePlane &plane, const QVector<uint32_t> &formats);
+void addDrmModeObjectProperties(int fd, uint32_t objectId,
+                                const QVector<uint32_t> &properties, const QVector<uint64_t> &values);
 
 }
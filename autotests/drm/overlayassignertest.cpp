@@ -0,0 +1,329 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2020 KWin developers <kwin@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "mock_drm.h"
+#include "../../plugins/platforms/drm/drm_buffer.h"
+#include "../../plugins/platforms/drm/drm_object_plane.h"
+#include "../../plugins/platforms/drm/drm_overlay_assigner.h"
+#include <QtTest>
+
+#include <drm_fourcc.h>
+
+using namespace KWin;
+
+static const int s_fd = 30;
+
+static const QVector<QByteArray> s_propertyNames = {
+    QByteArrayLiteral("type"),
+    QByteArrayLiteral("SRC_X"),
+    QByteArrayLiteral("SRC_Y"),
+    QByteArrayLiteral("SRC_W"),
+    QByteArrayLiteral("SRC_H"),
+    QByteArrayLiteral("CRTC_X"),
+    QByteArrayLiteral("CRTC_Y"),
+    QByteArrayLiteral("CRTC_W"),
+    QByteArrayLiteral("CRTC_H"),
+    QByteArrayLiteral("FB_ID"),
+    QByteArrayLiteral("CRTC_ID"),
+    QByteArrayLiteral("rotation")
+};
+// not part of the properties KWin sets, so it's only added to some planes
+static const uint32_t s_zposPropertyId = 100;
+
+class MockBuffer : public DrmBuffer
+{
+public:
+    MockBuffer(quint32 bufferId, const QSize &size)
+        : DrmBuffer(s_fd)
+    {
+        m_bufferId = bufferId;
+        m_size = size;
+    }
+};
+
+class MockPlane : public DrmPlane
+{
+public:
+    MockPlane(uint32_t id)
+        : DrmPlane(id, s_fd)
+    {
+    }
+    ~MockPlane() override {
+        // the buffers are owned by the test
+        setNext(nullptr);
+    }
+
+    uint64_t value(DrmPlane::PropertyIndex prop) const {
+        auto property = m_props.at(int(prop));
+        return property ? property->value() : 0;
+    }
+};
+
+class OverlayAssignerTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+    void testAssignFormat();
+    void testAssignCrtc();
+    void testPlaneProperties();
+    void testTestFailure();
+    void testPlaneUsedOnce();
+    void testInvalidCandidates();
+    void testZpos();
+
+private:
+    MockPlane *createPlane(uint32_t id, uint32_t possibleCrtcs, const QVector<uint32_t> &formats, int zpos = -1);
+
+    QVector<MockPlane *> m_planes;
+    QVector<MockBuffer *> m_buffers;
+};
+
+void OverlayAssignerTest::initTestCase()
+{
+    QVector<_drmModeProperty> properties;
+    for (int i = 0; i < s_propertyNames.count(); ++i) {
+        _drmModeProperty property{};
+        property.prop_id = i + 1;
+        qstrncpy(property.name, s_propertyNames[i].constData(), DRM_PROP_NAME_LEN);
+        properties << property;
+    }
+    _drmModeProperty zpos{};
+    zpos.prop_id = s_zposPropertyId;
+    qstrncpy(zpos.name, "zpos", DRM_PROP_NAME_LEN);
+    properties << zpos;
+    MockDrm::addDrmModeProperties(s_fd, properties);
+}
+
+void OverlayAssignerTest::init()
+{
+    m_planes.clear();
+    m_buffers.clear();
+}
+
+void OverlayAssignerTest::cleanup()
+{
+    qDeleteAll(m_planes);
+    qDeleteAll(m_buffers);
+}
+
+MockPlane *OverlayAssignerTest::createPlane(uint32_t id, uint32_t possibleCrtcs, const QVector<uint32_t> &formats, int zpos)
+{
+    _drmModePlane plane{};
+    plane.plane_id = id;
+    plane.possible_crtcs = possibleCrtcs;
+    MockDrm::addDrmModePlane(s_fd, plane, formats);
+
+    QVector<uint32_t> propertyIds;
+    QVector<uint64_t> values;
+    for (int i = 0; i < s_propertyNames.count(); ++i) {
+        propertyIds << i + 1;
+        values << 0;
+    }
+    if (zpos >= 0) {
+        propertyIds << s_zposPropertyId;
+        values << zpos;
+    }
+    MockDrm::addDrmModeObjectProperties(s_fd, id, propertyIds, values);
+
+    MockPlane *p = new MockPlane(id);
+    if (!p->atomicInit()) {
+        delete p;
+        return nullptr;
+    }
+    m_planes << p;
+    return p;
+}
+
+void OverlayAssignerTest::testAssignFormat()
+{
+    MockPlane *rgbPlane = createPlane(10, 0b1, {DRM_FORMAT_XRGB8888});
+    MockPlane *yuvPlane = createPlane(11, 0b1, {DRM_FORMAT_XRGB8888, DRM_FORMAT_NV12});
+    QVERIFY(rgbPlane);
+    QVERIFY(yuvPlane);
+
+    MockBuffer *buffer = new MockBuffer(1, QSize(640, 480));
+    m_buffers << buffer;
+
+    DrmOverlayAssigner assigner({rgbPlane, yuvPlane}, nullptr, 0, 42);
+    const QVector<DrmPlane *> assigned = assigner.assign({{buffer, DRM_FORMAT_NV12, QRect(0, 0, 640, 480)}},
+        [] (DrmPlane *) { return true; });
+
+    QCOMPARE(assigned.count(), 1);
+    QCOMPARE(assigned.first(), yuvPlane);
+    QCOMPARE(yuvPlane->next(), buffer);
+    QVERIFY(!rgbPlane->next());
+}
+
+void OverlayAssignerTest::testAssignCrtc()
+{
+    MockPlane *firstCrtcPlane = createPlane(20, 0b01, {DRM_FORMAT_XRGB8888});
+    MockPlane *secondCrtcPlane = createPlane(21, 0b10, {DRM_FORMAT_XRGB8888});
+    QVERIFY(firstCrtcPlane);
+    QVERIFY(secondCrtcPlane);
+
+    MockBuffer *buffer = new MockBuffer(1, QSize(100, 100));
+    m_buffers << buffer;
+
+    DrmOverlayAssigner assigner({firstCrtcPlane, secondCrtcPlane}, nullptr, 1, 42);
+    const QVector<DrmPlane *> assigned = assigner.assign({{buffer, DRM_FORMAT_XRGB8888, QRect(0, 0, 100, 100)}},
+        [] (DrmPlane *) { return true; });
+
+    QCOMPARE(assigned, QVector<DrmPlane *>{secondCrtcPlane});
+}
+
+void OverlayAssignerTest::testPlaneProperties()
+{
+    MockPlane *plane = createPlane(30, 0b1, {DRM_FORMAT_XRGB8888});
+    QVERIFY(plane);
+
+    MockBuffer *buffer = new MockBuffer(7, QSize(320, 240));
+    m_buffers << buffer;
+
+    DrmOverlayAssigner assigner({plane}, nullptr, 0, 42);
+    const QVector<DrmPlane *> assigned = assigner.assign({{buffer, DRM_FORMAT_XRGB8888, QRect(100, 50, 640, 480)}},
+        [] (DrmPlane *) { return true; });
+    QCOMPARE(assigned, QVector<DrmPlane *>{plane});
+
+    QCOMPARE(plane->value(DrmPlane::PropertyIndex::FbId), uint64_t(7));
+    QCOMPARE(plane->value(DrmPlane::PropertyIndex::CrtcId), uint64_t(42));
+    QCOMPARE(plane->value(DrmPlane::PropertyIndex::SrcX), uint64_t(0));
+    QCOMPARE(plane->value(DrmPlane::PropertyIndex::SrcY), uint64_t(0));
+    QCOMPARE(plane->value(DrmPlane::PropertyIndex::SrcW), uint64_t(320 << 16));
+    QCOMPARE(plane->value(DrmPlane::PropertyIndex::SrcH), uint64_t(240 << 16));
+    QCOMPARE(plane->value(DrmPlane::PropertyIndex::CrtcX), uint64_t(100));
+    QCOMPARE(plane->value(DrmPlane::PropertyIndex::CrtcY), uint64_t(50));
+    QCOMPARE(plane->value(DrmPlane::PropertyIndex::CrtcW), uint64_t(640));
+    QCOMPARE(plane->value(DrmPlane::PropertyIndex::CrtcH), uint64_t(480));
+}
+
+void OverlayAssignerTest::testTestFailure()
+{
+    MockPlane *rejectingPlane = createPlane(40, 0b1, {DRM_FORMAT_XRGB8888});
+    MockPlane *acceptingPlane = createPlane(41, 0b1, {DRM_FORMAT_XRGB8888});
+    QVERIFY(rejectingPlane);
+    QVERIFY(acceptingPlane);
+
+    MockBuffer *buffer = new MockBuffer(1, QSize(100, 100));
+    m_buffers << buffer;
+
+    QVector<DrmPlane *> tested;
+    DrmOverlayAssigner assigner({rejectingPlane, acceptingPlane}, nullptr, 0, 42);
+    const QVector<DrmPlane *> assigned = assigner.assign({{buffer, DRM_FORMAT_XRGB8888, QRect(0, 0, 100, 100)}},
+        [&tested, rejectingPlane] (DrmPlane *plane) {
+            tested << plane;
+            return plane != rejectingPlane;
+        });
+
+    QCOMPARE(tested, (QVector<DrmPlane *>{rejectingPlane, acceptingPlane}));
+    QCOMPARE(assigned, QVector<DrmPlane *>{acceptingPlane});
+    // the rejected plane is left disabled
+    QVERIFY(!rejectingPlane->next());
+    QCOMPARE(rejectingPlane->value(DrmPlane::PropertyIndex::FbId), uint64_t(0));
+    QCOMPARE(rejectingPlane->value(DrmPlane::PropertyIndex::CrtcId), uint64_t(0));
+
+    // no plane at all is accepted
+    MockBuffer *otherBuffer = new MockBuffer(2, QSize(100, 100));
+    m_buffers << otherBuffer;
+    DrmOverlayAssigner otherAssigner({rejectingPlane}, nullptr, 0, 42);
+    const QVector<DrmPlane *> otherAssigned = otherAssigner.assign({{otherBuffer, DRM_FORMAT_XRGB8888, QRect(0, 0, 100, 100)}},
+        [] (DrmPlane *) { return false; });
+    QCOMPARE(otherAssigned, QVector<DrmPlane *>{nullptr});
+    QVERIFY(!rejectingPlane->next());
+}
+
+void OverlayAssignerTest::testPlaneUsedOnce()
+{
+    MockPlane *plane = createPlane(50, 0b1, {DRM_FORMAT_XRGB8888});
+    QVERIFY(plane);
+
+    MockBuffer *first = new MockBuffer(1, QSize(100, 100));
+    MockBuffer *second = new MockBuffer(2, QSize(100, 100));
+    m_buffers << first << second;
+
+    DrmOverlayAssigner assigner({plane}, nullptr, 0, 42);
+    const QVector<DrmPlane *> assigned = assigner.assign({
+            {first, DRM_FORMAT_XRGB8888, QRect(0, 0, 100, 100)},
+            {second, DRM_FORMAT_XRGB8888, QRect(200, 0, 100, 100)}
+        },
+        [] (DrmPlane *) { return true; });
+
+    QCOMPARE(assigned, (QVector<DrmPlane *>{plane, nullptr}));
+    QCOMPARE(plane->next(), first);
+}
+
+void OverlayAssignerTest::testInvalidCandidates()
+{
+    MockPlane *plane = createPlane(60, 0b1, {DRM_FORMAT_XRGB8888});
+    QVERIFY(plane);
+
+    MockBuffer *noFramebuffer = new MockBuffer(0, QSize(100, 100));
+    MockBuffer *buffer = new MockBuffer(1, QSize(100, 100));
+    m_buffers << noFramebuffer << buffer;
+
+    int testCount = 0;
+    DrmOverlayAssigner assigner({plane}, nullptr, 0, 42);
+    const QVector<DrmPlane *> assigned = assigner.assign({
+            {nullptr, DRM_FORMAT_XRGB8888, QRect(0, 0, 100, 100)},
+            {noFramebuffer, DRM_FORMAT_XRGB8888, QRect(0, 0, 100, 100)},
+            {buffer, DRM_FORMAT_XRGB8888, QRect()}
+        },
+        [&testCount] (DrmPlane *) {
+            testCount++;
+            return true;
+        });
+
+    QCOMPARE(assigned, (QVector<DrmPlane *>{nullptr, nullptr, nullptr}));
+    QCOMPARE(testCount, 0);
+    QVERIFY(!plane->next());
+}
+
+void OverlayAssignerTest::testZpos()
+{
+    MockPlane *primary = createPlane(70, 0b1, {DRM_FORMAT_XRGB8888}, 2);
+    MockPlane *below = createPlane(71, 0b1, {DRM_FORMAT_XRGB8888}, 1);
+    MockPlane *above = createPlane(72, 0b1, {DRM_FORMAT_XRGB8888}, 3);
+    MockPlane *unknown = createPlane(73, 0b1, {DRM_FORMAT_XRGB8888});
+    QVERIFY(primary);
+    QVERIFY(below);
+    QVERIFY(above);
+    QVERIFY(unknown);
+    QVERIFY(primary->hasZpos());
+    QCOMPARE(primary->zpos(), uint64_t(2));
+    QVERIFY(!unknown->hasZpos());
+
+    MockBuffer *buffer = new MockBuffer(1, QSize(100, 100));
+    m_buffers << buffer;
+
+    // a plane below the primary plane would be hidden by the composited content
+    QVector<DrmPlane *> tested;
+    auto test = [&tested] (DrmPlane *plane) {
+        tested << plane;
+        return true;
+    };
+    DrmOverlayAssigner assigner({below, above}, primary, 0, 42);
+    QCOMPARE(assigner.assign({{buffer, DRM_FORMAT_XRGB8888, QRect(0, 0, 100, 100)}}, test),
+             QVector<DrmPlane *>{above});
+    QCOMPARE(tested, QVector<DrmPlane *>{above});
+    QVERIFY(!below->next());
+
+    DrmOverlayAssigner belowAssigner({below}, primary, 0, 42);
+    QCOMPARE(belowAssigner.assign({{buffer, DRM_FORMAT_XRGB8888, QRect(0, 0, 100, 100)}}, test),
+             QVector<DrmPlane *>{nullptr});
+    QVERIFY(!below->next());
+
+    // without zpos the driver decides
+    DrmOverlayAssigner unknownAssigner({unknown}, primary, 0, 42);
+    QCOMPARE(unknownAssigner.assign({{buffer, DRM_FORMAT_XRGB8888, QRect(0, 0, 100, 100)}}, test),
+             QVector<DrmPlane *>{unknown});
+}
+
+QTEST_GUILESS_MAIN(OverlayAssignerTest)
+#include "overlayassignertest.moc"
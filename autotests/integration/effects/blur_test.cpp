@@ -0,0 +1,296 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2020 KWin developers <kwin@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "kwin_wayland_test.h"
+#include "abstract_client.h"
+#include "composite.h"
+#include "effects.h"
+#include "effectloader.h"
+#include "internal_client.h"
+#include "platform.h"
+#include "scene.h"
+#include "wayland_server.h"
+#include "workspace.h"
+#include "effect_builtins.h"
+
+#include <KConfigGroup>
+#include <KWayland/Client/surface.h>
+
+#include <QPainter>
+#include <QRasterWindow>
+
+using namespace KWin;
+static const QString s_socketName = QStringLiteral("wayland_test_effects_blur-0");
+
+class HelperWindow : public QRasterWindow
+{
+    Q_OBJECT
+public:
+    explicit HelperWindow(const QColor &color)
+        : QRasterWindow(nullptr)
+        , m_color(color)
+    {
+        setFlags(Qt::FramelessWindowHint);
+    }
+
+    void setColor(const QColor &color)
+    {
+        m_color = color;
+        update();
+    }
+
+protected:
+    void paintEvent(QPaintEvent *event) override
+    {
+        Q_UNUSED(event)
+        QPainter p(this);
+        p.setCompositionMode(QPainter::CompositionMode_Source);
+        p.fillRect(0, 0, width(), height(), m_color);
+    }
+
+private:
+    QColor m_color;
+};
+
+class BlurTest : public QObject
+{
+Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void testCacheReusedForOwnDamage();
+    void testOnlyBlurredWindowsArePainted();
+    void testOccludedWindowSkipped();
+
+private:
+    struct BlurStatistics {
+        int blurred = 0;
+        int cached = 0;
+    };
+    BlurStatistics blurStatistics() const;
+    void waitForIdle();
+
+    Effect *m_blur = nullptr;
+};
+
+void BlurTest::initTestCase()
+{
+    qRegisterMetaType<KWin::InternalClient *>();
+    qRegisterMetaType<KWin::Effect *>();
+    QSignalSpy applicationStartedSpy(kwinApp(), &Application::started);
+    QVERIFY(applicationStartedSpy.isValid());
+    kwinApp()->platform()->setInitialWindowSize(QSize(1280, 1024));
+    QVERIFY(waylandServer()->init(s_socketName.toLocal8Bit()));
+
+    // disable all effects - we don't want to have it interact with the rendering
+    auto config = KSharedConfig::openConfig(QString(), KConfig::SimpleConfig);
+    KConfigGroup plugins(config, QStringLiteral("Plugins"));
+    ScriptedEffectLoader loader;
+    const auto builtinNames = BuiltInEffects::availableEffectNames() << loader.listOfKnownEffects();
+    for (QString name : builtinNames) {
+        plugins.writeEntry(name + QStringLiteral("Enabled"), false);
+    }
+    config->sync();
+    kwinApp()->setConfig(config);
+
+    qputenv("KWIN_COMPOSE", QByteArrayLiteral("O2"));
+
+    kwinApp()->start();
+    QVERIFY(applicationStartedSpy.wait());
+    QVERIFY(Compositor::self());
+    QCOMPARE(Compositor::self()->scene()->compositingType(), KWin::OpenGL2Compositing);
+}
+
+void BlurTest::init()
+{
+    QVERIFY(Test::setupWaylandConnection());
+
+    EffectsHandlerImpl *e = static_cast<EffectsHandlerImpl *>(effects);
+    auto effectloader = e->findChild<AbstractEffectLoader *>();
+    QVERIFY(effectloader);
+    QSignalSpy effectLoadedSpy(effectloader, &AbstractEffectLoader::effectLoaded);
+    QVERIFY(effectLoadedSpy.isValid());
+
+    const QString name = BuiltInEffects::nameForEffect(BuiltInEffect::Blur);
+    if (!e->loadEffect(name)) {
+        QSKIP("The blur effect is not supported by the OpenGL driver");
+    }
+    QVERIFY(e->isEffectLoaded(name));
+    QCOMPARE(effectLoadedSpy.count(), 1);
+    m_blur = effectLoadedSpy.first().first().value<Effect *>();
+    QVERIFY(m_blur);
+}
+
+void BlurTest::cleanup()
+{
+    EffectsHandlerImpl *e = static_cast<EffectsHandlerImpl *>(effects);
+    e->unloadAllEffects();
+    m_blur = nullptr;
+    Test::destroyWaylandConnection();
+}
+
+BlurTest::BlurStatistics BlurTest::blurStatistics() const
+{
+    // the blur effect reports "blurred=<count> cached=<count>"
+    BlurStatistics statistics;
+    const QStringList values = m_blur->debug(QStringLiteral("cache")).split(QLatin1Char(' '));
+    for (const QString &value : values) {
+        const QStringList pair = value.split(QLatin1Char('='));
+        if (pair.count() != 2) {
+            continue;
+        }
+        if (pair.first() == QLatin1String("blurred")) {
+            statistics.blurred = pair.last().toInt();
+        } else if (pair.first() == QLatin1String("cached")) {
+            statistics.cached = pair.last().toInt();
+        }
+    }
+    return statistics;
+}
+
+void BlurTest::waitForIdle()
+{
+    // wait until the compositor stops painting frames
+    QSignalSpy frameRenderedSpy(Compositor::self()->scene(), &Scene::frameRendered);
+    QVERIFY(frameRenderedSpy.isValid());
+    while (frameRenderedSpy.wait(100)) {
+    }
+}
+
+void BlurTest::testCacheReusedForOwnDamage()
+{
+    // This test verifies that the blurred background of a window is reused if only the window
+    // itself gets repainted, and that it is blurred again once the window underneath changes
+    QSignalSpy clientAddedSpy(workspace(), &Workspace::internalClientAdded);
+    QVERIFY(clientAddedSpy.isValid());
+
+    HelperWindow background(Qt::red);
+    background.setGeometry(0, 0, 400, 400);
+    background.show();
+    QTRY_COMPARE(clientAddedSpy.count(), 1);
+
+    HelperWindow blurred(QColor(0, 0, 255, 128));
+    blurred.setProperty("kwin_blur", QRegion(0, 0, 200, 200));
+    blurred.setGeometry(100, 100, 200, 200);
+    blurred.show();
+    QTRY_COMPARE(clientAddedSpy.count(), 2);
+    InternalClient *blurredClient = clientAddedSpy.last().first().value<InternalClient *>();
+    QVERIFY(blurredClient);
+    QVERIFY(blurredClient->hasAlpha());
+
+    QTRY_VERIFY(blurStatistics().blurred > 0);
+    waitForIdle();
+
+    // only the blurred window changes, nothing underneath it does
+    BlurStatistics before = blurStatistics();
+    QSignalSpy damagedSpy(blurredClient, &Toplevel::damaged);
+    QVERIFY(damagedSpy.isValid());
+    blurred.setColor(QColor(0, 255, 0, 128));
+    QVERIFY(damagedSpy.wait());
+    QTRY_VERIFY(blurStatistics().cached > before.cached);
+    waitForIdle();
+    QCOMPARE(blurStatistics().blurred, before.blurred);
+
+    // the window underneath changes, the background has to be blurred again
+    before = blurStatistics();
+    background.setColor(Qt::yellow);
+    QTRY_VERIFY(blurStatistics().blurred > before.blurred);
+}
+
+void BlurTest::testOnlyBlurredWindowsArePainted()
+{
+    // This test verifies that the blur effect, although it is always active, only takes part
+    // in painting the windows it blurs, so all other windows can be batched by the scene
+    QSignalSpy clientAddedSpy(workspace(), &Workspace::internalClientAdded);
+    QVERIFY(clientAddedSpy.isValid());
+
+    HelperWindow plain(Qt::red);
+    plain.setGeometry(0, 0, 100, 100);
+    plain.show();
+    QTRY_COMPARE(clientAddedSpy.count(), 1);
+    InternalClient *plainClient = clientAddedSpy.last().first().value<InternalClient *>();
+    QVERIFY(plainClient);
+
+    HelperWindow translucent(QColor(0, 0, 255, 128));
+    translucent.setGeometry(200, 0, 100, 100);
+    translucent.show();
+    QTRY_COMPARE(clientAddedSpy.count(), 2);
+    InternalClient *translucentClient = clientAddedSpy.last().first().value<InternalClient *>();
+    QVERIFY(translucentClient);
+    QVERIFY(translucentClient->hasAlpha());
+
+    HelperWindow blurred(QColor(0, 0, 255, 128));
+    blurred.setProperty("kwin_blur", QRegion(0, 0, 100, 100));
+    blurred.setGeometry(400, 0, 100, 100);
+    blurred.show();
+    QTRY_COMPARE(clientAddedSpy.count(), 3);
+    InternalClient *blurredClient = clientAddedSpy.last().first().value<InternalClient *>();
+    QVERIFY(blurredClient);
+
+    QTRY_VERIFY(blurStatistics().blurred > 0);
+    waitForIdle();
+
+    EffectsHandlerImpl *e = static_cast<EffectsHandlerImpl *>(effects);
+    QVERIFY(m_blur->isActive());
+    QVERIFY(m_blur->prePaintsAllWindows());
+    QVERIFY(!m_blur->isActiveForWindow(plainClient->effectWindow()));
+    QVERIFY(!m_blur->isActiveForWindow(translucentClient->effectWindow()));
+    QVERIFY(m_blur->isActiveForWindow(blurredClient->effectWindow()));
+    QVERIFY(!e->hasEffectsForWindow(plainClient->effectWindow()));
+    QVERIFY(!e->hasEffectsForWindow(translucentClient->effectWindow()));
+    QVERIFY(e->hasEffectsForWindow(blurredClient->effectWindow()));
+}
+
+void BlurTest::testOccludedWindowSkipped()
+{
+    // This test verifies that a window completely hidden below an opaque window is skipped
+    // while the blur effect, which is active all the time, is loaded
+    QScopedPointer<KWayland::Client::Surface> hiddenSurface(Test::createSurface());
+    QScopedPointer<Test::XdgToplevel> hiddenShellSurface(Test::createXdgToplevelSurface(hiddenSurface.data()));
+    AbstractClient *hidden = Test::renderAndWaitForShown(hiddenSurface.data(), QSize(200, 200), Qt::red, QImage::Format_RGB32);
+    QVERIFY(hidden);
+    QVERIFY(!hidden->hasAlpha());
+    hidden->move(QPoint(0, 0));
+
+    QScopedPointer<KWayland::Client::Surface> coverSurface(Test::createSurface());
+    QScopedPointer<Test::XdgToplevel> coverShellSurface(Test::createXdgToplevelSurface(coverSurface.data()));
+    AbstractClient *cover = Test::renderAndWaitForShown(coverSurface.data(), QSize(200, 200), Qt::blue, QImage::Format_RGB32);
+    QVERIFY(cover);
+    QVERIFY(!cover->hasAlpha());
+    cover->move(QPoint(0, 0));
+    QCOMPARE(workspace()->stackingOrder().last(), cover);
+    waitForIdle();
+
+    QVERIFY(m_blur->isActive());
+    EffectsHandlerImpl *e = static_cast<EffectsHandlerImpl *>(effects);
+    QVERIFY(!e->hasEffectsForWindow(hidden->effectWindow()));
+    QVERIFY(!e->hasEffectsForWindow(cover->effectWindow()));
+
+    // repaint the covering window, the hidden one is skipped
+    Scene *scene = Compositor::self()->scene();
+    QSignalSpy frameRenderedSpy(scene, &Scene::frameRendered);
+    QVERIFY(frameRenderedSpy.isValid());
+    Test::render(coverSurface.data(), QSize(200, 200), Qt::green, QImage::Format_RGB32);
+    QVERIFY(frameRenderedSpy.wait());
+    QCOMPARE(scene->occludedWindowCount(), 1);
+
+    // once the covering window moves away, the other window is painted again
+    cover->move(QPoint(400, 0));
+    QVERIFY(frameRenderedSpy.wait());
+    QTRY_COMPARE(scene->occludedWindowCount(), 0);
+
+    coverShellSurface.reset();
+    QVERIFY(Test::waitForWindowDestroyed(cover));
+    hiddenShellSurface.reset();
+    QVERIFY(Test::waitForWindowDestroyed(hidden));
+}
+
+WAYLANDTEST_MAIN(BlurTest)
+#include "blur_test.moc"
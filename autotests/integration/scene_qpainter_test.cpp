@@ -22,6 +22,7 @@
 #include <KWayland/Client/seat.h>
 #include <KWayland/Client/surface.h>
 #include <KWayland/Client/pointer.h>
+#include <KWayland/Client/shm_pool.h>
 #include <KWaylandServer/buffer_interface.h>
 #include <KWaylandServer/surface_interface.h>
 
@@ -43,7 +44,11 @@ private Q_SLOTS:
     void testCursorMoving();
     void testWindow();
     void testWindowScaled();
+    void testWindowDamage();
+    void benchmarkWindowDamage_data();
+    void benchmarkWindowDamage();
     void testCompositorRestart();
+    void testTiledRendering();
     void testX11Window();
 };
 
@@ -233,6 +238,88 @@ void SceneQPainterTest::testWindowScaled()
     QCOMPARE(referenceImage, *scene->qpainterRenderBuffer());
 }
 
+void SceneQPainterTest::testWindowDamage()
+{
+    // this test verifies that only the damaged parts of a new shm buffer are taken over
+    KWin::Cursors::self()->mouse()->setPos(1200, 1000);
+    using namespace KWayland::Client;
+    QVERIFY(Test::setupWaylandConnection());
+    QScopedPointer<Surface> s(Test::createSurface());
+    QScopedPointer<XdgShellSurface> ss(Test::createXdgShellStableSurface(s.data()));
+    AbstractClient *client = Test::renderAndWaitForShown(s.data(), QSize(200, 300), Qt::blue);
+    QVERIFY(client);
+
+    auto scene = KWin::Compositor::self()->scene();
+    QVERIFY(scene);
+    QSignalSpy frameRenderedSpy(scene, &Scene::frameRendered);
+    QVERIFY(frameRenderedSpy.isValid());
+
+    // attach a completely red buffer, but damage only a small part of it
+    QImage img(QSize(200, 300), QImage::Format_ARGB32_Premultiplied);
+    img.fill(Qt::red);
+    s->attachBuffer(Test::waylandShmPool()->createBuffer(img));
+    s->damage(QRect(10, 20, 30, 40));
+    s->commit(Surface::CommitFlag::None);
+    QVERIFY(frameRenderedSpy.wait());
+
+    QImage referenceImage(QSize(200, 300), QImage::Format_RGB32);
+    referenceImage.fill(Qt::blue);
+    QPainter painter(&referenceImage);
+    painter.fillRect(10, 20, 30, 40, Qt::red);
+    QCOMPARE(scene->qpainterRenderBuffer()->copy(client->frameGeometry()), referenceImage);
+
+    // a buffer of a different size is taken over completely
+    img = QImage(QSize(100, 100), QImage::Format_ARGB32_Premultiplied);
+    img.fill(Qt::green);
+    s->attachBuffer(Test::waylandShmPool()->createBuffer(img));
+    s->damage(QRect(0, 0, 10, 10));
+    s->commit(Surface::CommitFlag::None);
+    QVERIFY(frameRenderedSpy.wait());
+
+    referenceImage = QImage(QSize(100, 100), QImage::Format_RGB32);
+    referenceImage.fill(Qt::green);
+    QCOMPARE(scene->qpainterRenderBuffer()->copy(QRect(client->pos(), QSize(100, 100))), referenceImage);
+}
+
+void SceneQPainterTest::benchmarkWindowDamage_data()
+{
+    QTest::addColumn<QSize>("size");
+
+    QTest::newRow("200x300") << QSize(200, 300);
+    QTest::newRow("640x480") << QSize(640, 480);
+    QTest::newRow("1280x1024") << QSize(1280, 1024);
+}
+
+void SceneQPainterTest::benchmarkWindowDamage()
+{
+    // this benchmark measures commits of a new shm buffer with little damage
+    KWin::Cursors::self()->mouse()->setPos(1200, 1000);
+    using namespace KWayland::Client;
+    QVERIFY(Test::setupWaylandConnection());
+    QScopedPointer<Surface> s(Test::createSurface());
+    QScopedPointer<XdgShellSurface> ss(Test::createXdgShellStableSurface(s.data()));
+    QFETCH(QSize, size);
+    QVERIFY(Test::renderAndWaitForShown(s.data(), size, Qt::blue));
+
+    auto scene = KWin::Compositor::self()->scene();
+    QVERIFY(scene);
+    QSignalSpy frameRenderedSpy(scene, &Scene::frameRendered);
+    QVERIFY(frameRenderedSpy.isValid());
+
+    QImage img(size, QImage::Format_ARGB32_Premultiplied);
+    img.fill(Qt::blue);
+    int frame = 0;
+    QBENCHMARK {
+        const QRect damage(frame % (size.width() - 10), frame % (size.height() - 10), 10, 10);
+        img.setPixel(damage.topLeft(), qRgb(frame % 256, 0, 0));
+        s->attachBuffer(Test::waylandShmPool()->createBuffer(img));
+        s->damage(damage);
+        s->commit(Surface::CommitFlag::None);
+        QVERIFY(frameRenderedSpy.wait());
+        frame++;
+    }
+}
+
 void SceneQPainterTest::testCompositorRestart()
 {
     // this test verifies that the compositor/SceneQPainter survive a restart of the compositor and still render correctly
@@ -277,6 +364,100 @@ void SceneQPainterTest::testCompositorRestart()
     QCOMPARE(referenceImage, *scene->qpainterRenderBuffer());
 }
 
+void SceneQPainterTest::testTiledRendering()
+{
+    // this test verifies that the tile-parallel rendering gives the same result as the serial one
+    KWin::Cursors::self()->mouse()->setPos(400, 400);
+
+    using namespace KWayland::Client;
+    QVERIFY(Test::setupWaylandConnection());
+
+    // a plain window
+    QScopedPointer<Surface> s1(Test::createSurface());
+    QScopedPointer<XdgShellSurface> ss1(Test::createXdgShellStableSurface(s1.data()));
+    AbstractClient *c1 = Test::renderAndWaitForShown(s1.data(), QSize(200, 300), Qt::blue);
+    QVERIFY(c1);
+    c1->move(QPoint(30, 50));
+
+    // a window with a gradient overlapping the first one and crossing several tiles
+    QImage gradient(QSize(500, 400), QImage::Format_ARGB32_Premultiplied);
+    for (int y = 0; y < gradient.height(); ++y) {
+        for (int x = 0; x < gradient.width(); ++x) {
+            gradient.setPixel(x, y, qRgb(x % 256, y % 256, (x + y) % 256));
+        }
+    }
+    QScopedPointer<Surface> s2(Test::createSurface());
+    QScopedPointer<XdgShellSurface> ss2(Test::createXdgShellStableSurface(s2.data()));
+    AbstractClient *c2 = Test::renderAndWaitForShown(s2.data(), gradient.size(), Qt::red);
+    QVERIFY(c2);
+    QSignalSpy damaged2Spy(c2, &Toplevel::damaged);
+    QVERIFY(damaged2Spy.isValid());
+    Test::render(s2.data(), gradient);
+    QVERIFY(damaged2Spy.wait());
+    c2->move(QPoint(150, 170));
+
+    // a scaled window
+    QScopedPointer<Surface> s3(Test::createSurface());
+    QScopedPointer<XdgShellSurface> ss3(Test::createXdgShellStableSurface(s3.data()));
+    s3->setScale(2);
+    QImage scaled(QSize(300, 200), QImage::Format_ARGB32_Premultiplied);
+    scaled.fill(Qt::green);
+    QPainter scaledPainter(&scaled);
+    scaledPainter.fillRect(101, 51, 97, 77, Qt::yellow);
+    scaledPainter.end();
+    AbstractClient *c3 = Test::renderAndWaitForShown(s3.data(), scaled.size(), Qt::green);
+    QVERIFY(c3);
+    QSignalSpy damaged3Spy(c3, &Toplevel::damaged);
+    QVERIFY(damaged3Spy.isValid());
+    Test::render(s3.data(), scaled);
+    QVERIFY(damaged3Spy.wait());
+    c3->move(QPoint(700, 600));
+
+    // render the scene serially
+    auto scene = KWin::Compositor::self()->scene();
+    QVERIFY(scene);
+    QSignalSpy frameRenderedSpy(scene, &Scene::frameRendered);
+    QVERIFY(frameRenderedSpy.isValid());
+    KWin::Compositor::self()->addRepaintFull();
+    QVERIFY(frameRenderedSpy.wait());
+    const QImage serialImage = scene->qpainterRenderBuffer()->copy();
+
+    // now switch to tiled rendering
+    qputenv("KWIN_QPAINTER_TILED", QByteArrayLiteral("1"));
+    QSignalSpy sceneCreatedSpy(KWin::Compositor::self(), &KWin::Compositor::sceneCreated);
+    QVERIFY(sceneCreatedSpy.isValid());
+    KWin::Compositor::self()->reinitialize();
+    if (sceneCreatedSpy.isEmpty()) {
+        QVERIFY(sceneCreatedSpy.wait());
+    }
+    scene = KWin::Compositor::self()->scene();
+    QVERIFY(scene);
+    QSignalSpy tiledFrameRenderedSpy(scene, &Scene::frameRendered);
+    QVERIFY(tiledFrameRenderedSpy.isValid());
+    KWin::Compositor::self()->addRepaintFull();
+    QVERIFY(tiledFrameRenderedSpy.wait());
+    QCOMPARE(*scene->qpainterRenderBuffer(), serialImage);
+
+    // a partial update is rendered the same way as well
+    c2->move(QPoint(400, 100));
+    QVERIFY(tiledFrameRenderedSpy.wait());
+    const QImage tiledImage = scene->qpainterRenderBuffer()->copy();
+
+    qunsetenv("KWIN_QPAINTER_TILED");
+    sceneCreatedSpy.clear();
+    KWin::Compositor::self()->reinitialize();
+    if (sceneCreatedSpy.isEmpty()) {
+        QVERIFY(sceneCreatedSpy.wait());
+    }
+    scene = KWin::Compositor::self()->scene();
+    QVERIFY(scene);
+    QSignalSpy serialFrameRenderedSpy(scene, &Scene::frameRendered);
+    QVERIFY(serialFrameRenderedSpy.isValid());
+    KWin::Compositor::self()->addRepaintFull();
+    QVERIFY(serialFrameRenderedSpy.wait());
+    QCOMPARE(*scene->qpainterRenderBuffer(), tiledImage);
+}
+
 struct XcbConnectionDeleter
 {
     static inline void cleanup(xcb_connection_t *pointer)
@@ -0,0 +1,136 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2020 KWin developers <kwin@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "kwin_wayland_test.h"
+#include "x11client.h"
+#include "composite.h"
+#include "main.h"
+#include "platform.h"
+#include "screens.h"
+#include "virtualdesktops.h"
+#include "wayland_server.h"
+#include "workspace.h"
+#include "xcbutils.h"
+
+#include <netwm.h>
+#include <xcb/xcb_icccm.h>
+
+using namespace KWin;
+static const QString s_socketName = QStringLiteral("wayland_test_x11_desktop_switch-0");
+
+static const int s_windowCount = 200;
+
+struct XcbConnectionDeleter
+{
+    static inline void cleanup(xcb_connection_t *pointer)
+    {
+        xcb_disconnect(pointer);
+    }
+};
+
+class X11DesktopSwitchTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void testSwitchVisibility();
+    void benchmarkSwitch();
+
+private:
+    QScopedPointer<xcb_connection_t, XcbConnectionDeleter> m_connection;
+    QVector<X11Client *> m_clients;
+};
+
+void X11DesktopSwitchTest::initTestCase()
+{
+    qRegisterMetaType<KWin::AbstractClient *>();
+    qRegisterMetaType<KWin::X11Client *>();
+    QSignalSpy applicationStartedSpy(kwinApp(), &Application::started);
+    QVERIFY(applicationStartedSpy.isValid());
+    kwinApp()->platform()->setInitialWindowSize(QSize(1280, 1024));
+    QVERIFY(waylandServer()->init(s_socketName.toLocal8Bit()));
+    kwinApp()->setConfig(KSharedConfig::openConfig(QString(), KConfig::SimpleConfig));
+
+    kwinApp()->start();
+    QVERIFY(applicationStartedSpy.wait());
+    QVERIFY(KWin::Compositor::self());
+    waylandServer()->initWorkspace();
+
+    VirtualDesktopManager::self()->setCount(2);
+    VirtualDesktopManager::self()->setCurrent(1);
+
+    // Create the windows, every second one goes to the second desktop
+    QSignalSpy clientAddedSpy(workspace(), &Workspace::clientAdded);
+    QVERIFY(clientAddedSpy.isValid());
+    m_connection.reset(xcb_connect(nullptr, nullptr));
+    QVERIFY(!xcb_connection_has_error(m_connection.data()));
+    for (int i = 0; i < s_windowCount; ++i) {
+        const QRect windowGeometry(i % 10 * 100, i / 10 * 40, 100, 100);
+        xcb_window_t w = xcb_generate_id(m_connection.data());
+        xcb_create_window(m_connection.data(), XCB_COPY_FROM_PARENT, w, rootWindow(),
+                          windowGeometry.x(),
+                          windowGeometry.y(),
+                          windowGeometry.width(),
+                          windowGeometry.height(),
+                          0, XCB_WINDOW_CLASS_INPUT_OUTPUT, XCB_COPY_FROM_PARENT, 0, nullptr);
+        xcb_size_hints_t hints;
+        memset(&hints, 0, sizeof(hints));
+        xcb_icccm_size_hints_set_position(&hints, 1, windowGeometry.x(), windowGeometry.y());
+        xcb_icccm_size_hints_set_size(&hints, 1, windowGeometry.width(), windowGeometry.height());
+        xcb_icccm_set_wm_normal_hints(m_connection.data(), w, &hints);
+        xcb_map_window(m_connection.data(), w);
+    }
+    xcb_flush(m_connection.data());
+
+    QTRY_COMPARE_WITH_TIMEOUT(clientAddedSpy.count(), s_windowCount, 30000);
+    for (int i = 0; i < s_windowCount; ++i) {
+        X11Client *client = clientAddedSpy.at(i).first().value<X11Client *>();
+        QVERIFY(client);
+        client->setDesktop(i % 2 + 1);
+        m_clients << client;
+    }
+}
+
+void X11DesktopSwitchTest::cleanupTestCase()
+{
+    m_clients.clear();
+    m_connection.reset();
+}
+
+void X11DesktopSwitchTest::testSwitchVisibility()
+{
+    // This test verifies that all windows follow a desktop switch and that the windows
+    // which are merely on another desktop are not marked as hidden
+    for (uint desktop : {2u, 1u}) {
+        VirtualDesktopManager::self()->setCurrent(desktop);
+        QCOMPARE(VirtualDesktopManager::self()->current(), desktop);
+        Xcb::sync();
+
+        for (X11Client *client : qAsConst(m_clients)) {
+            QCOMPARE(client->isOnCurrentDesktop(), client->desktop() == int(desktop));
+            NETWinInfo info(kwinApp()->x11Connection(), client->window(), kwinApp()->x11RootWindow(),
+                            NET::WMState, NET::Properties2());
+            QVERIFY(!(info.state() & NET::Hidden));
+        }
+    }
+}
+
+void X11DesktopSwitchTest::benchmarkSwitch()
+{
+    // The latency includes the X server processing all requests of the switch
+    QBENCHMARK {
+        VirtualDesktopManager::self()->setCurrent(2);
+        Xcb::sync();
+        VirtualDesktopManager::self()->setCurrent(1);
+        Xcb::sync();
+    }
+}
+
+WAYLANDTEST_MAIN(X11DesktopSwitchTest)
+#include "x11_desktop_switch_test.moc"
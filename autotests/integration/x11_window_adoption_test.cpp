@@ -0,0 +1,163 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2020 KWin developers <kwin@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "kwin_wayland_test.h"
+#include "composite.h"
+#include "platform.h"
+#include "wayland_server.h"
+#include "workspace.h"
+#include "x11client.h"
+
+#include <xcb/xcb.h>
+
+#include <memory>
+#include <vector>
+
+static const QString s_socketName = QStringLiteral("wayland_test_x11_window_adoption-0");
+static const int s_windowCount = 300;
+
+namespace KWin
+{
+
+struct XcbConnectionDeleter
+{
+    static inline void cleanup(xcb_connection_t *pointer)
+    {
+        xcb_disconnect(pointer);
+    }
+};
+
+/**
+ * Adopts a batch of existing X11 windows the way Workspace::initializeX11() does at startup,
+ * once with the requests of all windows sent up front and once window by window.
+ */
+class X11WindowAdoptionTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+    void testAdoptWindows();
+    void benchmarkSequential();
+    void benchmarkBatched();
+
+private:
+    void releaseClients(const QVector<X11Client *> &clients);
+
+    QScopedPointer<xcb_connection_t, XcbConnectionDeleter> m_connection;
+    std::vector<xcb_window_t> m_windows;
+};
+
+void X11WindowAdoptionTest::initTestCase()
+{
+    qRegisterMetaType<KWin::AbstractClient *>();
+    QSignalSpy applicationStartedSpy(kwinApp(), &Application::started);
+    QVERIFY(applicationStartedSpy.isValid());
+    kwinApp()->platform()->setInitialWindowSize(QSize(1280, 1024));
+    QVERIFY(waylandServer()->init(s_socketName.toLocal8Bit()));
+    kwinApp()->setConfig(KSharedConfig::openConfig(QString(), KConfig::SimpleConfig));
+
+    kwinApp()->start();
+    QVERIFY(applicationStartedSpy.wait());
+    QVERIFY(Compositor::self());
+    waylandServer()->initWorkspace();
+}
+
+void X11WindowAdoptionTest::init()
+{
+    m_connection.reset(xcb_connect(nullptr, nullptr));
+    QVERIFY(!xcb_connection_has_error(m_connection.data()));
+
+    // the windows are never mapped by the test, so KWin doesn't manage them on its own
+    for (int i = 0; i < s_windowCount; ++i) {
+        const xcb_window_t window = xcb_generate_id(m_connection.data());
+        xcb_create_window(m_connection.data(), XCB_COPY_FROM_PARENT, window, rootWindow(),
+                          0, 0, 100, 100, 0, XCB_WINDOW_CLASS_INPUT_OUTPUT, XCB_COPY_FROM_PARENT, 0, nullptr);
+        const QByteArray name = QByteArrayLiteral("window ") + QByteArray::number(i);
+        xcb_change_property(m_connection.data(), XCB_PROP_MODE_REPLACE, window,
+                            XCB_ATOM_WM_NAME, XCB_ATOM_STRING, 8, name.length(), name.constData());
+        m_windows.push_back(window);
+    }
+    // make sure the windows exist before KWin queries them
+    free(xcb_get_input_focus_reply(m_connection.data(), xcb_get_input_focus(m_connection.data()), nullptr));
+}
+
+void X11WindowAdoptionTest::cleanup()
+{
+    m_windows.clear();
+    m_connection.reset();
+}
+
+void X11WindowAdoptionTest::releaseClients(const QVector<X11Client *> &clients)
+{
+    for (X11Client *client : clients) {
+        client->releaseWindow();
+    }
+    xcb_flush(connection());
+}
+
+void X11WindowAdoptionTest::testAdoptWindows()
+{
+    std::vector<std::unique_ptr<X11ClientRequests>> requests;
+    requests.reserve(m_windows.size());
+    for (xcb_window_t window : m_windows) {
+        requests.emplace_back(new X11ClientRequests(window));
+    }
+
+    QVector<X11Client *> clients;
+    for (size_t i = 0; i < requests.size(); ++i) {
+        X11Client *client = workspace()->createClient(*requests[i], false);
+        QVERIFY(client);
+        clients << client;
+        QCOMPARE(client->window(), m_windows[i]);
+        QCOMPARE(client->clientSize(), QSize(100, 100));
+        QCOMPARE(client->caption(), QStringLiteral("window %1").arg(i));
+    }
+    QCOMPARE(workspace()->clientList().count(), s_windowCount);
+
+    releaseClients(clients);
+    QVERIFY(workspace()->clientList().isEmpty());
+}
+
+void X11WindowAdoptionTest::benchmarkSequential()
+{
+    // every window waits for the replies to its requests before the next one is queried
+    QBENCHMARK {
+        QVector<X11Client *> clients;
+        for (xcb_window_t window : m_windows) {
+            X11Client *client = workspace()->createClient(window, false);
+            QVERIFY(client);
+            clients << client;
+        }
+        releaseClients(clients);
+    }
+}
+
+void X11WindowAdoptionTest::benchmarkBatched()
+{
+    QBENCHMARK {
+        std::vector<std::unique_ptr<X11ClientRequests>> requests;
+        requests.reserve(m_windows.size());
+        for (xcb_window_t window : m_windows) {
+            requests.emplace_back(new X11ClientRequests(window));
+        }
+        QVector<X11Client *> clients;
+        for (const auto &request : requests) {
+            X11Client *client = workspace()->createClient(*request, false);
+            QVERIFY(client);
+            clients << client;
+        }
+        releaseClients(clients);
+    }
+}
+
+}
+
+WAYLANDTEST_MAIN(KWin::X11WindowAdoptionTest)
+#include "x11_window_adoption_test.moc"
@@ -131,6 +131,9 @@ private Q_SLOTS:
     void testInactiveOpacityForceTemporarily();
 
     void testMatchAfterNameChange();
+
+    void benchmarkFind_data();
+    void benchmarkFind();
 };
 
 void TestXdgShellClientRules::initTestCase()
@@ -4212,5 +4215,63 @@ void TestXdgShellClientRules::testMatchAfterNameChange()
     QCOMPARE(c->keepAbove(), true);
 }
 
+void TestXdgShellClientRules::benchmarkFind_data()
+{
+    QTest::addColumn<int>("ruleCount");
+
+    QTest::newRow("10 rules") << 10;
+    QTest::newRow("100 rules") << 100;
+    QTest::newRow("1000 rules") << 1000;
+}
+
+void TestXdgShellClientRules::benchmarkFind()
+{
+    QFETCH(int, ruleCount);
+
+    // A synthetic rule book with a mix of exact, substring and regexp matches, mostly for
+    // other applications, and a few title matches, like a big hand written rule book.
+    KSharedConfig::Ptr config = KSharedConfig::openConfig(QString(), KConfig::SimpleConfig);
+    config->group("General").writeEntry("count", ruleCount);
+    for (int i = 0; i < ruleCount; ++i) {
+        KConfigGroup group = config->group(QString::number(i + 1));
+        group.writeEntry("above", true);
+        group.writeEntry("aboverule", int(Rules::DontAffect));
+        group.writeEntry("wmclasscomplete", false);
+        switch (i % 4) {
+        case 0:
+            group.writeEntry("wmclass", QStringLiteral("org.kde.app%1").arg(i));
+            group.writeEntry("wmclassmatch", int(Rules::ExactMatch));
+            break;
+        case 1:
+            group.writeEntry("wmclass", QStringLiteral("app%1").arg(i));
+            group.writeEntry("wmclassmatch", int(Rules::SubstringMatch));
+            break;
+        case 2:
+            group.writeEntry("wmclass", QStringLiteral("^org\\.kde\\.(app|tool)%1$").arg(i));
+            group.writeEntry("wmclassmatch", int(Rules::RegExpMatch));
+            break;
+        case 3:
+            group.writeEntry("wmclass", QStringLiteral("org.kde.foo"));
+            group.writeEntry("wmclassmatch", int(Rules::ExactMatch));
+            group.writeEntry("title", QStringLiteral("^Document %1 .*$").arg(i));
+            group.writeEntry("titlematch", int(Rules::RegExpMatch));
+            break;
+        }
+    }
+    config->sync();
+    RuleBook::self()->setConfig(config);
+    workspace()->slotReconfigure();
+
+    QScopedPointer<Surface> surface(Test::createSurface());
+    QScopedPointer<XdgShellSurface> shellSurface(Test::createXdgShellStableSurface(surface.data()));
+    shellSurface->setAppId(QByteArrayLiteral("org.kde.foo"));
+    AbstractClient *client = Test::renderAndWaitForShown(surface.data(), QSize(100, 50), Qt::blue);
+    QVERIFY(client);
+
+    QBENCHMARK {
+        RuleBook::self()->find(client, false);
+    }
+}
+
 WAYLANDTEST_MAIN(TestXdgShellClientRules)
 #include "xdgshellclient_rules_test.moc"
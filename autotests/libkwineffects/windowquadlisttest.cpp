@@ -7,6 +7,7 @@
     SPDX-License-Identifier: GPL-2.0-or-later
 */
 #include <kwineffects.h>
+#include <QMatrix4x4>
 #include <QTest>
 
 Q_DECLARE_METATYPE(KWin::WindowQuadList)
@@ -19,9 +20,13 @@ private Q_SLOTS:
     void testMakeGrid();
     void testMakeRegularGrid_data();
     void testMakeRegularGrid();
+    void benchmarkMakeGrid();
+    void benchmarkMakeRegularGrid();
+    void benchmarkMakeInterleavedArrays();
 
 private:
     KWin::WindowQuad makeQuad(const QRectF &rect);
+    KWin::WindowQuadList makeWindow();
 };
 
 KWin::WindowQuad WindowQuadListTest::makeQuad(const QRectF &r)
@@ -34,6 +39,18 @@ KWin::WindowQuad WindowQuadListTest::makeQuad(const QRectF &r)
     return quad;
 }
 
+KWin::WindowQuadList WindowQuadListTest::makeWindow()
+{
+    // a decorated 800x600 window
+    KWin::WindowQuadList quads;
+    quads << makeQuad(QRectF(0, 0, 800, 30));
+    quads << makeQuad(QRectF(0, 30, 4, 566));
+    quads << makeQuad(QRectF(796, 30, 4, 566));
+    quads << makeQuad(QRectF(0, 596, 800, 4));
+    quads << makeQuad(QRectF(4, 30, 792, 566));
+    return quads;
+}
+
 void WindowQuadListTest::testMakeGrid_data()
 {
     QTest::addColumn<KWin::WindowQuadList>("orig");
@@ -205,6 +222,38 @@ void WindowQuadListTest::testMakeRegularGrid()
     }
 }
 
+void WindowQuadListTest::benchmarkMakeGrid()
+{
+    const KWin::WindowQuadList quads = makeWindow();
+    QBENCHMARK {
+        const KWin::WindowQuadList grid = quads.makeGrid(40);
+        QVERIFY(!grid.isEmpty());
+    }
+}
+
+void WindowQuadListTest::benchmarkMakeRegularGrid()
+{
+    const KWin::WindowQuadList quads = makeWindow();
+    QBENCHMARK {
+        const KWin::WindowQuadList grid = quads.makeRegularGrid(20, 20);
+        QVERIFY(!grid.isEmpty());
+    }
+}
+
+void WindowQuadListTest::benchmarkMakeInterleavedArrays()
+{
+    const KWin::WindowQuadList grid = makeWindow().makeRegularGrid(20, 20);
+    QMatrix4x4 matrix;
+    matrix.scale(1.0 / 800, 1.0 / 600);
+
+    // as the scene fills the mapped streaming buffer, with two triangles per quad
+    QVector<KWin::GLVertex2D> vertices(grid.count() * 6);
+    QBENCHMARK {
+        grid.makeInterleavedArrays(0x0004, vertices.data(), matrix);
+    }
+    QCOMPARE(vertices.last().position, QVector2D(grid.last()[1].x(), grid.last()[1].y()));
+}
+
 QTEST_MAIN(WindowQuadListTest)
 
 #include "windowquadlisttest.moc"
@@ -0,0 +1,142 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2020 KWin developers <kwin@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "../plugins/scenes/opengl/atlasallocator.h"
+
+#include <QRandomGenerator>
+#include <QtTest>
+
+using namespace KWin;
+
+class TestAtlasAllocator : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testInvalidSizes();
+    void testSameHeightSharesShelf();
+    void testDifferentHeights();
+    void testFull();
+    void testReuse();
+    void testGrow();
+    void testRandomized();
+};
+
+void TestAtlasAllocator::testInvalidSizes()
+{
+    AtlasAllocator allocator(QSize(256, 256));
+    QVERIFY(!allocator.allocate(QSize()).isValid());
+    QVERIFY(!allocator.allocate(QSize(0, 10)).isValid());
+    QVERIFY(!allocator.allocate(QSize(257, 10)).isValid());
+    QVERIFY(allocator.isEmpty());
+}
+
+void TestAtlasAllocator::testSameHeightSharesShelf()
+{
+    AtlasAllocator allocator(QSize(256, 256));
+    QCOMPARE(allocator.allocate(QSize(100, 30)), QRect(0, 0, 100, 30));
+    QCOMPARE(allocator.allocate(QSize(100, 30)), QRect(100, 0, 100, 30));
+    // doesn't fit into the first shelf any more
+    QCOMPARE(allocator.allocate(QSize(100, 30)), QRect(0, 32, 100, 30));
+    // smaller parts may go into a bit higher shelves
+    QCOMPARE(allocator.allocate(QSize(50, 25)), QRect(200, 0, 50, 25));
+    QVERIFY(!allocator.isEmpty());
+}
+
+void TestAtlasAllocator::testDifferentHeights()
+{
+    AtlasAllocator allocator(QSize(256, 256));
+    QCOMPARE(allocator.allocate(QSize(10, 64)), QRect(0, 0, 10, 64));
+    // too much waste in the first shelf
+    QCOMPARE(allocator.allocate(QSize(10, 8)), QRect(0, 64, 10, 8));
+    QCOMPARE(allocator.allocate(QSize(10, 60)), QRect(10, 0, 10, 60));
+}
+
+void TestAtlasAllocator::testFull()
+{
+    AtlasAllocator allocator(QSize(64, 64));
+    for (int i = 0; i < 4; ++i) {
+        QVERIFY(allocator.allocate(QSize(64, 16)).isValid());
+    }
+    QVERIFY(!allocator.allocate(QSize(1, 1)).isValid());
+}
+
+void TestAtlasAllocator::testReuse()
+{
+    AtlasAllocator allocator(QSize(64, 64));
+    const QRect a = allocator.allocate(QSize(32, 16));
+    const QRect b = allocator.allocate(QSize(32, 16));
+    const QRect c = allocator.allocate(QSize(64, 16));
+    const QRect d = allocator.allocate(QSize(64, 16));
+    QVERIFY(a.isValid() && b.isValid() && c.isValid() && d.isValid());
+
+    // the spans of a and b are merged again
+    allocator.deallocate(a);
+    allocator.deallocate(b);
+    QCOMPARE(allocator.allocate(QSize(64, 16)), QRect(0, 0, 64, 16));
+
+    // the empty shelves of c and d at the bottom are closed, so the space can be used
+    // for a higher allocation
+    allocator.deallocate(c);
+    allocator.deallocate(d);
+    QCOMPARE(allocator.allocate(QSize(64, 48)), QRect(0, 16, 64, 48));
+
+    allocator.deallocate(QRect(0, 16, 64, 48));
+    allocator.deallocate(QRect(0, 0, 64, 16));
+    QVERIFY(allocator.isEmpty());
+}
+
+void TestAtlasAllocator::testGrow()
+{
+    AtlasAllocator allocator(QSize(64, 16));
+    QVERIFY(allocator.allocate(QSize(64, 16)).isValid());
+    QVERIFY(!allocator.allocate(QSize(64, 16)).isValid());
+
+    allocator.grow(32);
+    QCOMPARE(allocator.size(), QSize(64, 32));
+    QCOMPARE(allocator.allocate(QSize(64, 16)), QRect(0, 16, 64, 16));
+
+    // never shrinks
+    allocator.grow(8);
+    QCOMPARE(allocator.size(), QSize(64, 32));
+}
+
+void TestAtlasAllocator::testRandomized()
+{
+    const QRect bounds(0, 0, 1024, 1024);
+    AtlasAllocator allocator(bounds.size());
+    QVector<QRect> allocated;
+
+    QRandomGenerator generator(4711);
+    for (int i = 0; i < 10000; ++i) {
+        if (!allocated.isEmpty() && generator.bounded(3) == 0) {
+            allocator.deallocate(allocated.takeAt(generator.bounded(allocated.count())));
+            continue;
+        }
+        // decoration like sizes, a couple of heights and all kinds of widths
+        const QSize size(generator.bounded(1, 1024), 16 + 8 * generator.bounded(4));
+        const QRect rect = allocator.allocate(size);
+        if (!rect.isValid()) {
+            continue;
+        }
+        QCOMPARE(rect.size(), size);
+        QVERIFY(bounds.contains(rect));
+        for (const QRect &other : qAsConst(allocated)) {
+            QVERIFY(!other.intersects(rect));
+        }
+        allocated << rect;
+    }
+
+    for (const QRect &rect : qAsConst(allocated)) {
+        allocator.deallocate(rect);
+    }
+    QVERIFY(allocator.isEmpty());
+    QCOMPARE(allocator.allocate(bounds.size()), bounds);
+}
+
+QTEST_GUILESS_MAIN(TestAtlasAllocator)
+#include "test_atlas_allocator.moc"
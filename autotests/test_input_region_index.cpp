@@ -0,0 +1,291 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2020 KWin developers <kwin@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "../inputregionindex.h"
+
+#include <QFile>
+#include <QRandomGenerator>
+#include <QtTest>
+
+using namespace KWin;
+
+static const QRect s_screen(0, 0, 3840, 2160);
+
+static QVector<QRect> generateWindows(int count)
+{
+    QRandomGenerator generator(count);
+    QVector<QRect> windows;
+    windows.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        if (i % 17 == 0) {
+            // maximized
+            windows << s_screen;
+            continue;
+        }
+        const QSize size(generator.bounded(100, 1600), generator.bounded(50, 1200));
+        // allow windows to stick out of the screen a bit
+        const QPoint pos(generator.bounded(-200, s_screen.width() - size.width() / 2),
+                         generator.bounded(-100, s_screen.height() - size.height() / 2));
+        windows << QRect(pos, size);
+    }
+    return windows;
+}
+
+/**
+ * Returns the pointer trace to replay. If KWIN_POINTER_TRACE points to a file with a
+ * "x y" pair per line, e.g. recorded with a debug print in PointerInputRedirection,
+ * that one is used. Otherwise a random walk of ten seconds at 1000 Hz is generated.
+ */
+static QVector<QPoint> pointerTrace()
+{
+    QVector<QPoint> trace;
+    const QString fileName = qEnvironmentVariable("KWIN_POINTER_TRACE");
+    if (!fileName.isEmpty()) {
+        QFile file(fileName);
+        if (file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            while (!file.atEnd()) {
+                const QList<QByteArray> coordinates = file.readLine().simplified().split(' ');
+                if (coordinates.count() == 2) {
+                    trace << QPoint(coordinates[0].toInt(), coordinates[1].toInt());
+                }
+            }
+        }
+        if (!trace.isEmpty()) {
+            return trace;
+        }
+        qWarning() << "Could not read pointer trace" << fileName;
+    }
+
+    QRandomGenerator generator(4711);
+    QPoint pos = s_screen.center();
+    for (int i = 0; i < 10000; ++i) {
+        pos += QPoint(generator.bounded(-12, 13), generator.bounded(-12, 13));
+        pos.setX(qBound(s_screen.left(), pos.x(), s_screen.right()));
+        pos.setY(qBound(s_screen.top(), pos.y(), s_screen.bottom()));
+        trace << pos;
+    }
+    return trace;
+}
+
+// stands in for windows on other desktops, minimized ones, etc.
+static bool accepted(int key)
+{
+    return key % 5 != 3;
+}
+
+static int findLinear(const QVector<QRect> &windows, const QPoint &pos)
+{
+    for (int i = windows.count() - 1; i >= 0; --i) {
+        if (windows[i].contains(pos) && accepted(i)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void fillIndex(InputRegionIndex &index, const QVector<QRect> &windows)
+{
+    for (int i = 0; i < windows.count(); ++i) {
+        index.insert(i, windows[i]);
+    }
+}
+
+class TestInputRegionIndex : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testEmpty();
+    void testStacking();
+    void testAccept();
+    void testNegativeCoordinates();
+    void testOversized();
+    void testRemove();
+    void testMatchesLinearScan_data();
+    void testMatchesLinearScan();
+    void testMatchesLinearScanAfterUpdates();
+    void benchmarkTrace_data();
+    void benchmarkTrace();
+};
+
+void TestInputRegionIndex::testEmpty()
+{
+    InputRegionIndex index;
+    QCOMPARE(index.find(QPoint(10, 10), accepted), -1);
+    QVERIFY(!index.rect(0).isValid());
+
+    index.insert(0, QRect());
+    QCOMPARE(index.find(QPoint(0, 0), accepted), -1);
+}
+
+void TestInputRegionIndex::testStacking()
+{
+    InputRegionIndex index;
+    index.insert(0, QRect(0, 0, 100, 100));
+    index.insert(1, QRect(50, 50, 100, 100));
+    index.insert(2, QRect(1000, 1000, 10, 10));
+
+    QCOMPARE(index.find(QPoint(10, 10), accepted), 0);
+    QCOMPARE(index.find(QPoint(60, 60), accepted), 1);
+    QCOMPARE(index.find(QPoint(149, 149), accepted), 1);
+    QCOMPARE(index.find(QPoint(150, 150), accepted), -1);
+    QCOMPARE(index.find(QPoint(1005, 1005), accepted), 2);
+    QCOMPARE(index.rect(1), QRect(50, 50, 100, 100));
+}
+
+void TestInputRegionIndex::testAccept()
+{
+    InputRegionIndex index;
+    index.insert(0, QRect(0, 0, 100, 100));
+    index.insert(1, QRect(0, 0, 100, 100));
+    index.insert(2, QRect(0, 0, 100, 100));
+
+    QVector<int> asked;
+    const int key = index.find(QPoint(10, 10), [&asked] (int key) {
+        asked << key;
+        return key == 0;
+    });
+    QCOMPARE(key, 0);
+    QCOMPARE(asked, (QVector<int>{2, 1, 0}));
+}
+
+void TestInputRegionIndex::testNegativeCoordinates()
+{
+    InputRegionIndex index;
+    index.insert(0, QRect(-300, -300, 200, 200));
+    index.insert(1, QRect(-1, -1, 2, 2));
+
+    QCOMPARE(index.find(QPoint(-200, -200), accepted), 0);
+    QCOMPARE(index.find(QPoint(-1, -1), accepted), 1);
+    QCOMPARE(index.find(QPoint(0, 0), accepted), 1);
+    QCOMPARE(index.find(QPoint(1, 1), accepted), -1);
+    QCOMPARE(index.find(QPoint(-99, -99), accepted), -1);
+}
+
+void TestInputRegionIndex::testOversized()
+{
+    const int size = InputRegionIndex::s_cellSize * 100;
+    InputRegionIndex index;
+    index.insert(0, QRect(-size, -size, 2 * size, 2 * size));
+    index.insert(1, QRect(0, 0, 100, 100));
+    index.insert(2, QRect(-size, -size, 2 * size, 2 * size));
+    index.insert(4, QRect(50, 50, 100, 100));
+
+    QCOMPARE(index.find(QPoint(60, 60), accepted), 4);
+    QCOMPARE(index.find(QPoint(10, 10), accepted), 2);
+    QCOMPARE(index.find(QPoint(10, 10), [] (int key) { return key != 2; }), 1);
+    QCOMPARE(index.find(QPoint(10, 10), [] (int key) { return key == 0; }), 0);
+
+    index.remove(2);
+    QCOMPARE(index.find(QPoint(10, 10), accepted), 1);
+    QCOMPARE(index.find(QPoint(-size, -size), accepted), 0);
+}
+
+void TestInputRegionIndex::testRemove()
+{
+    InputRegionIndex index;
+    index.insert(0, QRect(0, 0, 1000, 1000));
+    index.insert(1, QRect(0, 0, 1000, 1000));
+    QCOMPARE(index.find(QPoint(500, 500), accepted), 1);
+
+    index.remove(1);
+    QVERIFY(!index.rect(1).isValid());
+    QCOMPARE(index.find(QPoint(500, 500), accepted), 0);
+
+    // removing twice or unknown keys is harmless
+    index.remove(1);
+    index.remove(42);
+    QCOMPARE(index.find(QPoint(500, 500), accepted), 0);
+
+    index.clear();
+    QCOMPARE(index.find(QPoint(500, 500), accepted), -1);
+}
+
+void TestInputRegionIndex::testMatchesLinearScan_data()
+{
+    QTest::addColumn<int>("windowCount");
+
+    QTest::newRow("10") << 10;
+    QTest::newRow("100") << 100;
+    QTest::newRow("1000") << 1000;
+}
+
+void TestInputRegionIndex::testMatchesLinearScan()
+{
+    QFETCH(int, windowCount);
+    const QVector<QRect> windows = generateWindows(windowCount);
+    InputRegionIndex index;
+    fillIndex(index, windows);
+
+    for (const QPoint &pos : pointerTrace()) {
+        QCOMPARE(index.find(pos, accepted), findLinear(windows, pos));
+    }
+}
+
+void TestInputRegionIndex::testMatchesLinearScanAfterUpdates()
+{
+    QVector<QRect> windows = generateWindows(200);
+    InputRegionIndex index;
+    fillIndex(index, windows);
+
+    const QVector<QPoint> trace = pointerTrace();
+    QRandomGenerator generator(815);
+    for (int i = 0; i < trace.count(); ++i) {
+        if (i % 10 == 0) {
+            // interactively move or resize a window
+            const int key = generator.bounded(windows.count());
+            QRect &window = windows[key];
+            if (generator.bounded(2)) {
+                window.translate(generator.bounded(-50, 51), generator.bounded(-50, 51));
+            } else {
+                window.setSize(QSize(generator.bounded(1, 2000), generator.bounded(1, 2000)));
+            }
+            index.insert(key, window);
+        }
+        QCOMPARE(index.find(trace[i], accepted), findLinear(windows, trace[i]));
+    }
+}
+
+void TestInputRegionIndex::benchmarkTrace_data()
+{
+    QTest::addColumn<int>("windowCount");
+    QTest::addColumn<bool>("indexed");
+
+    for (int count : {10, 50, 200, 1000}) {
+        QTest::addRow("linear, %d windows", count) << count << false;
+        QTest::addRow("indexed, %d windows", count) << count << true;
+    }
+}
+
+void TestInputRegionIndex::benchmarkTrace()
+{
+    QFETCH(int, windowCount);
+    QFETCH(bool, indexed);
+    const QVector<QRect> windows = generateWindows(windowCount);
+    const QVector<QPoint> trace = pointerTrace();
+    InputRegionIndex index;
+    fillIndex(index, windows);
+
+    int found = 0;
+    if (indexed) {
+        QBENCHMARK {
+            for (const QPoint &pos : trace) {
+                found += index.find(pos, accepted);
+            }
+        }
+    } else {
+        QBENCHMARK {
+            for (const QPoint &pos : trace) {
+                found += findLinear(windows, pos);
+            }
+        }
+    }
+    QVERIFY(found != 0);
+}
+
+QTEST_GUILESS_MAIN(TestInputRegionIndex)
+#include "test_input_region_index.moc"
@@ -0,0 +1,134 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2020 KWin developers <kwin@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "../paintrecorder.h"
+
+#include <QPainter>
+#include <QPainterPath>
+#include <QtTest>
+
+#include <functional>
+
+using namespace KWin;
+
+using Painting = std::function<void(QPainter *)>;
+Q_DECLARE_METATYPE(Painting)
+
+class TestPaintRecorder : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testReplayMatchesDirectPainting_data();
+    void testReplayMatchesDirectPainting();
+    void testReplayRegion();
+};
+
+static QImage createImage()
+{
+    // taller than a few tiles of the replay and not a multiple of their height
+    QImage image(150, 230, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+    return image;
+}
+
+static QImage paintDirectly(const Painting &painting)
+{
+    QImage image = createImage();
+    QPainter painter(&image);
+    painting(&painter);
+    painter.end();
+    return image;
+}
+
+static QImage paintRecorded(const Painting &painting, const QRegion &region)
+{
+    QImage image = createImage();
+    PaintRecorder recorder;
+    recorder.setTarget(&image);
+    QPainter painter(&recorder);
+    painting(&painter);
+    painter.end();
+    recorder.replay(region);
+    return image;
+}
+
+void TestPaintRecorder::testReplayMatchesDirectPainting_data()
+{
+    QTest::addColumn<Painting>("painting");
+
+    QTest::newRow("clip rect before translate") << Painting([] (QPainter *painter) {
+        painter->setClipRect(QRect(10, 20, 60, 100));
+        painter->translate(25, 40);
+        painter->fillRect(QRect(0, 0, 100, 150), Qt::red);
+    });
+    QTest::newRow("clip rect before scale") << Painting([] (QPainter *painter) {
+        painter->setClipRect(QRect(10, 20, 60, 100));
+        painter->scale(2, 3);
+        painter->fillRect(QRect(0, 0, 50, 50), Qt::red);
+    });
+    QTest::newRow("clip region before translate and scale") << Painting([] (QPainter *painter) {
+        painter->setClipRegion(QRegion(5, 5, 40, 40) + QRegion(60, 70, 50, 120));
+        painter->translate(10, 15);
+        painter->scale(2, 2);
+        painter->fillRect(QRect(0, 0, 60, 100), Qt::blue);
+    });
+    QTest::newRow("clip path before translate") << Painting([] (QPainter *painter) {
+        QPainterPath path;
+        path.addRect(15, 30, 80, 90);
+        painter->setClipPath(path);
+        painter->translate(-20, 35);
+        painter->fillRect(QRect(0, 0, 150, 150), Qt::green);
+    });
+    QTest::newRow("clip after transform") << Painting([] (QPainter *painter) {
+        painter->translate(10, 15);
+        painter->scale(2, 2);
+        painter->setClipRect(QRect(5, 5, 30, 60));
+        painter->fillRect(QRect(0, 0, 100, 150), Qt::red);
+    });
+    QTest::newRow("intersected clips with transforms in between") << Painting([] (QPainter *painter) {
+        painter->setClipRect(QRect(0, 0, 120, 200));
+        painter->translate(30, 10);
+        painter->setClipRect(QRect(0, 0, 100, 100), Qt::IntersectClip);
+        painter->scale(2, 2);
+        painter->fillRect(QRect(0, 0, 100, 150), Qt::red);
+        painter->resetTransform();
+        painter->fillRect(QRect(0, 150, 150, 80), Qt::blue);
+    });
+    QTest::newRow("clip disabled after transform") << Painting([] (QPainter *painter) {
+        painter->setClipRect(QRect(10, 10, 50, 50));
+        painter->translate(20, 20);
+        painter->fillRect(QRect(0, 0, 100, 100), Qt::red);
+        painter->setClipping(false);
+        painter->fillRect(QRect(50, 120, 40, 40), Qt::blue);
+    });
+}
+
+void TestPaintRecorder::testReplayMatchesDirectPainting()
+{
+    QFETCH(Painting, painting);
+
+    const QImage expected = paintDirectly(painting);
+    const QImage recorded = paintRecorded(painting, expected.rect());
+    QCOMPARE(recorded, expected);
+}
+
+void TestPaintRecorder::testReplayRegion()
+{
+    const Painting painting = [] (QPainter *painter) {
+        painter->fillRect(QRect(0, 0, 150, 230), Qt::red);
+    };
+
+    // only the tiles intersecting the region are painted
+    const QImage recorded = paintRecorded(painting, QRect(0, 70, 10, 10));
+    QCOMPARE(recorded.pixelColor(5, 75), QColor(Qt::red));
+    QCOMPARE(recorded.pixelColor(5, 5), QColor(Qt::transparent));
+    QCOMPARE(recorded.pixelColor(5, 200), QColor(Qt::transparent));
+}
+
+QTEST_GUILESS_MAIN(TestPaintRecorder)
+#include "test_paint_recorder.moc"
@@ -0,0 +1,111 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2020 KWin developers <kwin@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "../rendertimepredictor.h"
+
+#include <QtTest>
+
+using namespace KWin;
+
+static const qint64 s_milli = 1000 * 1000;
+
+class TestRenderTimePredictor : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testFallback();
+    void testLastTimes();
+    void testSlowestFrameWins();
+    void testOverlappingTimes();
+    void testOldFramesExpire();
+    void testReset();
+};
+
+void TestRenderTimePredictor::testFallback()
+{
+    RenderTimePredictor predictor(6 * s_milli);
+    QCOMPARE(predictor.sampleCount(), 0);
+    QCOMPARE(predictor.predict(), 6 * s_milli);
+
+    predictor.setFallbackTime(3 * s_milli);
+    QCOMPARE(predictor.fallbackTime(), 3 * s_milli);
+    QCOMPARE(predictor.predict(), 3 * s_milli);
+}
+
+void TestRenderTimePredictor::testLastTimes()
+{
+    RenderTimePredictor predictor;
+    predictor.addSample(2 * s_milli, 3 * s_milli);
+    QCOMPARE(predictor.lastCpuTime(), 2 * s_milli);
+    QCOMPARE(predictor.lastGpuTime(), 3 * s_milli);
+    QCOMPARE(predictor.sampleCount(), 1);
+    // the prediction has to cover both, CPU and GPU time
+    QVERIFY(predictor.predict() > 5 * s_milli);
+
+    // negative values are clamped
+    predictor.addSample(-1, -1);
+    QCOMPARE(predictor.lastCpuTime(), qint64(0));
+    QCOMPARE(predictor.lastGpuTime(), qint64(0));
+}
+
+void TestRenderTimePredictor::testSlowestFrameWins()
+{
+    RenderTimePredictor predictor(10 * s_milli);
+    predictor.addSample(1 * s_milli);
+    const qint64 fast = predictor.predict();
+    QVERIFY(fast < 10 * s_milli);
+    QVERIFY(fast > 1 * s_milli);
+
+    predictor.addSample(4 * s_milli);
+    predictor.addSample(1 * s_milli);
+    QVERIFY(predictor.predict() > 4 * s_milli);
+}
+
+void TestRenderTimePredictor::testOverlappingTimes()
+{
+    // CPU and GPU work on a frame at the same time, their sum would be too pessimistic
+    RenderTimePredictor cpuBound(10 * s_milli);
+    cpuBound.addSample(4 * s_milli, 3 * s_milli);
+    RenderTimePredictor gpuBound(10 * s_milli);
+    gpuBound.addSample(3 * s_milli, 4 * s_milli);
+    RenderTimePredictor cpuOnly(10 * s_milli);
+    cpuOnly.addSample(4 * s_milli);
+
+    QCOMPARE(cpuBound.predict(), cpuOnly.predict());
+    QCOMPARE(gpuBound.predict(), cpuOnly.predict());
+    QVERIFY(cpuOnly.predict() < 7 * s_milli);
+}
+
+void TestRenderTimePredictor::testOldFramesExpire()
+{
+    RenderTimePredictor predictor;
+    predictor.addSample(8 * s_milli);
+    for (int i = 0; i < RenderTimePredictor::s_historySize - 1; ++i) {
+        predictor.addSample(1 * s_milli);
+    }
+    QVERIFY(predictor.predict() > 8 * s_milli);
+    QCOMPARE(predictor.sampleCount(), RenderTimePredictor::s_historySize);
+
+    predictor.addSample(1 * s_milli);
+    QVERIFY(predictor.predict() < 8 * s_milli);
+    QCOMPARE(predictor.sampleCount(), RenderTimePredictor::s_historySize);
+}
+
+void TestRenderTimePredictor::testReset()
+{
+    RenderTimePredictor predictor(6 * s_milli);
+    predictor.addSample(1 * s_milli, 1 * s_milli);
+    predictor.reset();
+    QCOMPARE(predictor.sampleCount(), 0);
+    QCOMPARE(predictor.lastCpuTime(), qint64(0));
+    QCOMPARE(predictor.lastGpuTime(), qint64(0));
+    QCOMPARE(predictor.predict(), 6 * s_milli);
+}
+
+QTEST_GUILESS_MAIN(TestRenderTimePredictor)
+#include "test_render_time_predictor.moc"
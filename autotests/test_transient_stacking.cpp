@@ -0,0 +1,274 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2020 KWin developers <kwin@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "../transientstacking.h"
+
+#include <QRandomGenerator>
+#include <QtTest>
+
+#include <memory>
+#include <vector>
+
+using namespace KWin;
+
+/**
+ * A window of the synthetic stacking order. Alive windows follow the semantics of
+ * AbstractClient, deleted windows the ones of Deleted.
+ */
+struct Window
+{
+    int id;
+    bool deleted = false;
+    // X11 clients consider indirect transients in hasTransient(), Wayland clients don't
+    bool indirect = true;
+    QList<Window *> parents;
+    QList<Window *> children;
+};
+
+static QList<Window *> ancestors(const Window *window)
+{
+    QList<Window *> result;
+    for (Window *parent : window->parents) {
+        if (!result.contains(parent)) {
+            result << parent;
+        }
+        for (Window *ancestor : ancestors(parent)) {
+            if (!result.contains(ancestor)) {
+                result << ancestor;
+            }
+        }
+    }
+    return result;
+}
+
+// AbstractClient::hasTransient(transient, true)
+static bool hasTransient(const Window *mainWindow, const Window *transient)
+{
+    if (transient->indirect) {
+        return ancestors(transient).contains(const_cast<Window *>(mainWindow));
+    }
+    return transient->parents.contains(const_cast<Window *>(mainWindow));
+}
+
+// stands in for the exceptions in Workspace::keepTransientAbove() and keepDeletedTransientAbove()
+static bool keepAboveException(const Window *mainWindow, const Window *transient)
+{
+    return (mainWindow->id * 31 + transient->id * 17) % 7 == 0;
+}
+
+static bool keepAbove(const Window *mainWindow, const Window *transient)
+{
+    if (!transient->deleted) {
+        return !mainWindow->deleted && hasTransient(mainWindow, transient)
+            && !keepAboveException(mainWindow, transient);
+    }
+    return transient->parents.contains(const_cast<Window *>(mainWindow))
+        && !keepAboveException(mainWindow, transient);
+}
+
+static bool hasAliveTransients(const Window *window)
+{
+    return std::any_of(window->children.constBegin(), window->children.constEnd(),
+                       [](const Window *child) { return !child->deleted; });
+}
+
+static bool hasDeletedTransients(const Window *window)
+{
+    return std::any_of(window->children.constBegin(), window->children.constEnd(),
+                       [](const Window *child) { return child->deleted; });
+}
+
+/**
+ * The transient constraint of Workspace::constrainedStackingOrder() before the
+ * transient positions got indexed.
+ */
+static void referenceConstrain(QList<Window *> &stacking)
+{
+    for (int i = stacking.size() - 1; i >= 0;) {
+        int i2 = -1;
+        bool hasTransients = false;
+
+        Window *current = stacking[i];
+        if (current->parents.isEmpty()) {
+            --i;
+            continue;
+        }
+        for (i2 = stacking.size() - 1; i2 >= 0; --i2) {
+            Window *c2 = stacking[i2];
+            if (!current->deleted && c2->deleted) {
+                continue;
+            }
+            if (c2 == current) {
+                i2 = -1;
+                break;
+            }
+            if (keepAbove(c2, current)) {
+                break;
+            }
+        }
+        if (!current->deleted) {
+            hasTransients = hasAliveTransients(current);
+            if (!hasTransients) {
+                for (int j = i + 1; j < stacking.count(); ++j) {
+                    if (stacking[j]->deleted && stacking[j]->parents.contains(current)) {
+                        hasTransients = true;
+                        break;
+                    }
+                }
+            }
+        } else {
+            hasTransients = hasDeletedTransients(current);
+        }
+
+        if (i2 == -1) {
+            --i;
+            continue;
+        }
+
+        stacking.removeAt(i);
+        --i;
+        --i2;
+        if (hasTransients) {
+            i = i2;
+        }
+        ++i2;
+        stacking.insert(i2, current);
+    }
+}
+
+static void constrain(QList<Window *> &stacking)
+{
+    constrainTransientStacking(stacking,
+        [](Window *window) {
+            return window->deleted ? window->parents : ancestors(window);
+        },
+        [](Window *mainWindow, Window *transient) {
+            return keepAbove(mainWindow, transient);
+        },
+        [](Window *window) {
+            return window->deleted ? hasDeletedTransients(window) : !window->children.isEmpty();
+        });
+}
+
+class TestTransientStacking : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testNoTransients();
+    void testTransientAboveMainWindow();
+    void testNestedTransients();
+    void testAlreadyAbove();
+    void testDeletedTransient();
+    void testRandomized_data();
+    void testRandomized();
+};
+
+static void addTransient(Window *mainWindow, Window *transient)
+{
+    transient->parents << mainWindow;
+    mainWindow->children << transient;
+}
+
+void TestTransientStacking::testNoTransients()
+{
+    Window a{1}, b{2}, c{3};
+    QList<Window *> stacking{&a, &b, &c};
+    constrain(stacking);
+    QCOMPARE(stacking, (QList<Window *>{&a, &b, &c}));
+}
+
+void TestTransientStacking::testTransientAboveMainWindow()
+{
+    Window main{1}, dialog{2}, other{3};
+    addTransient(&main, &dialog);
+    QList<Window *> stacking{&dialog, &main, &other};
+    constrain(stacking);
+    QCOMPARE(stacking, (QList<Window *>{&main, &dialog, &other}));
+}
+
+void TestTransientStacking::testNestedTransients()
+{
+    Window main{1}, dialog{2}, nested{3}, other{4};
+    addTransient(&main, &dialog);
+    addTransient(&dialog, &nested);
+    QList<Window *> stacking{&nested, &dialog, &other, &main};
+    constrain(stacking);
+    QCOMPARE(stacking, (QList<Window *>{&other, &main, &dialog, &nested}));
+}
+
+void TestTransientStacking::testAlreadyAbove()
+{
+    Window main{1}, dialog{2}, other{3};
+    addTransient(&main, &dialog);
+    QList<Window *> stacking{&main, &other, &dialog};
+    constrain(stacking);
+    QCOMPARE(stacking, (QList<Window *>{&main, &other, &dialog}));
+}
+
+void TestTransientStacking::testDeletedTransient()
+{
+    Window main{1}, closed{2}, other{3};
+    closed.deleted = true;
+    addTransient(&main, &closed);
+    QList<Window *> stacking{&closed, &main, &other};
+    constrain(stacking);
+    QCOMPARE(stacking, (QList<Window *>{&main, &closed, &other}));
+}
+
+void TestTransientStacking::testRandomized_data()
+{
+    QTest::addColumn<int>("windowCount");
+    QTest::addColumn<int>("transientPercentage");
+
+    QTest::newRow("few windows") << 8 << 50;
+    QTest::newRow("some windows") << 30 << 40;
+    QTest::newRow("many transients") << 60 << 80;
+    QTest::newRow("many windows") << 200 << 20;
+}
+
+void TestTransientStacking::testRandomized()
+{
+    QFETCH(int, windowCount);
+    QFETCH(int, transientPercentage);
+
+    QRandomGenerator generator(windowCount * 100 + transientPercentage);
+    for (int round = 0; round < 500; ++round) {
+        std::vector<std::unique_ptr<Window>> windows;
+        QList<Window *> stacking;
+        for (int i = 0; i < windowCount; ++i) {
+            windows.emplace_back(new Window{i + 1});
+            Window *window = windows.back().get();
+            window->deleted = generator.bounded(100) < 15;
+            window->indirect = generator.bounded(2);
+            // parents always have a lower id, so there are no loops
+            if (i > 0 && int(generator.bounded(100)) < transientPercentage) {
+                const int parentCount = generator.bounded(3) == 0 ? 2 : 1;
+                for (int j = 0; j < parentCount; ++j) {
+                    Window *parent = windows[generator.bounded(i)].get();
+                    // a client gets a new main window when its main window is closed
+                    if (parent->deleted && !window->deleted) {
+                        continue;
+                    }
+                    if (!window->parents.contains(parent)) {
+                        addTransient(parent, window);
+                    }
+                }
+            }
+            stacking.insert(generator.bounded(stacking.count() + 1), window);
+        }
+
+        QList<Window *> expected = stacking;
+        referenceConstrain(expected);
+        QList<Window *> actual = stacking;
+        constrain(actual);
+        QCOMPARE(actual, expected);
+    }
+}
+
+QTEST_GUILESS_MAIN(TestTransientStacking)
+#include "test_transient_stacking.moc"
@@ -0,0 +1,820 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2020 KWin developers <kwin@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "../effects/wobblywindows/wobblymodel.h"
+
+#include <QtTest>
+
+#include <cmath>
+
+using namespace KWin;
+
+// The simulation as the wobbly windows effect did it before it was moved into WobblyModel.
+// WobblyModel has to give the same results, up to rounding.
+
+struct Pair {
+    qreal x;
+    qreal y;
+};
+
+struct Reference
+{
+    explicit Reference(const QRectF &geometry);
+    Reference(const Reference &) = delete;
+
+    Pair storage[5][WobblyModel::s_count];
+    Pair *origin = storage[0];
+    Pair *position = storage[1];
+    Pair *velocity = storage[2];
+    Pair *acceleration = storage[3];
+    Pair *buffer = storage[4];
+    bool constraint[WobblyModel::s_count] = {};
+
+    unsigned int width = 4;
+    unsigned int height = 4;
+    unsigned int count = 16;
+
+    bool can_wobble_top = true;
+    bool can_wobble_left = true;
+    bool can_wobble_right = true;
+    bool can_wobble_bottom = true;
+
+    qreal accelerationSum = 0.0;
+    qreal velocitySum = 0.0;
+};
+
+Reference::Reference(const QRectF &geometry)
+{
+    qreal x = geometry.x(), y = geometry.y();
+    qreal width = geometry.width(), height = geometry.height();
+
+    Pair initValue = {x, y};
+    static const Pair nullPair = {0.0, 0.0};
+
+    qreal x_increment = width / (this->width - 1.0);
+    qreal y_increment = height / (this->height - 1.0);
+
+    for (unsigned int j = 0; j < 4; ++j) {
+        for (unsigned int i = 0; i < 4; ++i) {
+            unsigned int idx = j * 4 + i;
+            origin[idx] = initValue;
+            position[idx] = initValue;
+            velocity[idx] = nullPair;
+            acceleration[idx] = nullPair;
+            if (i != 4 - 2) { // x grid count - 2, i.e. not the last point
+                initValue.x += x_increment;
+            } else {
+                initValue.x = width + x;
+            }
+        }
+        initValue.x = x;
+        if (j != 4 - 2) { // y grid count - 2, i.e. not the last point
+            initValue.y += y_increment;
+        } else {
+            initValue.y = height + y;
+        }
+    }
+}
+
+static Pair referenceBezierPoint(const Reference &wwi, Pair point)
+{
+    // compute the input value
+    Pair topleft = wwi.origin[0];
+    Pair bottomright = wwi.origin[wwi.count-1];
+
+    qreal tx = (point.x - topleft.x) / (bottomright.x - topleft.x);
+    qreal ty = (point.y - topleft.y) / (bottomright.y - topleft.y);
+
+    // compute polynomial coeff
+
+    qreal px[4];
+    px[0] = (1 - tx) * (1 - tx) * (1 - tx);
+    px[1] = 3 * (1 - tx) * (1 - tx) * tx;
+    px[2] = 3 * (1 - tx) * tx * tx;
+    px[3] = tx * tx * tx;
+
+    qreal py[4];
+    py[0] = (1 - ty) * (1 - ty) * (1 - ty);
+    py[1] = 3 * (1 - ty) * (1 - ty) * ty;
+    py[2] = 3 * (1 - ty) * ty * ty;
+    py[3] = ty * ty * ty;
+
+    Pair res = {0.0, 0.0};
+
+    for (unsigned int j = 0; j < 4; ++j) {
+        for (unsigned int i = 0; i < 4; ++i) {
+            // this assume the grid is 4*4
+            res.x += px[i] * py[j] * wwi.position[i + j * wwi.width].x;
+            res.y += px[i] * py[j] * wwi.position[i + j * wwi.width].y;
+        }
+    }
+
+    return res;
+}
+
+static inline void fixVectorBounds(Pair& vec, qreal min, qreal max)
+{
+    if (fabs(vec.x) < min) {
+        vec.x = 0.0;
+    } else if (fabs(vec.x) > max) {
+        if (vec.x > 0.0) {
+            vec.x = max;
+        } else {
+            vec.x = -max;
+        }
+    }
+
+    if (fabs(vec.y) < min) {
+        vec.y = 0.0;
+    } else if (fabs(vec.y) > max) {
+        if (vec.y > 0.0) {
+            vec.y = max;
+        } else {
+            vec.y = -max;
+        }
+    }
+}
+
+static void referenceRingMean(Pair **data_pointer, Reference &wwi)
+{
+    Pair* data = *data_pointer;
+    Pair neibourgs[8];
+
+    // for corners
+
+    // top-left
+    {
+        Pair& res = wwi.buffer[0];
+        Pair vit = data[0];
+        neibourgs[0] = data[1];
+        neibourgs[1] = data[wwi.width];
+        neibourgs[2] = data[wwi.width+1];
+
+        res.x = (neibourgs[0].x + neibourgs[1].x + neibourgs[2].x + 3.0 * vit.x) / 6.0;
+        res.y = (neibourgs[0].y + neibourgs[1].y + neibourgs[2].y + 3.0 * vit.y) / 6.0;
+    }
+
+
+    // top-right
+    {
+        Pair& res = wwi.buffer[wwi.width-1];
+        Pair vit = data[wwi.width-1];
+        neibourgs[0] = data[wwi.width-2];
+        neibourgs[1] = data[2*wwi.width-1];
+        neibourgs[2] = data[2*wwi.width-2];
+
+        res.x = (neibourgs[0].x + neibourgs[1].x + neibourgs[2].x + 3.0 * vit.x) / 6.0;
+        res.y = (neibourgs[0].y + neibourgs[1].y + neibourgs[2].y + 3.0 * vit.y) / 6.0;
+    }
+
+
+    // bottom-left
+    {
+        Pair& res = wwi.buffer[wwi.width*(wwi.height-1)];
+        Pair vit = data[wwi.width*(wwi.height-1)];
+        neibourgs[0] = data[wwi.width*(wwi.height-1)+1];
+        neibourgs[1] = data[wwi.width*(wwi.height-2)];
+        neibourgs[2] = data[wwi.width*(wwi.height-2)+1];
+
+        res.x = (neibourgs[0].x + neibourgs[1].x + neibourgs[2].x + 3.0 * vit.x) / 6.0;
+        res.y = (neibourgs[0].y + neibourgs[1].y + neibourgs[2].y + 3.0 * vit.y) / 6.0;
+    }
+
+
+    // bottom-right
+    {
+        Pair& res = wwi.buffer[wwi.count-1];
+        Pair vit = data[wwi.count-1];
+        neibourgs[0] = data[wwi.count-2];
+        neibourgs[1] = data[wwi.width*(wwi.height-1)-1];
+        neibourgs[2] = data[wwi.width*(wwi.height-1)-2];
+
+        res.x = (neibourgs[0].x + neibourgs[1].x + neibourgs[2].x + 3.0 * vit.x) / 6.0;
+        res.y = (neibourgs[0].y + neibourgs[1].y + neibourgs[2].y + 3.0 * vit.y) / 6.0;
+    }
+
+
+    // for borders
+
+    // top border
+    for (unsigned int i = 1; i < wwi.width - 1; ++i) {
+        Pair& res = wwi.buffer[i];
+        Pair vit = data[i];
+        neibourgs[0] = data[i-1];
+        neibourgs[1] = data[i+1];
+        neibourgs[2] = data[i+wwi.width];
+        neibourgs[3] = data[i+wwi.width-1];
+        neibourgs[4] = data[i+wwi.width+1];
+
+        res.x = (neibourgs[0].x + neibourgs[1].x + neibourgs[2].x + neibourgs[3].x + neibourgs[4].x + 5.0 * vit.x) / 10.0;
+        res.y = (neibourgs[0].y + neibourgs[1].y + neibourgs[2].y + neibourgs[3].y + neibourgs[4].y + 5.0 * vit.y) / 10.0;
+    }
+
+    // bottom border
+    for (unsigned int i = wwi.width * (wwi.height - 1) + 1; i < wwi.count - 1; ++i) {
+        Pair& res = wwi.buffer[i];
+        Pair vit = data[i];
+        neibourgs[0] = data[i-1];
+        neibourgs[1] = data[i+1];
+        neibourgs[2] = data[i-wwi.width];
+        neibourgs[3] = data[i-wwi.width-1];
+        neibourgs[4] = data[i-wwi.width+1];
+
+        res.x = (neibourgs[0].x + neibourgs[1].x + neibourgs[2].x + neibourgs[3].x + neibourgs[4].x + 5.0 * vit.x) / 10.0;
+        res.y = (neibourgs[0].y + neibourgs[1].y + neibourgs[2].y + neibourgs[3].y + neibourgs[4].y + 5.0 * vit.y) / 10.0;
+    }
+
+    // left border
+    for (unsigned int i = wwi.width; i < wwi.width*(wwi.height - 1); i += wwi.width) {
+        Pair& res = wwi.buffer[i];
+        Pair vit = data[i];
+        neibourgs[0] = data[i+1];
+        neibourgs[1] = data[i-wwi.width];
+        neibourgs[2] = data[i+wwi.width];
+        neibourgs[3] = data[i-wwi.width+1];
+        neibourgs[4] = data[i+wwi.width+1];
+
+        res.x = (neibourgs[0].x + neibourgs[1].x + neibourgs[2].x + neibourgs[3].x + neibourgs[4].x + 5.0 * vit.x) / 10.0;
+        res.y = (neibourgs[0].y + neibourgs[1].y + neibourgs[2].y + neibourgs[3].y + neibourgs[4].y + 5.0 * vit.y) / 10.0;
+    }
+
+    // right border
+    for (unsigned int i = 2 * wwi.width - 1; i < wwi.count - 1; i += wwi.width) {
+        Pair& res = wwi.buffer[i];
+        Pair vit = data[i];
+        neibourgs[0] = data[i-1];
+        neibourgs[1] = data[i-wwi.width];
+        neibourgs[2] = data[i+wwi.width];
+        neibourgs[3] = data[i-wwi.width-1];
+        neibourgs[4] = data[i+wwi.width-1];
+
+        res.x = (neibourgs[0].x + neibourgs[1].x + neibourgs[2].x + neibourgs[3].x + neibourgs[4].x + 5.0 * vit.x) / 10.0;
+        res.y = (neibourgs[0].y + neibourgs[1].y + neibourgs[2].y + neibourgs[3].y + neibourgs[4].y + 5.0 * vit.y) / 10.0;
+    }
+
+    // for the inner points
+    for (unsigned int j = 1; j < wwi.height - 1; ++j) {
+        for (unsigned int i = 1; i < wwi.width - 1; ++i) {
+            unsigned int index = i + j * wwi.width;
+
+            Pair& res = wwi.buffer[index];
+            Pair& vit = data[index];
+            neibourgs[0] = data[index-1];
+            neibourgs[1] = data[index+1];
+            neibourgs[2] = data[index-wwi.width];
+            neibourgs[3] = data[index+wwi.width];
+            neibourgs[4] = data[index-wwi.width-1];
+            neibourgs[5] = data[index-wwi.width+1];
+            neibourgs[6] = data[index+wwi.width-1];
+            neibourgs[7] = data[index+wwi.width+1];
+
+            res.x = (neibourgs[0].x + neibourgs[1].x + neibourgs[2].x + neibourgs[3].x + neibourgs[4].x + neibourgs[5].x + neibourgs[6].x + neibourgs[7].x + 8.0 * vit.x) / 16.0;
+            res.y = (neibourgs[0].y + neibourgs[1].y + neibourgs[2].y + neibourgs[3].y + neibourgs[4].y + neibourgs[5].y + neibourgs[6].y + neibourgs[7].y + 8.0 * vit.y) / 16.0;
+        }
+    }
+
+    Pair* tmp = data;
+    *data_pointer = wwi.buffer;
+    wwi.buffer = tmp;
+}
+
+static void referenceStep(Reference &wwi, const QRectF &rect, const WobblyModel::Parameters &parameters, qreal time)
+{
+
+    qreal x_length = rect.width() / (wwi.width - 1.0);
+    qreal y_length = rect.height() / (wwi.height - 1.0);
+
+    Pair origine = {rect.x(), rect.y()};
+
+    for (unsigned int j = 0; j < wwi.height; ++j) {
+        for (unsigned int i = 0; i < wwi.width; ++i) {
+            wwi.origin[wwi.width*j + i] = origine;
+            if (i != wwi.width - 2) {
+                origine.x += x_length;
+            } else {
+                origine.x = rect.width() + rect.x();
+            }
+        }
+        origine.x = rect.x();
+        if (j != wwi.height - 2) {
+            origine.y += y_length;
+        } else {
+            origine.y = rect.height() + rect.y();
+        }
+    }
+
+    Pair neibourgs[4];
+    Pair acceleration;
+
+    qreal acc_sum = 0.0;
+    qreal vel_sum = 0.0;
+
+    // compute acceleration, velocity and position for each point
+
+    // for corners
+
+    // top-left
+
+    if (wwi.constraint[0]) {
+        Pair window_pos = wwi.origin[0];
+        Pair current_pos = wwi.position[0];
+        Pair move = {window_pos.x - current_pos.x, window_pos.y - current_pos.y};
+        Pair accel = {move.x*parameters.stiffness, move.y*parameters.stiffness};
+        wwi.acceleration[0] = accel;
+    } else {
+        Pair& pos = wwi.position[0];
+        neibourgs[0] = wwi.position[1];
+        neibourgs[1] = wwi.position[wwi.width];
+
+        acceleration.x = ((neibourgs[0].x - pos.x) - x_length) * parameters.stiffness + (neibourgs[1].x - pos.x) * parameters.stiffness;
+        acceleration.y = ((neibourgs[1].y - pos.y) - y_length) * parameters.stiffness + (neibourgs[0].y - pos.y) * parameters.stiffness;
+
+        acceleration.x /= 2;
+        acceleration.y /= 2;
+
+        wwi.acceleration[0] = acceleration;
+    }
+
+    // top-right
+
+    if (wwi.constraint[wwi.width-1]) {
+        Pair window_pos = wwi.origin[wwi.width-1];
+        Pair current_pos = wwi.position[wwi.width-1];
+        Pair move = {window_pos.x - current_pos.x, window_pos.y - current_pos.y};
+        Pair accel = {move.x*parameters.stiffness, move.y*parameters.stiffness};
+        wwi.acceleration[wwi.width-1] = accel;
+    } else {
+        Pair& pos = wwi.position[wwi.width-1];
+        neibourgs[0] = wwi.position[wwi.width-2];
+        neibourgs[1] = wwi.position[2*wwi.width-1];
+
+        acceleration.x = (x_length - (pos.x - neibourgs[0].x)) * parameters.stiffness + (neibourgs[1].x - pos.x) * parameters.stiffness;
+        acceleration.y = ((neibourgs[1].y - pos.y) - y_length) * parameters.stiffness + (neibourgs[0].y - pos.y) * parameters.stiffness;
+
+        acceleration.x /= 2;
+        acceleration.y /= 2;
+
+        wwi.acceleration[wwi.width-1] = acceleration;
+    }
+
+    // bottom-left
+
+    if (wwi.constraint[wwi.width*(wwi.height-1)]) {
+        Pair window_pos = wwi.origin[wwi.width*(wwi.height-1)];
+        Pair current_pos = wwi.position[wwi.width*(wwi.height-1)];
+        Pair move = {window_pos.x - current_pos.x, window_pos.y - current_pos.y};
+        Pair accel = {move.x*parameters.stiffness, move.y*parameters.stiffness};
+        wwi.acceleration[wwi.width*(wwi.height-1)] = accel;
+    } else {
+        Pair& pos = wwi.position[wwi.width*(wwi.height-1)];
+        neibourgs[0] = wwi.position[wwi.width*(wwi.height-1)+1];
+        neibourgs[1] = wwi.position[wwi.width*(wwi.height-2)];
+
+        acceleration.x = ((neibourgs[0].x - pos.x) - x_length) * parameters.stiffness + (neibourgs[1].x - pos.x) * parameters.stiffness;
+        acceleration.y = (y_length - (pos.y - neibourgs[1].y)) * parameters.stiffness + (neibourgs[0].y - pos.y) * parameters.stiffness;
+
+        acceleration.x /= 2;
+        acceleration.y /= 2;
+
+        wwi.acceleration[wwi.width*(wwi.height-1)] = acceleration;
+    }
+
+    // bottom-right
+
+    if (wwi.constraint[wwi.count-1]) {
+        Pair window_pos = wwi.origin[wwi.count-1];
+        Pair current_pos = wwi.position[wwi.count-1];
+        Pair move = {window_pos.x - current_pos.x, window_pos.y - current_pos.y};
+        Pair accel = {move.x*parameters.stiffness, move.y*parameters.stiffness};
+        wwi.acceleration[wwi.count-1] = accel;
+    } else {
+        Pair& pos = wwi.position[wwi.count-1];
+        neibourgs[0] = wwi.position[wwi.count-2];
+        neibourgs[1] = wwi.position[wwi.width*(wwi.height-1)-1];
+
+        acceleration.x = (x_length - (pos.x - neibourgs[0].x)) * parameters.stiffness + (neibourgs[1].x - pos.x) * parameters.stiffness;
+        acceleration.y = (y_length - (pos.y - neibourgs[1].y)) * parameters.stiffness + (neibourgs[0].y - pos.y) * parameters.stiffness;
+
+        acceleration.x /= 2;
+        acceleration.y /= 2;
+
+        wwi.acceleration[wwi.count-1] = acceleration;
+    }
+
+    // for borders
+
+    // top border
+    for (unsigned int i = 1; i < wwi.width - 1; ++i) {
+        if (wwi.constraint[i]) {
+            Pair window_pos = wwi.origin[i];
+            Pair current_pos = wwi.position[i];
+            Pair move = {window_pos.x - current_pos.x, window_pos.y - current_pos.y};
+            Pair accel = {move.x*parameters.stiffness, move.y*parameters.stiffness};
+            wwi.acceleration[i] = accel;
+        } else {
+            Pair& pos = wwi.position[i];
+            neibourgs[0] = wwi.position[i-1];
+            neibourgs[1] = wwi.position[i+1];
+            neibourgs[2] = wwi.position[i+wwi.width];
+
+            acceleration.x = (x_length - (pos.x - neibourgs[0].x)) * parameters.stiffness + ((neibourgs[1].x - pos.x) - x_length) * parameters.stiffness + (neibourgs[2].x - pos.x) * parameters.stiffness;
+            acceleration.y = ((neibourgs[2].y - pos.y) - y_length) * parameters.stiffness + (neibourgs[0].y - pos.y) * parameters.stiffness + (neibourgs[1].y - pos.y) * parameters.stiffness;
+
+            acceleration.x /= 3;
+            acceleration.y /= 3;
+
+            wwi.acceleration[i] = acceleration;
+        }
+    }
+
+    // bottom border
+    for (unsigned int i = wwi.width * (wwi.height - 1) + 1; i < wwi.count - 1; ++i) {
+        if (wwi.constraint[i]) {
+            Pair window_pos = wwi.origin[i];
+            Pair current_pos = wwi.position[i];
+            Pair move = {window_pos.x - current_pos.x, window_pos.y - current_pos.y};
+            Pair accel = {move.x*parameters.stiffness, move.y*parameters.stiffness};
+            wwi.acceleration[i] = accel;
+        } else {
+            Pair& pos = wwi.position[i];
+            neibourgs[0] = wwi.position[i-1];
+            neibourgs[1] = wwi.position[i+1];
+            neibourgs[2] = wwi.position[i-wwi.width];
+
+            acceleration.x = (x_length - (pos.x - neibourgs[0].x)) * parameters.stiffness + ((neibourgs[1].x - pos.x) - x_length) * parameters.stiffness + (neibourgs[2].x - pos.x) * parameters.stiffness;
+            acceleration.y = (y_length - (pos.y - neibourgs[2].y)) * parameters.stiffness + (neibourgs[0].y - pos.y) * parameters.stiffness + (neibourgs[1].y - pos.y) * parameters.stiffness;
+
+            acceleration.x /= 3;
+            acceleration.y /= 3;
+
+            wwi.acceleration[i] = acceleration;
+        }
+    }
+
+    // left border
+    for (unsigned int i = wwi.width; i < wwi.width*(wwi.height - 1); i += wwi.width) {
+        if (wwi.constraint[i]) {
+            Pair window_pos = wwi.origin[i];
+            Pair current_pos = wwi.position[i];
+            Pair move = {window_pos.x - current_pos.x, window_pos.y - current_pos.y};
+            Pair accel = {move.x*parameters.stiffness, move.y*parameters.stiffness};
+            wwi.acceleration[i] = accel;
+        } else {
+            Pair& pos = wwi.position[i];
+            neibourgs[0] = wwi.position[i+1];
+            neibourgs[1] = wwi.position[i-wwi.width];
+            neibourgs[2] = wwi.position[i+wwi.width];
+
+            acceleration.x = ((neibourgs[0].x - pos.x) - x_length) * parameters.stiffness + (neibourgs[1].x - pos.x) * parameters.stiffness + (neibourgs[2].x - pos.x) * parameters.stiffness;
+            acceleration.y = (y_length - (pos.y - neibourgs[1].y)) * parameters.stiffness + ((neibourgs[2].y - pos.y) - y_length) * parameters.stiffness + (neibourgs[0].y - pos.y) * parameters.stiffness;
+
+            acceleration.x /= 3;
+            acceleration.y /= 3;
+
+            wwi.acceleration[i] = acceleration;
+        }
+    }
+
+    // right border
+    for (unsigned int i = 2 * wwi.width - 1; i < wwi.count - 1; i += wwi.width) {
+        if (wwi.constraint[i]) {
+            Pair window_pos = wwi.origin[i];
+            Pair current_pos = wwi.position[i];
+            Pair move = {window_pos.x - current_pos.x, window_pos.y - current_pos.y};
+            Pair accel = {move.x*parameters.stiffness, move.y*parameters.stiffness};
+            wwi.acceleration[i] = accel;
+        } else {
+            Pair& pos = wwi.position[i];
+            neibourgs[0] = wwi.position[i-1];
+            neibourgs[1] = wwi.position[i-wwi.width];
+            neibourgs[2] = wwi.position[i+wwi.width];
+
+            acceleration.x = (x_length - (pos.x - neibourgs[0].x)) * parameters.stiffness + (neibourgs[1].x - pos.x) * parameters.stiffness + (neibourgs[2].x - pos.x) * parameters.stiffness;
+            acceleration.y = (y_length - (pos.y - neibourgs[1].y)) * parameters.stiffness + ((neibourgs[2].y - pos.y) - y_length) * parameters.stiffness + (neibourgs[0].y - pos.y) * parameters.stiffness;
+
+            acceleration.x /= 3;
+            acceleration.y /= 3;
+
+            wwi.acceleration[i] = acceleration;
+        }
+    }
+
+    // for the inner points
+    for (unsigned int j = 1; j < wwi.height - 1; ++j) {
+        for (unsigned int i = 1; i < wwi.width - 1; ++i) {
+            unsigned int index = i + j * wwi.width;
+
+            if (wwi.constraint[index]) {
+                Pair window_pos = wwi.origin[index];
+                Pair current_pos = wwi.position[index];
+                Pair move = {window_pos.x - current_pos.x, window_pos.y - current_pos.y};
+                Pair accel = {move.x*parameters.stiffness, move.y*parameters.stiffness};
+                wwi.acceleration[index] = accel;
+            } else {
+                Pair& pos = wwi.position[index];
+                neibourgs[0] = wwi.position[index-1];
+                neibourgs[1] = wwi.position[index+1];
+                neibourgs[2] = wwi.position[index-wwi.width];
+                neibourgs[3] = wwi.position[index+wwi.width];
+
+                acceleration.x = ((neibourgs[0].x - pos.x) - x_length) * parameters.stiffness +
+                                 (x_length - (pos.x - neibourgs[1].x)) * parameters.stiffness +
+                                 (neibourgs[2].x - pos.x) * parameters.stiffness +
+                                 (neibourgs[3].x - pos.x) * parameters.stiffness;
+                acceleration.y = (y_length - (pos.y - neibourgs[2].y)) * parameters.stiffness +
+                                 ((neibourgs[3].y - pos.y) - y_length) * parameters.stiffness +
+                                 (neibourgs[0].y - pos.y) * parameters.stiffness +
+                                 (neibourgs[1].y - pos.y) * parameters.stiffness;
+
+                acceleration.x /= 4;
+                acceleration.y /= 4;
+
+                wwi.acceleration[index] = acceleration;
+            }
+        }
+    }
+
+    referenceRingMean(&wwi.acceleration, wwi);
+
+    // compute the new velocity of each vertex.
+    for (unsigned int i = 0; i < wwi.count; ++i) {
+        Pair acc = wwi.acceleration[i];
+        fixVectorBounds(acc, parameters.minAcceleration, parameters.maxAcceleration);
+
+        Pair& vel = wwi.velocity[i];
+        vel.x = acc.x * time + vel.x * parameters.drag;
+        vel.y = acc.y * time + vel.y * parameters.drag;
+
+        acc_sum += fabs(acc.x) + fabs(acc.y);
+    }
+
+    referenceRingMean(&wwi.velocity, wwi);
+
+    // compute the new pos of each vertex.
+    for (unsigned int i = 0; i < wwi.count; ++i) {
+        Pair& pos = wwi.position[i];
+        Pair& vel = wwi.velocity[i];
+
+        fixVectorBounds(vel, parameters.minVelocity, parameters.maxVelocity);
+
+        pos.x += vel.x * time * parameters.moveFactor;
+        pos.y += vel.y * time * parameters.moveFactor;
+
+        vel_sum += fabs(vel.x) + fabs(vel.y);
+
+    }
+
+    if (!wwi.can_wobble_top) {
+        for (unsigned int i = 0; i < wwi.width; ++i)
+            for (unsigned j = 0; j < wwi.width - 1; ++j)
+                wwi.position[i+wwi.width*j].y = wwi.origin[i+wwi.width*j].y;
+    }
+    if (!wwi.can_wobble_bottom) {
+        for (unsigned int i = wwi.width * (wwi.height - 1); i < wwi.count; ++i)
+            for (unsigned j = 0; j < wwi.width - 1; ++j)
+                wwi.position[i-wwi.width*j].y = wwi.origin[i-wwi.width*j].y;
+    }
+    if (!wwi.can_wobble_left) {
+        for (unsigned int i = 0; i < wwi.count; i += wwi.width)
+            for (unsigned j = 0; j < wwi.width - 1; ++j)
+                wwi.position[i+j].x = wwi.origin[i+j].x;
+    }
+    if (!wwi.can_wobble_right) {
+        for (unsigned int i = wwi.width - 1; i < wwi.count; i += wwi.width)
+            for (unsigned j = 0; j < wwi.width - 1; ++j)
+                wwi.position[i-j].x = wwi.origin[i-j].x;
+    }
+
+    wwi.accelerationSum = acc_sum;
+    wwi.velocitySum = vel_sum;
+}
+
+// the parameters of the least and the most wobbly presets of the effect
+static const WobblyModel::Parameters s_stiff = {0.15, 0.80, 0.10, 0.0, 1000.0, 0.0, 1000.0};
+static const WobblyModel::Parameters s_wobbly = {0.01, 0.97, 0.25, 0.0, 1000.0, 0.0, 1000.0};
+
+Q_DECLARE_METATYPE(WobblyModel::Parameters)
+
+// the rounding errors of a frame stay many orders of magnitude below this
+static const qreal s_tolerance = 1e-6;
+
+static bool fuzzyEqual(qreal a, qreal b)
+{
+    return std::fabs(a - b) <= s_tolerance * qMax(qreal(1.0), std::fabs(b));
+}
+
+static void compare(const WobblyModel &model, const Reference &reference)
+{
+    for (int i = 0; i < WobblyModel::s_count; ++i) {
+        const QPointF position = model.position(i);
+        const QPointF velocity = model.velocity(i);
+        QVERIFY2(fuzzyEqual(position.x(), reference.position[i].x), qPrintable(QString::number(i)));
+        QVERIFY2(fuzzyEqual(position.y(), reference.position[i].y), qPrintable(QString::number(i)));
+        QVERIFY2(fuzzyEqual(velocity.x(), reference.velocity[i].x), qPrintable(QString::number(i)));
+        QVERIFY2(fuzzyEqual(velocity.y(), reference.velocity[i].y), qPrintable(QString::number(i)));
+    }
+    QVERIFY(fuzzyEqual(model.accelerationSum(), reference.accelerationSum));
+    QVERIFY(fuzzyEqual(model.velocitySum(), reference.velocitySum));
+
+    // the tesselated vertices of the window, and some outside of it
+    const QPointF topLeft(reference.origin[0].x, reference.origin[0].y);
+    const QPointF bottomRight(reference.origin[WobblyModel::s_count - 1].x, reference.origin[WobblyModel::s_count - 1].y);
+    for (int j = -1; j <= 21; ++j) {
+        for (int i = -1; i <= 21; ++i) {
+            const QPointF point = topLeft + QPointF((bottomRight.x() - topLeft.x()) * i / 20.0,
+                                                    (bottomRight.y() - topLeft.y()) * j / 20.0);
+            const QPointF mapped = model.map(point);
+            const Pair expected = referenceBezierPoint(reference, {point.x(), point.y()});
+            QVERIFY(fuzzyEqual(mapped.x(), expected.x));
+            QVERIFY(fuzzyEqual(mapped.y(), expected.y));
+        }
+    }
+}
+
+class TestWobblyModel : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testInitial();
+    void testMove_data();
+    void testMove();
+    void testMaximize_data();
+    void testMaximize();
+    void testResize();
+    void benchmarkStep();
+    void benchmarkReferenceStep();
+    void benchmarkMap();
+};
+
+void TestWobblyModel::testInitial()
+{
+    const QRectF geometry(100, 50, 640, 480);
+    WobblyModel model(geometry);
+    Reference reference(geometry);
+    compare(model, reference);
+
+    QCOMPARE(model.position(0), geometry.topLeft());
+    QCOMPARE(model.position(WobblyModel::s_count - 1), geometry.bottomRight());
+    // the undeformed surface doesn't move anything
+    const QPointF mapped = model.map(QPointF(200, 300));
+    QVERIFY(fuzzyEqual(mapped.x(), 200));
+    QVERIFY(fuzzyEqual(mapped.y(), 300));
+}
+
+void TestWobblyModel::testMove_data()
+{
+    QTest::addColumn<WobblyModel::Parameters>("parameters");
+    QTest::addColumn<int>("picked");
+    QTest::addColumn<qreal>("time");
+
+    QTest::newRow("stiff/corner/60Hz") << s_stiff << 0 << 16.0;
+    QTest::newRow("stiff/inner/144Hz") << s_stiff << 5 << 7.0;
+    QTest::newRow("wobbly/border/60Hz") << s_wobbly << 7 << 16.0;
+    QTest::newRow("wobbly/corner/144Hz") << s_wobbly << 15 << 7.0;
+}
+
+void TestWobblyModel::testMove()
+{
+    QFETCH(WobblyModel::Parameters, parameters);
+    QFETCH(int, picked);
+    QFETCH(qreal, time);
+
+    QRectF geometry(100, 50, 640, 480);
+    WobblyModel model(geometry);
+    Reference reference(geometry);
+    model.setConstrained(picked, true);
+    reference.constraint[picked] = true;
+
+    for (int frame = 0; frame < 500; ++frame) {
+        // drag the window around for a while, then let it settle
+        if (frame < 150) {
+            geometry.translate(12 * std::sin(frame / 10.0), 7 * std::cos(frame / 15.0));
+        }
+        // the effect advances in steps of at most 10 ms
+        for (qreal remaining = time; remaining > 0; remaining -= 10.0) {
+            model.step(geometry, parameters, qMin(remaining, qreal(10.0)));
+            referenceStep(reference, geometry, parameters, qMin(remaining, qreal(10.0)));
+        }
+        compare(model, reference);
+        if (QTest::currentTestFailed()) {
+            return;
+        }
+    }
+}
+
+void TestWobblyModel::testMaximize_data()
+{
+    QTest::addColumn<qreal>("magnitude");
+
+    QTest::newRow("maximize") << 10.0;
+    QTest::newRow("restore") << -30.0;
+}
+
+void TestWobblyModel::testMaximize()
+{
+    QFETCH(qreal, magnitude);
+
+    const QRectF geometry(0, 0, 1920, 1080);
+    WobblyModel model(QRectF(300, 200, 800, 600));
+    Reference reference(QRectF(300, 200, 800, 600));
+
+    // as WobblyWindowsEffect::stepMovedResized() throbs the window
+    for (int j = 0; j < WobblyModel::s_height; ++j) {
+        for (int i = 0; i < WobblyModel::s_width; ++i) {
+            const int index = j * WobblyModel::s_width + i;
+            const QPointF v(magnitude * (i / 3.0 - 0.5), magnitude * (j / 3.0 - 0.5));
+            model.setVelocity(index, v);
+            reference.velocity[index] = {v.x(), v.y()};
+            if (i > 0 && i < WobblyModel::s_width - 1 && j > 0 && j < WobblyModel::s_height - 1) {
+                model.setConstrained(index, true);
+                reference.constraint[index] = true;
+            }
+        }
+    }
+
+    for (int frame = 0; frame < 300; ++frame) {
+        model.step(geometry, s_stiff, 10.0);
+        referenceStep(reference, geometry, s_stiff, 10.0);
+        compare(model, reference);
+        if (QTest::currentTestFailed()) {
+            return;
+        }
+    }
+    // it has settled
+    QVERIFY(model.accelerationSum() < 0.5);
+    QVERIFY(model.velocitySum() < 0.5);
+}
+
+void TestWobblyModel::testResize()
+{
+    QRectF geometry(100, 50, 640, 480);
+    WobblyModel model(geometry);
+    Reference reference(geometry);
+    model.setConstrained(15, true);
+    reference.constraint[15] = true;
+    reference.can_wobble_top = false;
+    reference.can_wobble_left = false;
+
+    for (int frame = 0; frame < 200; ++frame) {
+        // resizing by the bottom right corner
+        if (frame < 100) {
+            geometry.setBottomRight(geometry.bottomRight() + QPointF(5, 3));
+        }
+        model.step(geometry, s_wobbly, 10.0);
+        model.pinEdges(true, true, false, false);
+        referenceStep(reference, geometry, s_wobbly, 10.0);
+        compare(model, reference);
+        if (QTest::currentTestFailed()) {
+            return;
+        }
+    }
+}
+
+void TestWobblyModel::benchmarkStep()
+{
+    const QRectF geometry(100, 50, 640, 480);
+    WobblyModel model(QRectF(0, 0, 640, 480));
+    model.setConstrained(5, true);
+    QBENCHMARK {
+        model.step(geometry, s_wobbly, 10.0);
+    }
+}
+
+void TestWobblyModel::benchmarkReferenceStep()
+{
+    const QRectF geometry(100, 50, 640, 480);
+    Reference reference(QRectF(0, 0, 640, 480));
+    reference.constraint[5] = true;
+    QBENCHMARK {
+        referenceStep(reference, geometry, s_wobbly, 10.0);
+    }
+}
+
+void TestWobblyModel::benchmarkMap()
+{
+    WobblyModel model(QRectF(0, 0, 640, 480));
+    model.setConstrained(5, true);
+    for (int frame = 0; frame < 50; ++frame) {
+        model.step(QRectF(100, 50, 640, 480), s_wobbly, 10.0);
+    }
+
+    // the vertices of a window tesselated by the effect
+    qreal sum = 0.0;
+    QBENCHMARK {
+        for (int j = 0; j <= 40; ++j) {
+            for (int i = 0; i <= 40; ++i) {
+                const QPointF mapped = model.map(QPointF(100 + i * 16, 50 + j * 12));
+                sum += mapped.x() + mapped.y();
+            }
+        }
+    }
+    QVERIFY(sum > 0.0);
+}
+
+QTEST_GUILESS_MAIN(TestWobblyModel)
+#include "test_wobbly_model.moc"
@@ -0,0 +1,167 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2020 KWin developers <kwin@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "../xcursortheme.h"
+
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QtTest>
+
+using namespace KWin;
+
+struct CursorImage
+{
+    int size;
+    QPoint hotspot;
+    int delay;
+    QRgb color;
+};
+
+// writes a cursor file with one square image per entry, each as large as its nominal size
+static void writeCursor(const QString &filePath, const QVector<CursorImage> &images)
+{
+    const quint32 imageType = 0xfffd0002;
+    const quint32 fileHeaderSize = 16;
+    const quint32 tocEntrySize = 12;
+    const quint32 imageHeaderSize = 36;
+
+    QFile file(filePath);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    QDataStream stream(&file);
+    stream.setByteOrder(QDataStream::LittleEndian);
+
+    stream << quint32(0x72756358) << fileHeaderSize << quint32(0x10000) << quint32(images.count());
+    quint32 position = fileHeaderSize + tocEntrySize * images.count();
+    for (const CursorImage &image : images) {
+        stream << imageType << quint32(image.size) << position;
+        position += imageHeaderSize + image.size * image.size * 4;
+    }
+    for (const CursorImage &image : images) {
+        stream << imageHeaderSize << imageType << quint32(image.size) << quint32(1)
+               << quint32(image.size) << quint32(image.size)
+               << quint32(image.hotspot.x()) << quint32(image.hotspot.y()) << quint32(image.delay);
+        for (int i = 0; i < image.size * image.size; ++i) {
+            stream << quint32(image.color);
+        }
+    }
+}
+
+class TestXcursorTheme : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void testEmpty();
+    void testShape_data();
+    void testShape();
+    void testAnimation();
+    void testInherits();
+    void testUnknownShape();
+
+private:
+    QTemporaryDir m_iconsDir;
+};
+
+void TestXcursorTheme::initTestCase()
+{
+    QVERIFY(m_iconsDir.isValid());
+    // must be set before the first theme gets looked up
+    qputenv("XCURSOR_PATH", QFile::encodeName(m_iconsDir.path()));
+
+    QDir icons(m_iconsDir.path());
+    QVERIFY(icons.mkpath(QStringLiteral("base/cursors")));
+    QVERIFY(icons.mkpath(QStringLiteral("derived/cursors")));
+
+    writeCursor(icons.filePath(QStringLiteral("base/cursors/left_ptr")), {
+        {24, QPoint(4, 4), 0, qRgba(255, 0, 0, 255)},
+        {48, QPoint(8, 8), 0, qRgba(255, 0, 0, 255)},
+    });
+    writeCursor(icons.filePath(QStringLiteral("base/cursors/wait")), {
+        {24, QPoint(12, 12), 100, qRgba(0, 255, 0, 255)},
+        {24, QPoint(12, 12), 50, qRgba(0, 0, 255, 255)},
+    });
+    writeCursor(icons.filePath(QStringLiteral("derived/cursors/left_ptr")), {
+        {24, QPoint(2, 2), 0, qRgba(255, 255, 255, 255)},
+    });
+
+    QFile indexTheme(icons.filePath(QStringLiteral("derived/index.theme")));
+    QVERIFY(indexTheme.open(QIODevice::WriteOnly));
+    indexTheme.write("[Icon Theme]\nInherits=base\n");
+}
+
+void TestXcursorTheme::testEmpty()
+{
+    QVERIFY(KXcursorTheme().isEmpty());
+    QVERIFY(KXcursorTheme::fromTheme(QStringLiteral("doesnotexist"), 24, 1).isEmpty());
+    QVERIFY(!KXcursorTheme::fromTheme(QStringLiteral("base"), 24, 1).isEmpty());
+}
+
+void TestXcursorTheme::testShape_data()
+{
+    QTest::addColumn<int>("size");
+    QTest::addColumn<qreal>("devicePixelRatio");
+    QTest::addColumn<QSize>("imageSize");
+    QTest::addColumn<QPoint>("hotspot");
+
+    QTest::newRow("24") << 24 << 1.0 << QSize(24, 24) << QPoint(4, 4);
+    QTest::newRow("48") << 48 << 1.0 << QSize(48, 48) << QPoint(8, 8);
+    QTest::newRow("24@2x") << 24 << 2.0 << QSize(48, 48) << QPoint(4, 4);
+}
+
+void TestXcursorTheme::testShape()
+{
+    QFETCH(int, size);
+    QFETCH(qreal, devicePixelRatio);
+
+    const KXcursorTheme theme = KXcursorTheme::fromTheme(QStringLiteral("base"), size, devicePixelRatio);
+    QCOMPARE(theme.devicePixelRatio(), devicePixelRatio);
+
+    const QVector<KXcursorSprite> sprites = theme.shape(QByteArrayLiteral("left_ptr"));
+    QCOMPARE(sprites.count(), 1);
+    QTEST(sprites.first().data().size(), "imageSize");
+    QTEST(sprites.first().hotspot(), "hotspot");
+    QCOMPARE(sprites.first().data().pixel(0, 0), qRgba(255, 0, 0, 255));
+
+    // asking again gives the same sprites
+    QCOMPARE(theme.shape(QByteArrayLiteral("left_ptr")).first().data(), sprites.first().data());
+}
+
+void TestXcursorTheme::testAnimation()
+{
+    const KXcursorTheme theme = KXcursorTheme::fromTheme(QStringLiteral("base"), 24, 1);
+    const QVector<KXcursorSprite> sprites = theme.shape(QByteArrayLiteral("wait"));
+    QCOMPARE(sprites.count(), 2);
+    QCOMPARE(sprites[0].delay(), std::chrono::milliseconds(100));
+    QCOMPARE(sprites[0].data().pixel(0, 0), qRgba(0, 255, 0, 255));
+    QCOMPARE(sprites[1].delay(), std::chrono::milliseconds(50));
+    QCOMPARE(sprites[1].data().pixel(0, 0), qRgba(0, 0, 255, 255));
+}
+
+void TestXcursorTheme::testInherits()
+{
+    const KXcursorTheme theme = KXcursorTheme::fromTheme(QStringLiteral("derived"), 24, 1);
+
+    // the theme's own cursor takes precedence over the inherited one
+    const QVector<KXcursorSprite> pointer = theme.shape(QByteArrayLiteral("left_ptr"));
+    QCOMPARE(pointer.count(), 1);
+    QCOMPARE(pointer.first().hotspot(), QPoint(2, 2));
+    QCOMPARE(pointer.first().data().pixel(0, 0), qRgba(255, 255, 255, 255));
+
+    QCOMPARE(theme.shape(QByteArrayLiteral("wait")).count(), 2);
+}
+
+void TestXcursorTheme::testUnknownShape()
+{
+    const KXcursorTheme theme = KXcursorTheme::fromTheme(QStringLiteral("base"), 24, 1);
+    QVERIFY(theme.shape(QByteArrayLiteral("doesnotexist")).isEmpty());
+}
+
+QTEST_GUILESS_MAIN(TestXcursorTheme)
+#include "test_xcursor_theme.moc"
@@ -0,0 +1,187 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2020 KWin developers <kwin@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "../xwl/chunkqueue.h"
+
+#include <QtTest>
+
+#include <thread>
+#include <unistd.h>
+
+using namespace KWin::Xwl;
+
+class TestXwlChunkQueue : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void init();
+    void cleanup();
+    void testChunks();
+    void testFull();
+    void testFinish();
+    void testEndAtChunkBoundary();
+    void testBufferReuse();
+    void benchmarkPipeThroughput_data();
+    void benchmarkPipeThroughput();
+
+private:
+    int m_pipe[2] = {-1, -1};
+};
+
+void TestXwlChunkQueue::init()
+{
+    QCOMPARE(pipe(m_pipe), 0);
+}
+
+void TestXwlChunkQueue::cleanup()
+{
+    for (int &fd : m_pipe) {
+        if (fd != -1) {
+            close(fd);
+            fd = -1;
+        }
+    }
+}
+
+void TestXwlChunkQueue::testChunks()
+{
+    ChunkQueue queue(8, 4);
+    QVERIFY(queue.isEmpty());
+    QVERIFY(!queue.hasCompleteChunk());
+
+    QCOMPARE(write(m_pipe[1], "abcdef", 6), ssize_t(6));
+    QCOMPARE(queue.readFrom(m_pipe[0]), ssize_t(6));
+    QCOMPARE(queue.count(), 1);
+    QVERIFY(!queue.hasCompleteChunk());
+
+    // only fills up the current chunk
+    QCOMPARE(write(m_pipe[1], "ghij", 4), ssize_t(4));
+    QCOMPARE(queue.readFrom(m_pipe[0]), ssize_t(2));
+    QCOMPARE(queue.count(), 1);
+    QVERIFY(queue.hasCompleteChunk());
+
+    QCOMPARE(queue.readFrom(m_pipe[0]), ssize_t(2));
+    QCOMPARE(queue.count(), 2);
+    QCOMPARE(QByteArray(queue.firstData(), queue.firstSize()), QByteArrayLiteral("abcdefgh"));
+
+    queue.removeFirst();
+    QCOMPARE(queue.count(), 1);
+    QVERIFY(!queue.hasCompleteChunk());
+    QCOMPARE(QByteArray(queue.firstData(), queue.firstSize()), QByteArrayLiteral("ij"));
+}
+
+void TestXwlChunkQueue::testFull()
+{
+    ChunkQueue queue(4, 2);
+    QCOMPARE(write(m_pipe[1], "abcdefgh", 8), ssize_t(8));
+    QCOMPARE(queue.readFrom(m_pipe[0]), ssize_t(4));
+    QVERIFY(!queue.isFull());
+    QCOMPARE(queue.readFrom(m_pipe[0]), ssize_t(4));
+    QVERIFY(queue.isFull());
+
+    queue.removeFirst();
+    QVERIFY(!queue.isFull());
+}
+
+void TestXwlChunkQueue::testFinish()
+{
+    ChunkQueue queue(8, 4);
+    QCOMPARE(write(m_pipe[1], "abc", 3), ssize_t(3));
+    close(m_pipe[1]);
+    m_pipe[1] = -1;
+
+    QCOMPARE(queue.readFrom(m_pipe[0]), ssize_t(3));
+    QCOMPARE(queue.readFrom(m_pipe[0]), ssize_t(0));
+    QVERIFY(!queue.hasCompleteChunk());
+    queue.finish();
+    QVERIFY(queue.hasCompleteChunk());
+    QCOMPARE(QByteArray(queue.firstData(), queue.firstSize()), QByteArrayLiteral("abc"));
+}
+
+void TestXwlChunkQueue::testEndAtChunkBoundary()
+{
+    ChunkQueue queue(4, 4);
+    QCOMPARE(write(m_pipe[1], "abcd", 4), ssize_t(4));
+    close(m_pipe[1]);
+    m_pipe[1] = -1;
+
+    QCOMPARE(queue.readFrom(m_pipe[0]), ssize_t(4));
+    QCOMPARE(queue.readFrom(m_pipe[0]), ssize_t(0));
+    queue.finish();
+
+    // an empty chunk marks the end of an incremental transfer
+    QCOMPARE(queue.count(), 2);
+    queue.removeFirst();
+    QVERIFY(queue.hasCompleteChunk());
+    QCOMPARE(queue.firstSize(), 0);
+}
+
+void TestXwlChunkQueue::testBufferReuse()
+{
+    ChunkQueue queue(4, 4);
+    QCOMPARE(write(m_pipe[1], "abcdefgh", 8), ssize_t(8));
+    QCOMPARE(queue.readFrom(m_pipe[0]), ssize_t(4));
+    const char *buffer = queue.firstData();
+    queue.removeFirst();
+
+    QCOMPARE(queue.readFrom(m_pipe[0]), ssize_t(4));
+    QVERIFY(queue.firstData() == buffer);
+    QCOMPARE(QByteArray(queue.firstData(), queue.firstSize()), QByteArrayLiteral("efgh"));
+}
+
+void TestXwlChunkQueue::benchmarkPipeThroughput_data()
+{
+    QTest::addColumn<int>("chunkSize");
+
+    QTest::newRow("4 KiB") << 4 * 1024;
+    QTest::newRow("63 KiB") << 63 * 1024;
+    QTest::newRow("1 MiB") << 1024 * 1024;
+}
+
+void TestXwlChunkQueue::benchmarkPipeThroughput()
+{
+    QFETCH(int, chunkSize);
+    const qint64 totalSize = 64 * 1024 * 1024;
+
+    QBENCHMARK {
+        cleanup();
+        init();
+
+        const int writeFd = m_pipe[1];
+        m_pipe[1] = -1;
+        std::thread writer([writeFd, totalSize]() {
+            const QByteArray block(64 * 1024, 'x');
+            for (qint64 written = 0; written < totalSize;) {
+                const ssize_t length = write(writeFd, block.constData(), block.size());
+                if (length <= 0) {
+                    break;
+                }
+                written += length;
+            }
+            close(writeFd);
+        });
+
+        ChunkQueue queue(chunkSize, 4);
+        qint64 received = 0;
+        for (;;) {
+            const ssize_t length = queue.readFrom(m_pipe[0]);
+            if (length <= 0) {
+                break;
+            }
+            received += length;
+            while (queue.hasCompleteChunk()) {
+                queue.removeFirst();
+            }
+        }
+        writer.join();
+        QCOMPARE(received, totalSize);
+    }
+}
+
+QTEST_GUILESS_MAIN(TestXwlChunkQueue)
+#include "test_xwl_chunk_queue.moc"
@@ -67,6 +67,13 @@ Manager::Manager(QObject *parent)
 
         QDBusConnection::sessionBus().asyncCall(message);
     });
+
+    // Enough for every step of a transition at common ramp sizes
+    m_gammaRamps.setMaxCost(16 * 1024 * 1024);
+}
+
+Manager::~Manager()
+{
 }
 
 void Manager::init()
@@ -622,43 +629,70 @@ int Manager::currentTargetTemp() const
     }
 }
 
+const QVector<double> &Manager::linearRamp(uint32_t size)
+{
+    auto it = m_linearRamps.find(size);
+    if (it == m_linearRamps.end()) {
+        QVector<double> ramp(size);
+        for (uint32_t i = 0; i < size; i++) {
+            ramp[i] = uint16_t((double)i / size * (UINT16_MAX + 1));
+        }
+        it = m_linearRamps.insert(size, ramp);
+    }
+    return *it;
+}
+
+GammaRamp Manager::gammaRamp(int temperature, uint32_t size)
+{
+    const quint64 key = (quint64(uint32_t(temperature)) << 32) | size;
+    if (const GammaRamp *cached = m_gammaRamps.object(key)) {
+        return *cached;
+    }
+
+    GammaRamp *ramp = new GammaRamp(size);
+
+    /*
+     * The gamma calculation below is based on the Redshift app:
+     * https://github.com/jonls/redshift
+     */
+    uint16_t *red = ramp->red();
+    uint16_t *green = ramp->green();
+    uint16_t *blue = ramp->blue();
+
+    // approximate white point
+    float whitePoint[3];
+    float alpha = (temperature % 100) / 100.;
+    int bbCIndex = ((temperature - 1000) / 100) * 3;
+    whitePoint[0] = (1. - alpha) * blackbodyColor[bbCIndex] + alpha * blackbodyColor[bbCIndex + 3];
+    whitePoint[1] = (1. - alpha) * blackbodyColor[bbCIndex + 1] + alpha * blackbodyColor[bbCIndex + 4];
+    whitePoint[2] = (1. - alpha) * blackbodyColor[bbCIndex + 2] + alpha * blackbodyColor[bbCIndex + 5];
+
+    // scale the linear default state, the loops have no dependencies and can be vectorized
+    const double *linear = linearRamp(size).constData();
+    const double redScale = whitePoint[0];
+    const double greenScale = whitePoint[1];
+    const double blueScale = whitePoint[2];
+    for (uint32_t i = 0; i < size; i++) {
+        red[i] = linear[i] * redScale;
+    }
+    for (uint32_t i = 0; i < size; i++) {
+        green[i] = linear[i] * greenScale;
+    }
+    for (uint32_t i = 0; i < size; i++) {
+        blue[i] = linear[i] * blueScale;
+    }
+
+    const GammaRamp result = *ramp;
+    m_gammaRamps.insert(key, ramp, 3 * size * sizeof(uint16_t));
+    return result;
+}
+
 void Manager::commitGammaRamps(int temperature)
 {
     const auto outs = kwinApp()->platform()->outputs();
 
     for (auto *o : outs) {
-        int rampsize = o->gammaRampSize();
-        GammaRamp ramp(rampsize);
-
-        /*
-         * The gamma calculation below is based on the Redshift app:
-         * https://github.com/jonls/redshift
-         */
-        uint16_t *red = ramp.red();
-        uint16_t *green = ramp.green();
-        uint16_t *blue = ramp.blue();
-
-        // linear default state
-        for (int i = 0; i < rampsize; i++) {
-                uint16_t value = (double)i / rampsize * (UINT16_MAX + 1);
-                red[i] = value;
-                green[i] = value;
-                blue[i] = value;
-        }
-
-        // approximate white point
-        float whitePoint[3];
-        float alpha = (temperature % 100) / 100.;
-        int bbCIndex = ((temperature - 1000) / 100) * 3;
-        whitePoint[0] = (1. - alpha) * blackbodyColor[bbCIndex] + alpha * blackbodyColor[bbCIndex + 3];
-        whitePoint[1] = (1. - alpha) * blackbodyColor[bbCIndex + 1] + alpha * blackbodyColor[bbCIndex + 4];
-        whitePoint[2] = (1. - alpha) * blackbodyColor[bbCIndex + 2] + alpha * blackbodyColor[bbCIndex + 5];
-
-        for (int i = 0; i < rampsize; i++) {
-            red[i] = qreal(red[i]) / (UINT16_MAX+1) * whitePoint[0] * (UINT16_MAX+1);
-            green[i] = qreal(green[i]) / (UINT16_MAX+1) * whitePoint[1] * (UINT16_MAX+1);
-            blue[i] = qreal(blue[i]) / (UINT16_MAX+1) * whitePoint[2] * (UINT16_MAX+1);
-        }
+        const GammaRamp ramp = gammaRamp(temperature, o->gammaRampSize());
 
         if (o->setGammaRamp(ramp)) {
             setCurrentTemperature(temperature);
@@ -12,9 +12,12 @@
 #include "constants.h"
 #include <kwin_export.h>
 
+#include <QCache>
+#include <QHash>
 #include <QObject>
 #include <QPair>
 #include <QDateTime>
+#include <QVector>
 
 class QTimer;
 
@@ -22,6 +25,7 @@ namespace KWin
 {
 
 class ClockSkewNotifier;
+class GammaRamp;
 class Workspace;
 
 namespace ColorCorrect
@@ -82,6 +86,7 @@ class KWIN_EXPORT Manager : public QObject
 
 public:
     Manager(QObject *parent);
+    ~Manager() override;
     void init();
 
     /**
@@ -262,6 +267,12 @@ private:
     bool daylight() const;
 
     void commitGammaRamps(int temperature);
+    /**
+     * Returns the gamma ramp with @p size elements for the given @p temperature. The ramps
+     * are cached, so stepping through a transition again doesn't recompute them.
+     */
+    GammaRamp gammaRamp(int temperature, uint32_t size);
+    const QVector<double> &linearRamp(uint32_t size);
 
     void setEnabled(bool enabled);
     void setRunning(bool running);
@@ -308,6 +319,12 @@ private:
     int m_nightTargetTemp = DEFAULT_NIGHT_TEMPERATURE;
 
     int m_failedCommitAttempts = 0;
+
+    // gamma ramps keyed by temperature and size, the cost is the size of the table in bytes
+    QCache<quint64, GammaRamp> m_gammaRamps;
+    // identity ramps keyed by size
+    QHash<uint32_t, QVector<double>> m_linearRamps;
+
     int m_inhibitReferenceCount = 0;
 
     // The Workspace class needs to call initShortcuts during initialization.
@@ -8,6 +8,7 @@
 */
 #include "composite.h"
 
+#include "abstract_output.h"
 #include "dbusinterface.h"
 #include "x11client.h"
 #include "decorations/decoratedclient.h"
@@ -341,12 +342,14 @@ void Compositor::startupWithWorkspace()
 
     if (m_scene->syncsToVBlank()) {
         // If we do vsync, set the fps to the next multiple of the vblank rate.
-        vBlankInterval = milliToNano(1000) / currentRefreshRate();
+        vBlankInterval = milliToNano(1000) / refreshRate();
         fpsInterval = qMax((fpsInterval / vBlankInterval) * vBlankInterval, vBlankInterval);
     } else {
         // No vsync - DO NOT set "0", would cause div-by-zero segfaults.
         vBlankInterval = milliToNano(1);
     }
+    m_renderTimePredictor.reset();
+    m_renderTimePredictor.setFallbackTime(options->vBlankTime());
 
     // Sets also the 'effects' pointer.
     kwinApp()->platform()->createEffectsHandler(this, m_scene);
@@ -590,15 +593,88 @@ void Compositor::bufferSwapComplete()
 
     if (m_composeAtSwapCompletion) {
         m_composeAtSwapCompletion = false;
+        performCompositingAfterSwap();
+    }
+}
+
+void Compositor::aboutToSwapBuffers(AbstractOutput *output)
+{
+    Q_ASSERT(!m_outputsWithPendingSwap.contains(output));
+
+    m_outputsWithPendingSwap.insert(output);
+    connect(output, &QObject::destroyed, this, [this, output]() {
+        if (m_outputsWithPendingSwap.contains(output)) {
+            bufferSwapComplete(output);
+        }
+    }, Qt::UniqueConnection);
+}
+
+void Compositor::bufferSwapComplete(AbstractOutput *output)
+{
+    if (!m_outputsWithPendingSwap.remove(output)) {
+        // The page flip might have been dropped, e.g. on a VT switch.
+        return;
+    }
+
+    emit bufferSwapCompleted();
+
+    // Only compose if we have been waiting for this output, i.e. all other outputs
+    // are either busy as well or don't have anything to repaint.
+    if (m_composeAtSwapCompletion && !m_bufferSwapPending) {
+        m_composeAtSwapCompletion = false;
+        performCompositingAfterSwap();
+    }
+}
+
+void Compositor::performCompositingAfterSwap()
+{
+    // The buffer swap has just completed, so the next vblank is about one refresh cycle
+    // away. Start compositing as late as possible to still make it, this reduces the
+    // latency between input and the frame showing up on the screen.
+    const qint64 delay = vBlankInterval - m_renderTimePredictor.predict();
+    if (!m_scene || !m_scene->syncsToVBlank() || delay < milliToNano(1)) {
         performCompositing();
+        return;
     }
+    compositeTimer.start(nanoToMilli(delay), Qt::PreciseTimer, this);
+}
+
+bool Compositor::isOutputReady(AbstractOutput *output) const
+{
+    return !m_outputsWithPendingSwap.contains(output);
+}
+
+bool Compositor::allOutputsBusy() const
+{
+    if (m_outputsWithPendingSwap.isEmpty()) {
+        return false;
+    }
+    const auto outputs = kwinApp()->platform()->enabledOutputs();
+    return std::all_of(outputs.constBegin(), outputs.constEnd(), [this](AbstractOutput *output) {
+        return m_outputsWithPendingSwap.contains(output);
+    });
+}
+
+QRegion Compositor::readyOutputsRegion() const
+{
+    if (m_outputsWithPendingSwap.isEmpty()) {
+        return QRegion(QRect(QPoint(0, 0), screens()->size()));
+    }
+    QRegion region;
+    for (int i = 0; i < screens()->count(); ++i) {
+        AbstractOutput *output = kwinApp()->platform()->findOutput(i);
+        if (!output || isOutputReady(output)) {
+            region += screens()->geometry(i);
+        }
+    }
+    return region;
 }
 
 void Compositor::performCompositing()
 {
     // If a buffer swap is still pending, we return to the event loop and
     // continue processing events until the swap has completed.
-    if (m_bufferSwapPending) {
+    if (m_bufferSwapPending || allOutputsBusy()) {
         m_composeAtSwapCompletion = true;
         compositeTimer.stop();
         return;
@@ -653,7 +729,7 @@ void Compositor::performCompositing()
 
     if (repaints_region.isEmpty() && !windowRepaintsPending()) {
         m_scene->idle();
-        m_timeSinceLastVBlank = fpsInterval - (options->vBlankTime() + 1); // means "start now"
+        m_timeSinceLastVBlank = fpsInterval - (m_renderTimePredictor.predict() + 1); // means "start now"
         // Note: It would seem here we should undo suspended unredirect, but when scenes need
         // it for some reason, e.g. transformations or translucency, the next pass that does not
         // need this anymore and paints normally will also reset the suspended unredirect.
@@ -683,10 +759,31 @@ void Compositor::performCompositing()
     // clear all repaints, so that post-pass can add repaints for the next repaint
     repaints_region = QRegion();
 
+    if (!m_outputsWithPendingSwap.isEmpty()) {
+        // Outputs with a pending page flip are skipped in this pass. Carry the part of
+        // the damage which belongs to them over to the pass after their page flip. The
+        // scene resets the window repaints, so they become screen damage at that point.
+        // Otherwise the window repaints are left to the scene, effects rely on telling
+        // them apart from the screen damage.
+        QRegion damage = repaints;
+        for (Toplevel *win : qAsConst(windows)) {
+            damage |= win->repaints();
+        }
+        const QRegion readyRegion = readyOutputsRegion();
+        repaints_region = damage - readyRegion;
+        if (!damage.intersects(readyRegion)) {
+            m_composeAtSwapCompletion = true;
+            compositeTimer.stop();
+            return;
+        }
+        repaints &= readyRegion;
+    }
+
     if (m_framesToTestForSafety > 0 && (m_scene->compositingType() & OpenGLCompositing)) {
         kwinApp()->platform()->createOpenGLSafePoint(Platform::OpenGLSafePoint::PreFrame);
     }
     m_timeSinceLastVBlank = m_scene->paint(repaints, windows);
+    m_renderTimePredictor.addSample(m_scene->cpuRenderTime(), m_scene->gpuRenderTime());
     if (m_framesToTestForSafety > 0) {
         if (m_scene->compositingType() & OpenGLCompositing) {
             kwinApp()->platform()->createOpenGLSafePoint(Platform::OpenGLSafePoint::PostFrame);
@@ -715,7 +812,7 @@ void Compositor::performCompositing()
     // is called the next time. If there would be nothing pending, it will not restart the timer and
     // scheduleRepaint() would restart it again somewhen later, called from functions that
     // would again add something pending.
-    if (m_bufferSwapPending && m_scene->syncsToVBlank()) {
+    if ((m_bufferSwapPending || allOutputsBusy()) && m_scene->syncsToVBlank()) {
         m_composeAtSwapCompletion = true;
     } else {
         scheduleRepaint();
@@ -766,7 +863,7 @@ void Compositor::setCompositeTimer()
     }
 
     // Don't start the timer if we're waiting for a swap event
-    if (m_bufferSwapPending && m_composeAtSwapCompletion)
+    if ((m_bufferSwapPending || allOutputsBusy()) && m_composeAtSwapCompletion)
         return;
 
     // Don't start the timer if all outputs are disabled
@@ -778,11 +875,10 @@ void Compositor::setCompositeTimer()
 
     if (m_scene->blocksForRetrace()) {
 
-        // TODO: make vBlankTime dynamic?!
-        // It's required because glXWaitVideoSync will *likely* block a full frame if one enters
-        // a retrace pass which can last a variable amount of time, depending on the actual screen
-        // Now, my ooold 19" CRT can do such retrace so that 2ms are entirely sufficient,
-        // while another ooold 15" TFT requires about 6ms
+        // The time we need to render a frame is predicted from the recent frames. Before
+        // anything has been rendered the configured vBlankTime is used.
+        // If rendering takes longer than a refresh cycle, we can't make it anyway.
+        const qint64 renderTime = qMin(m_renderTimePredictor.predict(), vBlankInterval);
 
         qint64 padding = m_timeSinceLastVBlank;
         if (padding > fpsInterval) {
@@ -796,11 +892,11 @@ void Compositor::setCompositeTimer()
                        (fpsInterval / vBlankInterval - 1) * vBlankInterval);
         }
 
-        if (padding < options->vBlankTime()) {
+        if (padding < renderTime) {
             // We'll likely miss this frame so we add one:
-            waitTime = nanoToMilli(padding + vBlankInterval - options->vBlankTime());
+            waitTime = nanoToMilli(padding + vBlankInterval - renderTime);
         } else {
-            waitTime = nanoToMilli(padding - options->vBlankTime());
+            waitTime = nanoToMilli(padding - renderTime);
         }
     }
     else { // w/o blocking vsync we just jump to the next demanded tick
@@ -868,10 +964,21 @@ void WaylandCompositor::start()
 
 int WaylandCompositor::refreshRate() const
 {
-    // TODO: This makes no sense on Wayland. First step would be to atleast
-    //       set the refresh rate to the highest available one. Second step
-    //       would be to not use a uniform value at all but per screen.
-    return KWin::currentRefreshRate();
+    if (options->refreshRate() > 0) {
+        return KWin::currentRefreshRate();
+    }
+    // Drive the repaint loop by the fastest output. Slower outputs are throttled by
+    // their own page flips, see aboutToSwapBuffers(AbstractOutput*).
+    int refreshRate = 0;
+    const auto outputs = kwinApp()->platform()->enabledOutputs();
+    for (AbstractOutput *output : outputs) {
+        refreshRate = qMax(refreshRate, output->refreshRate());
+    }
+    if (refreshRate <= 0) {
+        return KWin::currentRefreshRate();
+    }
+    // AbstractOutput::refreshRate() is in mHz
+    return qBound(1, qRound(refreshRate / 1000.0), 1000);
 }
 
 X11Compositor::X11Compositor(QObject *parent)
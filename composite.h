@@ -11,14 +11,18 @@
 
 #include <kwinglobals.h>
 
+#include "rendertimepredictor.h"
+
 #include <QObject>
 #include <QElapsedTimer>
 #include <QTimer>
 #include <QBasicTimer>
 #include <QRegion>
+#include <QSet>
 
 namespace KWin
 {
+class AbstractOutput;
 class CompositorSelectionOwner;
 class Scene;
 class X11Client;
@@ -61,6 +65,26 @@ public:
      */
     void bufferSwapComplete();
 
+    /**
+     * Notifies the compositor that a page flip has been scheduled on the given @p output.
+     *
+     * Unlike aboutToSwapBuffers(), only the given output is blocked until the
+     * matching bufferSwapComplete(AbstractOutput*) call. The remaining outputs
+     * keep being repainted at their own pace.
+     */
+    void aboutToSwapBuffers(AbstractOutput *output);
+
+    /**
+     * Notifies the compositor that a pending page flip on the given @p output has completed.
+     */
+    void bufferSwapComplete(AbstractOutput *output);
+
+    /**
+     * Returns @c true if a new frame can be rendered for the given @p output, i.e. there
+     * is no pending page flip on it; otherwise returns @c false.
+     */
+    bool isOutputReady(AbstractOutput *output) const;
+
     /**
      * Toggles compositing, that is if the Compositor is suspended it will be resumed
      * and if the Compositor is active it will be suspended.
@@ -94,6 +118,13 @@ public:
         return s_compositor != nullptr && s_compositor->isActive();
     }
 
+    /**
+     * Returns the render time predictor used to schedule the start of compositing.
+     */
+    const RenderTimePredictor &renderTimePredictor() const {
+        return m_renderTimePredictor;
+    }
+
     // for delayed supportproperty management of effects
     void keepSupportProperty(xcb_atom_t atom);
     void removeSupportProperty(xcb_atom_t atom);
@@ -135,6 +166,9 @@ private:
 
     void setCompositeTimer();
     bool windowRepaintsPending() const;
+    bool allOutputsBusy() const;
+    void performCompositingAfterSwap();
+    QRegion readyOutputsRegion() const;
 
     void releaseCompositorSelection();
     void deleteUnusedSupportProperties();
@@ -150,11 +184,13 @@ private:
     QRegion repaints_region;
 
     qint64 m_timeSinceLastVBlank;
+    RenderTimePredictor m_renderTimePredictor;
 
     Scene *m_scene;
 
     bool m_bufferSwapPending;
     bool m_composeAtSwapCompletion;
+    QSet<AbstractOutput *> m_outputsWithPendingSwap;
 
     int m_framesToTestForSafety = 3;
     QElapsedTimer m_monotonicClock;
@@ -296,6 +296,21 @@ bool CompositorDBusInterface::platformRequiresCompositing() const
     return kwinApp()->platform()->requiresCompositing();
 }
 
+qlonglong CompositorDBusInterface::predictedRenderTime() const
+{
+    return m_compositor->renderTimePredictor().predict();
+}
+
+qlonglong CompositorDBusInterface::lastCpuRenderTime() const
+{
+    return m_compositor->renderTimePredictor().lastCpuTime();
+}
+
+qlonglong CompositorDBusInterface::lastGpuRenderTime() const
+{
+    return m_compositor->renderTimePredictor().lastGpuTime();
+}
+
 void CompositorDBusInterface::resume()
 {
     if (kwinApp()->operationMode() == Application::OperationModeX11) {
@@ -112,6 +112,22 @@ class CompositorDBusInterface : public QObject
      */
     Q_PROPERTY(QStringList supportedOpenGLPlatformInterfaces READ supportedOpenGLPlatformInterfaces)
     Q_PROPERTY(bool platformRequiresCompositing READ platformRequiresCompositing)
+    /**
+     * @brief The predicted time in nanoseconds needed to render the next frame.
+     *
+     * The Compositor starts compositing this long before the next vblank.
+     */
+    Q_PROPERTY(qlonglong predictedRenderTime READ predictedRenderTime)
+    /**
+     * @brief The CPU time in nanoseconds spent on painting the last frame.
+     */
+    Q_PROPERTY(qlonglong lastCpuRenderTime READ lastCpuRenderTime)
+    /**
+     * @brief The GPU time in nanoseconds spent on the last frame whose timing is known.
+     *
+     * @c 0 if the Scene doesn't support measuring the GPU time.
+     */
+    Q_PROPERTY(qlonglong lastGpuRenderTime READ lastGpuRenderTime)
 public:
     explicit CompositorDBusInterface(Compositor *parent);
     ~CompositorDBusInterface() override = default;
@@ -123,6 +139,9 @@ public:
     QString compositingType() const;
     QStringList supportedOpenGLPlatformInterfaces() const;
     bool platformRequiresCompositing() const;
+    qlonglong predictedRenderTime() const;
+    qlonglong lastCpuRenderTime() const;
+    qlonglong lastGpuRenderTime() const;
 
 public Q_SLOTS:
     /**
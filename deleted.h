@@ -144,6 +144,13 @@ public:
         return m_transientFor.contains(const_cast<Toplevel *>(toplevel));
     }
 
+    /**
+     * Returns the windows this client was a transient for.
+     */
+    QList<Toplevel *> mainWindows() const {
+        return m_transientFor;
+    }
+
     /**
      * Returns the list of transients.
      *
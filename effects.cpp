@@ -411,20 +411,61 @@ void EffectsHandlerImpl::postPaintScreen()
     // no special final code
 }
 
+quint64 EffectsHandlerImpl::windowInterest(EffectWindow *w)
+{
+    EffectWindowImpl *windowImpl = static_cast<EffectWindowImpl *>(w);
+    if (!windowImpl->hasEffectInterest(m_paintPass)) {
+        quint64 interest = 0;
+        const int count = qMin(m_activeEffects.count(), 64);
+        for (int i = 0; i < count; ++i) {
+            if (m_activeEffects.at(i)->isActiveForWindow(w)) {
+                interest |= quint64(1) << i;
+            }
+        }
+        windowImpl->setEffectInterest(m_paintPass, interest);
+    }
+    return windowImpl->effectInterest();
+}
+
+// skips the effects which are not interested in the window, effects past the 64th are always called
+EffectsHandlerImpl::EffectsIterator EffectsHandlerImpl::nextEffectForWindow(EffectsIterator it, EffectWindow *w, quint64 extraInterest)
+{
+    const int index = it - m_activeEffects.constBegin();
+    if (index >= 64 || it == m_activeEffects.constEnd()) {
+        return it;
+    }
+    const quint64 interest = (windowInterest(w) | extraInterest) >> index;
+    if (interest) {
+        return it + qCountTrailingZeroBits(interest);
+    }
+    return m_activeEffects.constBegin() + qMin(m_activeEffects.count(), 64);
+}
+
+bool EffectsHandlerImpl::hasEffectsForWindow(EffectWindow *w)
+{
+    return nextEffectForWindow(m_activeEffects.constBegin(), w) != m_activeEffects.constEnd();
+}
+
 void EffectsHandlerImpl::prePaintWindow(EffectWindow* w, WindowPrePaintData& data, int time)
 {
-    if (m_currentPaintWindowIterator != m_activeEffects.constEnd()) {
-        (*m_currentPaintWindowIterator++)->prePaintWindow(w, data, time);
-        --m_currentPaintWindowIterator;
+    const EffectsIterator savedIterator = m_currentPaintWindowIterator;
+    const EffectsIterator it = nextEffectForWindow(savedIterator, w, m_prePaintAllWindowsInterest);
+    if (it != m_activeEffects.constEnd()) {
+        m_currentPaintWindowIterator = it + 1;
+        (*it)->prePaintWindow(w, data, time);
+        m_currentPaintWindowIterator = savedIterator;
     }
     // no special final code
 }
 
 void EffectsHandlerImpl::paintWindow(EffectWindow* w, int mask, const QRegion &region, WindowPaintData& data)
 {
-    if (m_currentPaintWindowIterator != m_activeEffects.constEnd()) {
-        (*m_currentPaintWindowIterator++)->paintWindow(w, mask, region, data);
-        --m_currentPaintWindowIterator;
+    const EffectsIterator savedIterator = m_currentPaintWindowIterator;
+    const EffectsIterator it = nextEffectForWindow(savedIterator, w);
+    if (it != m_activeEffects.constEnd()) {
+        m_currentPaintWindowIterator = it + 1;
+        (*it)->paintWindow(w, mask, region, data);
+        m_currentPaintWindowIterator = savedIterator;
     } else
         m_scene->finalPaintWindow(static_cast<EffectWindowImpl*>(w), mask, region, data);
 }
@@ -442,9 +483,12 @@ void EffectsHandlerImpl::paintEffectFrame(EffectFrame* frame, const QRegion &reg
 
 void EffectsHandlerImpl::postPaintWindow(EffectWindow* w)
 {
-    if (m_currentPaintWindowIterator != m_activeEffects.constEnd()) {
-        (*m_currentPaintWindowIterator++)->postPaintWindow(w);
-        --m_currentPaintWindowIterator;
+    const EffectsIterator savedIterator = m_currentPaintWindowIterator;
+    const EffectsIterator it = nextEffectForWindow(savedIterator, w);
+    if (it != m_activeEffects.constEnd()) {
+        m_currentPaintWindowIterator = it + 1;
+        (*it)->postPaintWindow(w);
+        m_currentPaintWindowIterator = savedIterator;
     }
     // no special final code
 }
@@ -459,9 +503,12 @@ Effect *EffectsHandlerImpl::provides(Effect::Feature ef)
 
 void EffectsHandlerImpl::drawWindow(EffectWindow* w, int mask, const QRegion &region, WindowPaintData& data)
 {
-    if (m_currentDrawWindowIterator != m_activeEffects.constEnd()) {
-        (*m_currentDrawWindowIterator++)->drawWindow(w, mask, region, data);
-        --m_currentDrawWindowIterator;
+    const EffectsIterator savedIterator = m_currentDrawWindowIterator;
+    const EffectsIterator it = nextEffectForWindow(savedIterator, w);
+    if (it != m_activeEffects.constEnd()) {
+        m_currentDrawWindowIterator = it + 1;
+        (*it)->drawWindow(w, mask, region, data);
+        m_currentDrawWindowIterator = savedIterator;
     } else
         m_scene->finalDrawWindow(static_cast<EffectWindowImpl*>(w), mask, region, data);
 }
@@ -506,12 +553,29 @@ void EffectsHandlerImpl::startPaint()
             m_activeEffects << it->second;
         }
     }
+    m_prePaintAllWindowsInterest = 0;
+    for (int i = 0; i < qMin(m_activeEffects.count(), 64); ++i) {
+        if (m_activeEffects.at(i)->prePaintsAllWindows()) {
+            m_prePaintAllWindowsInterest |= quint64(1) << i;
+        }
+    }
+    ++m_paintPass;
     m_currentDrawWindowIterator = m_activeEffects.constBegin();
     m_currentPaintWindowIterator = m_activeEffects.constBegin();
     m_currentPaintScreenIterator = m_activeEffects.constBegin();
     m_currentPaintEffectFrameIterator = m_activeEffects.constBegin();
 }
 
+bool EffectsHandlerImpl::blocksDirectScanout() const
+{
+    for (auto it = loaded_effects.constBegin(); it != loaded_effects.constEnd(); ++it) {
+        if (it->second->isActive() && it->second->blocksDirectScanout()) {
+            return true;
+        }
+    }
+    return false;
+}
+
 void EffectsHandlerImpl::slotClientMaximized(KWin::AbstractClient *c, MaximizeMode maxMode)
 {
     bool horizontal = false;
@@ -1497,6 +1561,8 @@ void EffectsHandlerImpl::effectsChanged()
 {
     loaded_effects.clear();
     m_activeEffects.clear(); // it's possible to have a reconfigure and a quad rebuild between two paint cycles - bug #308201
+    m_prePaintAllWindowsInterest = 0;
+    ++m_paintPass;
 
     loaded_effects.reserve(effect_order.count());
     std::copy(effect_order.constBegin(), effect_order.constEnd(),
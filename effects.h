@@ -125,6 +125,11 @@ public:
     EffectWindowList stackingOrder() const override;
     void setElevatedWindow(KWin::EffectWindow* w, bool set) override;
 
+    /**
+     * Returns @c true if any active effect wants to paint @p w in the current frame.
+     */
+    bool hasEffectsForWindow(EffectWindow *w);
+
     void setTabBoxWindow(EffectWindow*) override;
     void setTabBoxDesktop(int) override;
     EffectWindowList currentTabBoxWindowList() const override;
@@ -191,6 +196,7 @@ public:
 
     // internal (used by kwin core or compositing code)
     void startPaint();
+    bool blocksDirectScanout() const;
     void grabbedKeyboardEvent(QKeyEvent* e);
     bool hasKeyboardGrab() const;
     void desktopResized(const QSize &size);
@@ -335,7 +341,14 @@ private:
 
     typedef QVector< Effect*> EffectsList;
     typedef EffectsList::const_iterator EffectsIterator;
+    EffectsIterator nextEffectForWindow(EffectsIterator it, EffectWindow *w, quint64 extraInterest = 0);
+    quint64 windowInterest(EffectWindow *w);
+
     EffectsList m_activeEffects;
+    // incremented on every startPaint(), invalidates the interest masks of all windows
+    quint64 m_paintPass = 0;
+    // the active effects which want prePaintWindow() to be called for every window
+    quint64 m_prePaintAllWindowsInterest = 0;
     EffectsIterator m_currentDrawWindowIterator;
     EffectsIterator m_currentPaintWindowIterator;
     EffectsIterator m_currentPaintEffectFrameIterator;
@@ -484,6 +497,18 @@ public:
 
     void elevate(bool elevate);
 
+    // internal, bit n is set if the n-th active effect wants to paint this window in the paint pass
+    bool hasEffectInterest(quint64 paintPass) const {
+        return m_effectInterestPass == paintPass;
+    }
+    quint64 effectInterest() const {
+        return m_effectInterest;
+    }
+    void setEffectInterest(quint64 paintPass, quint64 interest) {
+        m_effectInterestPass = paintPass;
+        m_effectInterest = interest;
+    }
+
     void setData(int role, const QVariant &data) override;
     QVariant data(int role) const override;
 
@@ -507,6 +532,8 @@ private:
     QHash<WindowThumbnailItem*, QPointer<EffectWindowImpl> > m_thumbnails;
     QList<DesktopThumbnailItem*> m_desktopThumbnails;
     bool managed = false;
+    quint64 m_effectInterestPass = 0;
+    quint64 m_effectInterest = 0;
     bool waylandClient;
     bool x11Client;
 };
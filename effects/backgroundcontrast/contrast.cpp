@@ -516,5 +516,22 @@ bool ContrastEffect::isActive() const
     return !effects->isScreenLocked();
 }
 
+bool ContrastEffect::isActiveForWindow(EffectWindow *w) const
+{
+    // drawWindow() passes on all windows without a contrast region untouched
+    return !contrastRegion(w).isEmpty();
+}
+
+bool ContrastEffect::prePaintsAllWindows() const
+{
+    // prePaintWindow() keeps track of what got painted underneath the contrast regions
+    return true;
+}
+
+bool ContrastEffect::blocksDirectScanout() const
+{
+    return false;
+}
+
 } // namespace KWin
 
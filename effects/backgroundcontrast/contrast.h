@@ -44,11 +44,15 @@ public:
 
     bool provides(Feature feature) override;
     bool isActive() const override;
+    bool isActiveForWindow(EffectWindow *w) const override;
+    bool prePaintsAllWindows() const override;
 
     int requestedEffectChainPosition() const override {
         return 76;
     }
 
+    bool blocksDirectScanout() const override;
+
     bool eventFilter(QObject *watched, QEvent *event) override;
 
 public Q_SLOTS:
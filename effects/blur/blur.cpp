@@ -97,6 +97,9 @@ void BlurEffect::deleteFBOs()
 
     m_renderTargets.clear();
     m_renderTextures.clear();
+
+    // the cached backgrounds are copies of the render textures
+    m_blurCache.clear();
 }
 
 void BlurEffect::updateTexture()
@@ -321,6 +324,12 @@ void BlurEffect::slotWindowAdded(EffectWindow *w)
 
 void BlurEffect::slotWindowDeleted(EffectWindow *w)
 {
+    if (m_blurCache.contains(w)) {
+        effects->makeOpenGLContextCurrent();
+        m_blurCache.remove(w);
+        effects->doneOpenGLContextCurrent();
+    }
+
     auto it = windowBlurChangedConnections.find(w);
     if (it == windowBlurChangedConnections.end()) {
         return;
@@ -484,6 +493,8 @@ void BlurEffect::prePaintWindow(EffectWindow* w, WindowPrePaintData& data, int t
     effects->prePaintWindow(w, data, time);
 
     if (!w->isPaintingEnabled()) {
+        // we don't see what happens underneath the window in the meantime
+        invalidateBlurCache(w);
         return;
     }
     if (!m_shader || !m_shader->isValid()) {
@@ -508,12 +519,20 @@ void BlurEffect::prePaintWindow(EffectWindow* w, WindowPrePaintData& data, int t
 
     // in case this window has regions to be blurred
     const QRect screen = effects->virtualScreenGeometry();
-    const QRegion blurArea = blurRegion(w).translated(w->pos()) & screen;
+    const QRegion windowBlurArea = blurRegion(w).translated(w->pos());
+    const QRegion blurArea = windowBlurArea & screen;
     const QRegion expandedBlur = (w->isDock() ? blurArea : expand(blurArea)) & screen;
 
+    // the blurred background is only outdated if something underneath it is painted again;
+    // m_paintedArea holds the damage of the windows below, not the one of this window
+    if (m_paintedArea.intersects(expandedBlur)) {
+        invalidateBlurCache(w);
+    }
+
     // if this window or a window underneath the blurred area is painted again we have to
-    // blur everything
-    if (m_paintedArea.intersects(expandedBlur) || data.paint.intersects(blurArea)) {
+    // blur everything, unless only the window itself changed and its background is cached
+    if (m_paintedArea.intersects(expandedBlur)
+            || (data.paint.intersects(blurArea) && !isBlurCached(w, windowBlurArea))) {
         data.paint |= expandedBlur;
         // we have to check again whether we do not damage a blurred area
         // of a window
@@ -558,7 +577,8 @@ void BlurEffect::drawWindow(EffectWindow *w, int mask, const QRegion &region, Wi
 {
     const QRect screen = GLRenderTarget::virtualScreenGeometry();
     if (shouldBlur(w, mask, data)) {
-        QRegion shape = region & blurRegion(w).translated(w->pos()) & screen;
+        const QRegion blurArea = blurRegion(w).translated(w->pos());
+        QRegion shape = region & blurArea & screen;
 
         // let's do the evil parts - someone wants to blur behind a transformed window
         const bool translated = data.xTranslation() || data.yTranslation();
@@ -583,9 +603,12 @@ void BlurEffect::drawWindow(EffectWindow *w, int mask, const QRegion &region, Wi
         
         EffectWindow* modal = w->transientFor();
         const bool transientForIsDock = (modal ? modal->isDock() : false);
+        const bool isDock = w->isDock() || transientForIsDock;
 
         if (!shape.isEmpty()) {
-            doBlur(shape, screen, data.opacity(), data.screenProjectionMatrix(), w->isDock() || transientForIsDock, w->geometry());
+            // the background of transformed windows changes all the time, don't bother caching it
+            BlurCache *cache = (scaled || translated) ? nullptr : blurCache(w, screen, blurArea, isDock);
+            doBlur(shape, screen, data.opacity(), data.screenProjectionMatrix(), isDock, w->geometry(), cache);
         }
     }
 
@@ -633,7 +656,108 @@ void BlurEffect::generateNoiseTexture()
     m_noiseTexture.setWrapMode(GL_REPEAT);
 }
 
-void BlurEffect::doBlur(const QRegion& shape, const QRect& screen, const float opacity, const QMatrix4x4 &screenProjection, bool isDock, QRect windowRect)
+BlurEffect::BlurCache *BlurEffect::blurCache(EffectWindow *w, const QRect &screen, const QRegion &blurArea, bool isDock)
+{
+    QVector<BlurCache> &caches = m_blurCache[w];
+    auto it = std::find_if(caches.begin(), caches.end(),
+        [&screen](const BlurCache &cache) {
+            return cache.screen == screen;
+        });
+    if (it == caches.end()) {
+        caches.append(BlurCache());
+        it = caches.end() - 1;
+        it->screen = screen;
+    }
+    if (it->blurArea != blurArea || it->isDock != isDock) {
+        // the window moved or its blur region changed, the texture can be reused though
+        it->blurArea = blurArea;
+        it->isDock = isDock;
+        it->shape = QRegion();
+    }
+    return &(*it);
+}
+
+bool BlurEffect::isBlurCached(const EffectWindow *w, const QRegion &blurArea) const
+{
+    const auto it = m_blurCache.constFind(w);
+    if (it == m_blurCache.constEnd()) {
+        return false;
+    }
+    QRegion cached;
+    for (const BlurCache &cache : *it) {
+        if (cache.blurArea == blurArea) {
+            cached |= cache.shape;
+        }
+    }
+    return !cached.isEmpty() && (blurArea & effects->virtualScreenGeometry()).subtracted(cached).isEmpty();
+}
+
+void BlurEffect::invalidateBlurCache(const EffectWindow *w)
+{
+    auto it = m_blurCache.find(w);
+    if (it == m_blurCache.end()) {
+        return;
+    }
+    for (BlurCache &cache : *it) {
+        cache.shape = QRegion();
+    }
+}
+
+/**
+ * Copies @p sourceRect of the texture attached to @p source to @p destinationPos in
+ * @p destination. Both are in OpenGL coordinates, i.e. y points upwards.
+ */
+static void copyTexture(GLRenderTarget *source, const QRect &sourceRect, GLTexture &destination, const QPoint &destinationPos)
+{
+    GLRenderTarget::pushRenderTarget(source);
+    destination.bind();
+    glCopyTexSubImage2D(destination.target(), 0, destinationPos.x(), destinationPos.y(),
+                        sourceRect.x(), sourceRect.y(), sourceRect.width(), sourceRect.height());
+    destination.unbind();
+    GLRenderTarget::popRenderTarget();
+}
+
+// Converts @p rect between y pointing downwards and OpenGL coordinates in a texture of the given height
+static QRect flipped(const QRect &rect, int height)
+{
+    return QRect(rect.x(), height - rect.y() - rect.height(), rect.width(), rect.height());
+}
+
+void BlurEffect::storeBlurCache(BlurCache &cache, const QRegion &shape, const QRect &textureRect)
+{
+    // The final pass samples m_renderTextures[1], which has half the size of the screen, around
+    // the shape. textureRect covers all of it, add a pixel to be on the safe side when rounding.
+    const GLTexture &blurred = m_renderTextures[1];
+    const QRect rect = QRect(QPoint(textureRect.left() / 2 - 1, textureRect.top() / 2 - 1),
+                             QPoint((textureRect.right() + 1) / 2 + 1, (textureRect.bottom() + 1) / 2 + 1))
+                       & QRect(QPoint(0, 0), blurred.size());
+    if (rect.isEmpty()) {
+        cache.shape = QRegion();
+        return;
+    }
+
+    if (cache.texture.isNull() || cache.texture.size() != rect.size()) {
+        cache.texture = GLTexture(blurred.internalFormat(), rect.size());
+        cache.renderTarget.reset(new GLRenderTarget(cache.texture));
+    }
+    if (!cache.renderTarget->valid()) {
+        cache.shape = QRegion();
+        return;
+    }
+    copyTexture(m_renderTargets[1], flipped(rect, blurred.height()), cache.texture, QPoint(0, 0));
+
+    cache.rect = rect;
+    cache.shape = shape;
+}
+
+void BlurEffect::restoreBlurCache(BlurCache &cache)
+{
+    GLTexture &blurred = m_renderTextures[1];
+    copyTexture(cache.renderTarget.data(), QRect(QPoint(0, 0), cache.rect.size()),
+                blurred, flipped(cache.rect, blurred.height()).topLeft());
+}
+
+void BlurEffect::doBlur(const QRegion& shape, const QRect& screen, const float opacity, const QMatrix4x4 &screenProjection, bool isDock, QRect windowRect, BlurCache *cache)
 {
     // Blur would not render correctly on a secondary monitor because of wrong coordinates
     // BUG: 393723
@@ -644,48 +768,64 @@ void BlurEffect::doBlur(const QRegion& shape, const QRect& screen, const float o
 
     const bool useSRGB = m_renderTextures.first().internalFormat() == GL_SRGB8_ALPHA8;
 
+    // Nothing underneath the window changed since the last time, so the result of the
+    // down and upsample iterations is still around
+    const bool cached = cache && !cache->shape.isEmpty() && shape.subtracted(cache->shape).isEmpty();
+
     // Upload geometry for the down and upsample iterations
     GLVertexBuffer *vbo = GLVertexBuffer::streamingBuffer();
     vbo->reset();
 
-    uploadGeometry(vbo, expandedBlurRegion.translated(xTranslate, yTranslate), shape);
+    uploadGeometry(vbo, cached ? QRegion() : expandedBlurRegion.translated(xTranslate, yTranslate), shape);
     vbo->bindArrays();
 
-    const QRect sourceRect = expandedBlurRegion.boundingRect() & screen;
-    const QRect destRect = sourceRect.translated(xTranslate, yTranslate);
-
-    GLRenderTarget::pushRenderTargets(m_renderTargetStack);
-    int blurRectCount = expandedBlurRegion.rectCount() * 6;
+    int blurRectCount = 0;
 
-    /*
-     * If the window is a dock or panel we avoid the "extended blur" effect.
-     * Extended blur is when windows that are not under the blurred area affect
-     * the final blur result.
-     * We want to avoid this on panels, because it looks really weird and ugly
-     * when maximized windows or windows near the panel affect the dock blur.
-     */
-    if (isDock) {
-        m_renderTargets.last()->blitFromFramebuffer(sourceRect, destRect);
+    if (cached) {
+        restoreBlurCache(*cache);
+        ++m_cachedBlurCount;
 
         if (useSRGB) {
             glEnable(GL_FRAMEBUFFER_SRGB);
         }
-
-        copyScreenSampleTexture(vbo, blurRectCount, shape.translated(xTranslate, yTranslate), screenProjection);
     } else {
-        m_renderTargets.first()->blitFromFramebuffer(sourceRect, destRect);
+        const QRect sourceRect = expandedBlurRegion.boundingRect() & screen;
+        const QRect destRect = sourceRect.translated(xTranslate, yTranslate);
+
+        GLRenderTarget::pushRenderTargets(m_renderTargetStack);
+        blurRectCount = expandedBlurRegion.rectCount() * 6;
+
+        /*
+         * If the window is a dock or panel we avoid the "extended blur" effect.
+         * Extended blur is when windows that are not under the blurred area affect
+         * the final blur result.
+         * We want to avoid this on panels, because it looks really weird and ugly
+         * when maximized windows or windows near the panel affect the dock blur.
+         */
+        if (isDock) {
+            m_renderTargets.last()->blitFromFramebuffer(sourceRect, destRect);
+
+            if (useSRGB) {
+                glEnable(GL_FRAMEBUFFER_SRGB);
+            }
 
-        if (useSRGB) {
-            glEnable(GL_FRAMEBUFFER_SRGB);
+            copyScreenSampleTexture(vbo, blurRectCount, shape.translated(xTranslate, yTranslate), screenProjection);
+        } else {
+            m_renderTargets.first()->blitFromFramebuffer(sourceRect, destRect);
+
+            if (useSRGB) {
+                glEnable(GL_FRAMEBUFFER_SRGB);
+            }
+
+            // Remove the m_renderTargets[0] from the top of the stack that we will not use
+            GLRenderTarget::popRenderTarget();
         }
 
-        // Remove the m_renderTargets[0] from the top of the stack that we will not use
-        GLRenderTarget::popRenderTarget();
+        downSampleTexture(vbo, blurRectCount);
+        upSampleTexture(vbo, blurRectCount);
+        ++m_blurCount;
     }
 
-    downSampleTexture(vbo, blurRectCount);
-    upSampleTexture(vbo, blurRectCount);
-
     // Modulate the blurred texture with the window opacity if the window isn't opaque
     if (opacity < 1.0) {
         glEnable(GL_BLEND);
@@ -711,6 +851,10 @@ void BlurEffect::doBlur(const QRegion& shape, const QRect& screen, const float o
     }
 
     vbo->unbindArrays();
+
+    if (cache && !cached) {
+        storeBlurCache(*cache, shape, expandedBlurRegion.translated(xTranslate, yTranslate).boundingRect());
+    }
 }
 
 void BlurEffect::upscaleRenderToScreen(GLVertexBuffer *vbo, int vboStart, int blurRectCount, QMatrix4x4 screenProjection, QPoint windowPosition)
@@ -814,5 +958,30 @@ bool BlurEffect::isActive() const
     return !effects->isScreenLocked();
 }
 
+bool BlurEffect::isActiveForWindow(EffectWindow *w) const
+{
+    // drawWindow() passes on all windows without a blur region untouched
+    return !blurRegion(w).isEmpty();
+}
+
+bool BlurEffect::prePaintsAllWindows() const
+{
+    // prePaintWindow() keeps track of what got painted underneath the blurred regions
+    return true;
+}
+
+bool BlurEffect::blocksDirectScanout() const
+{
+    return false;
+}
+
+QString BlurEffect::debug(const QString &parameter) const
+{
+    if (parameter == QLatin1String("cache")) {
+        return QStringLiteral("blurred=%1 cached=%2").arg(m_blurCount).arg(m_cachedBlurCount);
+    }
+    return QString();
+}
+
 } // namespace KWin
 
@@ -12,6 +12,8 @@
 #include <kwinglplatform.h>
 #include <kwinglutils.h>
 
+#include <QHash>
+#include <QSharedPointer>
 #include <QVector>
 #include <QVector2D>
 #include <QStack>
@@ -47,11 +49,17 @@ public:
 
     bool provides(Feature feature) override;
     bool isActive() const override;
+    bool isActiveForWindow(EffectWindow *w) const override;
+    bool prePaintsAllWindows() const override;
 
     int requestedEffectChainPosition() const override {
         return 75;
     }
 
+    bool blocksDirectScanout() const override;
+
+    QString debug(const QString &parameter) const override;
+
     bool eventFilter(QObject *watched, QEvent *event) override;
 
 public Q_SLOTS:
@@ -70,7 +78,24 @@ private:
     QRegion blurRegion(const EffectWindow *w) const;
     bool shouldBlur(const EffectWindow *w, int mask, const WindowPaintData &data) const;
     void updateBlurRegion(EffectWindow *w) const;
-    void doBlur(const QRegion &shape, const QRect &screen, const float opacity, const QMatrix4x4 &screenProjection, bool isDock, QRect windowRect);
+
+    struct BlurCache {
+        QRect screen;       // the output the blurred background was rendered for
+        QRegion blurArea;   // the blur region of the window in global coordinates
+        bool isDock = false;
+        QRegion shape;      // the part of blurArea the texture holds the blurred background for
+        QRect rect;         // the area of m_renderTextures[1] the texture is a copy of
+        GLTexture texture;
+        QSharedPointer<GLRenderTarget> renderTarget;
+    };
+
+    BlurCache *blurCache(EffectWindow *w, const QRect &screen, const QRegion &blurArea, bool isDock);
+    bool isBlurCached(const EffectWindow *w, const QRegion &blurArea) const;
+    void invalidateBlurCache(const EffectWindow *w);
+    void storeBlurCache(BlurCache &cache, const QRegion &shape, const QRect &textureRect);
+    void restoreBlurCache(BlurCache &cache);
+
+    void doBlur(const QRegion &shape, const QRect &screen, const float opacity, const QMatrix4x4 &screenProjection, bool isDock, QRect windowRect, BlurCache *cache = nullptr);
     void uploadRegion(QVector2D *&map, const QRegion &region, const int downSampleIterations);
     void uploadGeometry(GLVertexBuffer *vbo, const QRegion &blurRegion, const QRegion &windowRegion);
     void generateNoiseTexture();
@@ -90,7 +115,7 @@ private:
 
     bool m_renderTargetsValid;
     long net_wm_blur_region;
-    QRegion m_paintedArea; // keeps track of all painted areas (from bottom to top)
+    QRegion m_paintedArea; // keeps track of the areas painted again underneath the current window (from bottom to top)
     QRegion m_currentBlur; // keeps track of the currently blured area of the windows(from bottom to top)
 
     int m_downSampleIterations; // number of times the texture will be downsized to half size
@@ -115,6 +140,11 @@ private:
     QVector <BlurValuesStruct> blurStrengthValues;
 
     QMap <EffectWindow*, QMetaObject::Connection> windowBlurChangedConnections;
+    // keeps the blurred background of windows until something underneath them is painted again
+    QHash<const EffectWindow *, QVector<BlurCache>> m_blurCache;
+    // how often the background was blurred and how often a cached one was used, see debug()
+    int m_blurCount = 0;
+    int m_cachedBlurCount = 0;
     KWaylandServer::BlurManagerInterface *m_blurManager = nullptr;
 };
 
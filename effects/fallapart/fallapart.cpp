@@ -189,4 +189,9 @@ bool FallApartEffect::isActive() const
     return !windows.isEmpty();
 }
 
+bool FallApartEffect::isActiveForWindow(EffectWindow* w) const
+{
+    return windows.contains(w);
+}
+
 } // namespace
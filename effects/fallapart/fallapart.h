@@ -28,6 +28,7 @@ public:
     void paintWindow(EffectWindow* w, int mask, QRegion region, WindowPaintData& data) override;
     void postPaintScreen() override;
     bool isActive() const override;
+    bool isActiveForWindow(EffectWindow* w) const override;
 
     int requestedEffectChainPosition() const override {
         return 70;
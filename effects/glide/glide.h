@@ -44,6 +44,7 @@ public:
     void postPaintScreen() override;
 
     bool isActive() const override;
+    bool isActiveForWindow(EffectWindow *w) const override;
     int requestedEffectChainPosition() const override;
 
     static bool supported();
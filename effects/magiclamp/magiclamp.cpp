@@ -360,4 +360,9 @@ bool MagicLampEffect::isActive() const
     return !m_animations.isEmpty();
 }
 
+bool MagicLampEffect::isActiveForWindow(EffectWindow* w) const
+{
+    return m_animations.contains(w);
+}
+
 } // namespace
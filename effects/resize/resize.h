@@ -28,6 +28,9 @@ public:
         return ef == Effect::Resize;
     }
     inline bool isActive() const override { return m_active || AnimationEffect::isActive(); }
+    inline bool isActiveForWindow(EffectWindow* w) const override {
+        return (m_active && w == m_resizeWindow) || AnimationEffect::isActiveForWindow(w);
+    }
     void prePaintScreen(ScreenPrePaintData& data, int time) override;
     void prePaintWindow(EffectWindow* w, WindowPrePaintData& data, int time) override;
     void paintWindow(EffectWindow* w, int mask, QRegion region, WindowPaintData& data) override;
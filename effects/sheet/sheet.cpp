@@ -135,6 +135,11 @@ bool SheetEffect::isActive() const
     return !m_animations.isEmpty();
 }
 
+bool SheetEffect::isActiveForWindow(EffectWindow *w) const
+{
+    return m_animations.contains(w);
+}
+
 bool SheetEffect::supported()
 {
     return effects->isOpenGLCompositing()
@@ -34,6 +34,7 @@ public:
     void postPaintWindow(EffectWindow *w) override;
 
     bool isActive() const override;
+    bool isActiveForWindow(EffectWindow *w) const override;
     int requestedEffectChainPosition() const override;
 
     static bool supported();
@@ -0,0 +1,323 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2020 KWin developers <kwin@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "wobblymodel.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace KWin
+{
+
+const int WobblyModel::s_width;
+const int WobblyModel::s_height;
+const int WobblyModel::s_count;
+
+namespace
+{
+
+constexpr bool hasLeft(int index)
+{
+    return index % WobblyModel::s_width != 0;
+}
+
+constexpr bool hasRight(int index)
+{
+    return index % WobblyModel::s_width != WobblyModel::s_width - 1;
+}
+
+constexpr bool hasAbove(int index)
+{
+    return index >= WobblyModel::s_width;
+}
+
+constexpr bool hasBelow(int index)
+{
+    return index < WobblyModel::s_count - WobblyModel::s_width;
+}
+
+/**
+ * The factors which only depend on the position of a point in the grid, so that
+ * the kernels don't have to special case the corners and borders.
+ */
+struct GridWeights
+{
+    constexpr GridWeights()
+        : left{}
+        , right{}
+        , spring{}
+        , ring{}
+        , self{}
+    {
+        for (int i = 0; i < WobblyModel::s_count; ++i) {
+            left[i] = hasLeft(i) ? 1.0 : 0.0;
+            right[i] = hasRight(i) ? 1.0 : 0.0;
+
+            // the mean over the horizontal and vertical neighbours pulling at a point
+            spring[i] = 1.0 / (left[i] + right[i] + int(hasAbove(i)) + int(hasBelow(i)));
+
+            // the mean over the ring of eight neighbours, with the point itself weighted as much
+            // as the whole ring, given the sum over the 3x3 block around the point
+            const qreal ringCount = (1 + left[i] + right[i]) * (1 + int(hasAbove(i)) + int(hasBelow(i))) - 1;
+            ring[i] = 1.0 / (2.0 * ringCount);
+            self[i] = (ringCount - 1.0) / (2.0 * ringCount);
+        }
+    }
+
+    qreal left[WobblyModel::s_count];
+    qreal right[WobblyModel::s_count];
+    qreal spring[WobblyModel::s_count];
+    qreal ring[WobblyModel::s_count];
+    qreal self[WobblyModel::s_count];
+};
+
+constexpr GridWeights s_weights;
+
+inline qreal fixBounds(qreal value, qreal min, qreal max)
+{
+    const qreal clamped = std::min(std::max(value, -max), max);
+    return std::fabs(value) < min ? 0.0 : clamped;
+}
+
+} // anonymous namespace
+
+WobblyModel::WobblyModel(const QRectF &geometry)
+{
+    setOrigin(geometry);
+    for (int i = 0; i < s_count; ++i) {
+        m_positionX[i] = m_originX[i];
+        m_positionY[i] = m_originY[i];
+        m_velocityX[i] = 0.0;
+        m_velocityY[i] = 0.0;
+        m_accelerationX[i] = 0.0;
+        m_accelerationY[i] = 0.0;
+        m_constraint[i] = false;
+    }
+}
+
+QPointF WobblyModel::position(int index) const
+{
+    return QPointF(m_positionX[index], m_positionY[index]);
+}
+
+QPointF WobblyModel::velocity(int index) const
+{
+    return QPointF(m_velocityX[index], m_velocityY[index]);
+}
+
+void WobblyModel::setVelocity(int index, const QPointF &velocity)
+{
+    m_velocityX[index] = velocity.x();
+    m_velocityY[index] = velocity.y();
+}
+
+bool WobblyModel::isConstrained(int index) const
+{
+    return m_constraint[index];
+}
+
+void WobblyModel::setConstrained(int index, bool constrained)
+{
+    m_constraint[index] = constrained;
+}
+
+qreal WobblyModel::accelerationSum() const
+{
+    return m_accelerationSum;
+}
+
+qreal WobblyModel::velocitySum() const
+{
+    return m_velocitySum;
+}
+
+void WobblyModel::setOrigin(const QRectF &geometry)
+{
+    const qreal xLength = geometry.width() / (s_width - 1.0);
+    const qreal yLength = geometry.height() / (s_height - 1.0);
+
+    // the last row and column are placed exactly on the edges instead of accumulating the lengths
+    qreal y = geometry.y();
+    for (int j = 0; j < s_height; ++j) {
+        qreal x = geometry.x();
+        for (int i = 0; i < s_width; ++i) {
+            m_originX[j * s_width + i] = x;
+            m_originY[j * s_width + i] = y;
+            x = (i != s_width - 2) ? x + xLength : geometry.x() + geometry.width();
+        }
+        y = (j != s_height - 2) ? y + yLength : geometry.y() + geometry.height();
+    }
+}
+
+void WobblyModel::computeAcceleration(qreal stiffness, qreal xLength, qreal yLength)
+{
+    // The springs are stored with one row of padding before and after them, so that
+    // every point can subtract the spring on its left or top and add the one on its
+    // right or bottom without special cases for the borders.
+    qreal horizontalX[s_count + 1];
+    qreal horizontalY[s_count + 1];
+    qreal verticalX[s_count + s_width];
+    qreal verticalY[s_count + s_width];
+
+    horizontalX[0] = horizontalY[0] = 0.0;
+    for (int i = 0; i < s_count - 1; ++i) {
+        // there is no spring between the last point of a row and the first one of the next row
+        horizontalX[i + 1] = s_weights.right[i] * (m_positionX[i + 1] - m_positionX[i] - xLength);
+        horizontalY[i + 1] = s_weights.right[i] * (m_positionY[i + 1] - m_positionY[i]);
+    }
+    horizontalX[s_count] = horizontalY[s_count] = 0.0;
+
+    for (int i = 0; i < s_width; ++i) {
+        verticalX[i] = verticalY[i] = 0.0;
+        verticalX[s_count + i] = verticalY[s_count + i] = 0.0;
+    }
+    for (int i = 0; i < s_count - s_width; ++i) {
+        verticalX[i + s_width] = m_positionX[i + s_width] - m_positionX[i];
+        verticalY[i + s_width] = m_positionY[i + s_width] - m_positionY[i] - yLength;
+    }
+
+    for (int i = 0; i < s_count; ++i) {
+        const qreal forceX = horizontalX[i + 1] - horizontalX[i] + verticalX[i + s_width] - verticalX[i];
+        const qreal forceY = horizontalY[i + 1] - horizontalY[i] + verticalY[i + s_width] - verticalY[i];
+
+        // constrained points are only pulled to their place in the window
+        m_accelerationX[i] = stiffness * (m_constraint[i] ? m_originX[i] - m_positionX[i] : forceX * s_weights.spring[i]);
+        m_accelerationY[i] = stiffness * (m_constraint[i] ? m_originY[i] - m_positionY[i] : forceY * s_weights.spring[i]);
+    }
+}
+
+void WobblyModel::smooth(qreal *data)
+{
+    // The sum over the 3x3 block around each point is built from the sums over the
+    // rows, again with padding on both sides.
+    qreal padded[s_count + 2];
+    qreal rows[s_count + 2 * s_width];
+
+    padded[0] = 0.0;
+    for (int i = 0; i < s_count; ++i) {
+        padded[i + 1] = data[i];
+    }
+    padded[s_count + 1] = 0.0;
+
+    for (int i = 0; i < s_width; ++i) {
+        rows[i] = 0.0;
+        rows[s_count + s_width + i] = 0.0;
+    }
+    for (int i = 0; i < s_count; ++i) {
+        rows[i + s_width] = s_weights.left[i] * padded[i] + padded[i + 1] + s_weights.right[i] * padded[i + 2];
+    }
+
+    for (int i = 0; i < s_count; ++i) {
+        const qreal block = rows[i] + rows[i + s_width] + rows[i + 2 * s_width];
+        data[i] = block * s_weights.ring[i] + data[i] * s_weights.self[i];
+    }
+}
+
+void WobblyModel::step(const QRectF &geometry, const Parameters &parameters, qreal time)
+{
+    setOrigin(geometry);
+    computeAcceleration(parameters.stiffness,
+                        geometry.width() / (s_width - 1.0),
+                        geometry.height() / (s_height - 1.0));
+
+    smooth(m_accelerationX);
+    smooth(m_accelerationY);
+
+    qreal accelerationSum = 0.0;
+    for (int i = 0; i < s_count; ++i) {
+        const qreal accelerationX = fixBounds(m_accelerationX[i], parameters.minAcceleration, parameters.maxAcceleration);
+        const qreal accelerationY = fixBounds(m_accelerationY[i], parameters.minAcceleration, parameters.maxAcceleration);
+        m_velocityX[i] = accelerationX * time + m_velocityX[i] * parameters.drag;
+        m_velocityY[i] = accelerationY * time + m_velocityY[i] * parameters.drag;
+        accelerationSum += std::fabs(accelerationX) + std::fabs(accelerationY);
+    }
+
+    smooth(m_velocityX);
+    smooth(m_velocityY);
+
+    qreal velocitySum = 0.0;
+    const qreal distance = time * parameters.moveFactor;
+    for (int i = 0; i < s_count; ++i) {
+        m_velocityX[i] = fixBounds(m_velocityX[i], parameters.minVelocity, parameters.maxVelocity);
+        m_velocityY[i] = fixBounds(m_velocityY[i], parameters.minVelocity, parameters.maxVelocity);
+        m_positionX[i] += m_velocityX[i] * distance;
+        m_positionY[i] += m_velocityY[i] * distance;
+        velocitySum += std::fabs(m_velocityX[i]) + std::fabs(m_velocityY[i]);
+    }
+
+    m_accelerationSum = accelerationSum;
+    m_velocitySum = velocitySum;
+}
+
+void WobblyModel::pinEdges(bool top, bool left, bool right, bool bottom)
+{
+    // everything but the opposite row or column follows the window
+    if (top) {
+        for (int i = 0; i < s_count - s_width; ++i) {
+            m_positionY[i] = m_originY[i];
+        }
+    }
+    if (bottom) {
+        for (int i = s_width; i < s_count; ++i) {
+            m_positionY[i] = m_originY[i];
+        }
+    }
+    if (left) {
+        for (int i = 0; i < s_count; ++i) {
+            if (hasRight(i)) {
+                m_positionX[i] = m_originX[i];
+            }
+        }
+    }
+    if (right) {
+        for (int i = 0; i < s_count; ++i) {
+            if (hasLeft(i)) {
+                m_positionX[i] = m_originX[i];
+            }
+        }
+    }
+}
+
+QPointF WobblyModel::map(const QPointF &point) const
+{
+    static_assert(s_width == 4 && s_height == 4, "the surface is bicubic");
+
+    const qreal tx = (point.x() - m_originX[0]) / (m_originX[s_count - 1] - m_originX[0]);
+    const qreal ty = (point.y() - m_originY[0]) / (m_originY[s_count - 1] - m_originY[0]);
+
+    // the Bernstein polynomials of the cubic Bezier curves in both directions
+    const qreal px[4] = {
+        (1 - tx) * (1 - tx) * (1 - tx),
+        3 * (1 - tx) * (1 - tx) * tx,
+        3 * (1 - tx) * tx * tx,
+        tx * tx * tx,
+    };
+    const qreal py[4] = {
+        (1 - ty) * (1 - ty) * (1 - ty),
+        3 * (1 - ty) * (1 - ty) * ty,
+        3 * (1 - ty) * ty * ty,
+        ty * ty * ty,
+    };
+
+    qreal x = 0.0;
+    qreal y = 0.0;
+    for (int j = 0; j < s_height; ++j) {
+        qreal rowX = 0.0;
+        qreal rowY = 0.0;
+        for (int i = 0; i < s_width; ++i) {
+            rowX += px[i] * m_positionX[j * s_width + i];
+            rowY += px[i] * m_positionY[j * s_width + i];
+        }
+        x += py[j] * rowX;
+        y += py[j] * rowY;
+    }
+    return QPointF(x, y);
+}
+
+} // namespace KWin
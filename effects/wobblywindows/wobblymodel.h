@@ -0,0 +1,100 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2020 KWin developers <kwin@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef KWIN_WOBBLYMODEL_H
+#define KWIN_WOBBLYMODEL_H
+
+#include <QPointF>
+#include <QRectF>
+
+namespace KWin
+{
+
+/**
+ * The WobblyModel class simulates the spring-mass grid which deforms a wobbly window.
+ *
+ * The grid consists of 4x4 control points of a bicubic Bezier surface. Every point is
+ * pulled towards its horizontal and vertical neighbours at the distance they have in
+ * the window geometry, or straight to its place in the window geometry if it is
+ * constrained, e.g. because it is under the cursor while the window is being moved.
+ *
+ * The components of the points are kept in separate flat arrays, so that the kernels
+ * of a simulation step are plain loops over the whole grid.
+ */
+class WobblyModel
+{
+public:
+    struct Parameters {
+        qreal stiffness;
+        qreal drag;
+        qreal moveFactor;
+        qreal minVelocity;
+        qreal maxVelocity;
+        qreal minAcceleration;
+        qreal maxAcceleration;
+    };
+
+    static const int s_width = 4;
+    static const int s_height = 4;
+    static const int s_count = s_width * s_height;
+
+    explicit WobblyModel(const QRectF &geometry = QRectF());
+
+    QPointF position(int index) const;
+    QPointF velocity(int index) const;
+    void setVelocity(int index, const QPointF &velocity);
+
+    bool isConstrained(int index) const;
+    void setConstrained(int index, bool constrained);
+
+    /**
+     * Advances the simulation by @p time milliseconds towards the window @p geometry.
+     */
+    void step(const QRectF &geometry, const Parameters &parameters, qreal time);
+
+    /**
+     * The sums of the absolute acceleration and velocity components of the last step.
+     * The window has settled once both are small enough.
+     */
+    qreal accelerationSum() const;
+    qreal velocitySum() const;
+
+    /**
+     * Moves the rows and columns next to the given edges back to the window geometry,
+     * so that they don't wobble.
+     */
+    void pinEdges(bool top, bool left, bool right, bool bottom);
+
+    /**
+     * Maps the @p point of the window geometry onto the deformed surface.
+     */
+    QPointF map(const QPointF &point) const;
+
+private:
+    void setOrigin(const QRectF &geometry);
+    void computeAcceleration(qreal stiffness, qreal xLength, qreal yLength);
+    static void smooth(qreal *data);
+
+    qreal m_originX[s_count];
+    qreal m_originY[s_count];
+    qreal m_positionX[s_count];
+    qreal m_positionY[s_count];
+    qreal m_velocityX[s_count];
+    qreal m_velocityY[s_count];
+    qreal m_accelerationX[s_count];
+    qreal m_accelerationY[s_count];
+    bool m_constraint[s_count];
+
+    qreal m_accelerationSum = 0.0;
+    qreal m_velocitySum = 0.0;
+};
+
+} // namespace KWin
+
+#endif // KWIN_WOBBLYMODEL_H
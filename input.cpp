@@ -2451,42 +2451,72 @@ Toplevel *InputRedirection::findToplevel(const QPoint &pos)
     return findManagedToplevel(pos);
 }
 
-Toplevel *InputRedirection::findManagedToplevel(const QPoint &pos)
+void InputRedirection::updateFocusIndex()
 {
-    if (!Workspace::self()) {
-        return nullptr;
-    }
-    const bool isScreenLocked = waylandServer() && waylandServer()->isScreenLocked();
     const QList<Toplevel *> &stacking = Workspace::self()->stackingOrder();
-    if (stacking.isEmpty()) {
-        return nullptr;
+    // any change to the stacking order detaches the list of the workspace from our copy
+    if (m_focusIndexStacking.isSharedWith(stacking)) {
+        return;
     }
-    auto it = stacking.end();
-    do {
-        --it;
-        Toplevel *t = (*it);
+    m_focusIndexStacking = stacking;
+    m_focusIndexKeys.clear();
+    m_focusIndex.clear();
+    for (int i = 0; i < m_focusIndexStacking.count(); ++i) {
+        Toplevel *t = m_focusIndexStacking.at(i);
         if (t->isDeleted()) {
-            // a deleted window doesn't get mouse events
             continue;
         }
+        m_focusIndexKeys.insert(t, i);
+        m_focusIndex.insert(i, focusIndexGeometry(t));
+        connect(t, &Toplevel::frameGeometryChanged, this, &InputRedirection::updateFocusIndexGeometry, Qt::UniqueConnection);
+        connect(t, &Toplevel::bufferGeometryChanged, this, &InputRedirection::updateFocusIndexGeometry, Qt::UniqueConnection);
+    }
+}
+
+QRect InputRedirection::focusIndexGeometry(Toplevel *t) const
+{
+    if (t->isInputMethod()) {
+        // the input geometry follows the input region of the surface, which doesn't
+        // notify us about changes, so check it on every lookup
+        return QRect(QPoint(-(1 << 24), -(1 << 24)), QPoint(1 << 24, 1 << 24));
+    }
+    return t->inputGeometry();
+}
+
+void InputRedirection::updateFocusIndexGeometry(Toplevel *t)
+{
+    const auto it = m_focusIndexKeys.constFind(t);
+    if (it == m_focusIndexKeys.constEnd()) {
+        return;
+    }
+    m_focusIndex.insert(*it, focusIndexGeometry(t));
+}
+
+Toplevel *InputRedirection::findManagedToplevel(const QPoint &pos)
+{
+    if (!Workspace::self()) {
+        return nullptr;
+    }
+    const bool isScreenLocked = waylandServer() && waylandServer()->isScreenLocked();
+    updateFocusIndex();
+    const int key = m_focusIndex.find(pos, [this, isScreenLocked, &pos] (int key) {
+        Toplevel *t = m_focusIndexStacking.at(key);
         if (AbstractClient *c = dynamic_cast<AbstractClient*>(t)) {
             if (!c->isOnCurrentActivity() || !c->isOnCurrentDesktop() || c->isMinimized() || c->isHiddenInternal()) {
-                continue;
+                return false;
             }
         }
         if (!t->readyForPainting()) {
-            continue;
+            return false;
         }
         if (isScreenLocked) {
             if (!t->isLockScreen() && !t->isInputMethod()) {
-                continue;
+                return false;
             }
         }
-        if (t->inputGeometry().contains(pos) && acceptsInput(t, pos)) {
-            return t;
-        }
-    } while (it != stacking.begin());
-    return nullptr;
+        return t->inputGeometry().contains(pos) && acceptsInput(t, pos);
+    });
+    return key != -1 ? m_focusIndexStacking.at(key) : nullptr;
 }
 
 Qt::KeyboardModifiers InputRedirection::keyboardModifiers() const
@@ -11,6 +11,7 @@
 #ifndef KWIN_INPUT_H
 #define KWIN_INPUT_H
 #include <kwinglobals.h>
+#include "inputregionindex.h"
 #include <QAction>
 #include <QObject>
 #include <QPoint>
@@ -304,6 +305,9 @@ private:
     void reconfigure();
     void setupInputFilters();
     void installInputEventFilter(InputEventFilter *filter);
+    void updateFocusIndex();
+    void updateFocusIndexGeometry(Toplevel *t);
+    QRect focusIndexGeometry(Toplevel *t) const;
     KeyboardInputRedirection *m_keyboard;
     PointerInputRedirection *m_pointer;
     TabletInputRedirection *m_tablet;
@@ -319,6 +323,11 @@ private:
     QVector<InputEventFilter*> m_filters;
     QVector<InputEventSpy*> m_spies;
 
+    // spatial index over the input geometries of the stacking order, keyed by stacking position
+    InputRegionIndex m_focusIndex;
+    QList<Toplevel *> m_focusIndexStacking;
+    QHash<Toplevel *, int> m_focusIndexKeys;
+
     KWIN_SINGLETON(InputRedirection)
     friend InputRedirection *input();
     friend class DecorationEventFilter;
@@ -0,0 +1,144 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2020 KWin developers <kwin@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "inputregionindex.h"
+
+#include <algorithm>
+
+namespace KWin
+{
+
+const int InputRegionIndex::s_cellSize;
+const int InputRegionIndex::s_maxCellsPerRect;
+
+static int cellIndex(int coordinate)
+{
+    // round towards negative infinity, windows can be placed at negative coordinates
+    return coordinate >= 0 ? coordinate / InputRegionIndex::s_cellSize
+                           : -((-coordinate - 1) / InputRegionIndex::s_cellSize) - 1;
+}
+
+static void insertSorted(QVector<int> &keys, int key)
+{
+    keys.insert(std::lower_bound(keys.begin(), keys.end(), key), key);
+}
+
+static void removeSorted(QVector<int> &keys, int key)
+{
+    auto it = std::lower_bound(keys.begin(), keys.end(), key);
+    if (it != keys.end() && *it == key) {
+        keys.erase(it);
+    }
+}
+
+quint64 InputRegionIndex::cellKey(int column, int row)
+{
+    return (quint64(quint32(column)) << 32) | quint32(row);
+}
+
+QRect InputRegionIndex::cellRange(const QRect &rect)
+{
+    return QRect(QPoint(cellIndex(rect.left()), cellIndex(rect.top())),
+                 QPoint(cellIndex(rect.right()), cellIndex(rect.bottom())));
+}
+
+void InputRegionIndex::clear()
+{
+    m_rects.clear();
+    m_cells.clear();
+    m_oversized.clear();
+}
+
+void InputRegionIndex::insert(int key, const QRect &rect)
+{
+    Q_ASSERT(key >= 0);
+    if (key < m_rects.count()) {
+        if (m_rects[key] == rect) {
+            return;
+        }
+        remove(key);
+    } else {
+        m_rects.resize(key + 1);
+    }
+    m_rects[key] = rect;
+    if (rect.isEmpty()) {
+        return;
+    }
+
+    const QRect range = cellRange(rect);
+    if (qint64(range.width()) * range.height() > s_maxCellsPerRect) {
+        insertSorted(m_oversized, key);
+        return;
+    }
+    for (int row = range.top(); row <= range.bottom(); ++row) {
+        for (int column = range.left(); column <= range.right(); ++column) {
+            insertSorted(m_cells[cellKey(column, row)], key);
+        }
+    }
+}
+
+void InputRegionIndex::remove(int key)
+{
+    if (key < 0 || key >= m_rects.count()) {
+        return;
+    }
+    const QRect rect = m_rects[key];
+    m_rects[key] = QRect();
+    if (rect.isEmpty()) {
+        return;
+    }
+
+    const QRect range = cellRange(rect);
+    if (qint64(range.width()) * range.height() > s_maxCellsPerRect) {
+        removeSorted(m_oversized, key);
+        return;
+    }
+    for (int row = range.top(); row <= range.bottom(); ++row) {
+        for (int column = range.left(); column <= range.right(); ++column) {
+            auto it = m_cells.find(cellKey(column, row));
+            if (it == m_cells.end()) {
+                continue;
+            }
+            removeSorted(*it, key);
+            if (it->isEmpty()) {
+                m_cells.erase(it);
+            }
+        }
+    }
+}
+
+QRect InputRegionIndex::rect(int key) const
+{
+    return m_rects.value(key);
+}
+
+int InputRegionIndex::find(const QPoint &pos, const AcceptFunction &accept) const
+{
+    static const QVector<int> noKeys;
+    const auto cell = m_cells.constFind(cellKey(cellIndex(pos.x()), cellIndex(pos.y())));
+    const QVector<int> &keys = cell != m_cells.constEnd() ? *cell : noKeys;
+
+    // merge the keys of the cell with the oversized ones, from top to bottom
+    int i = keys.count() - 1;
+    int j = m_oversized.count() - 1;
+    while (i >= 0 || j >= 0) {
+        int key;
+        if (j < 0 || (i >= 0 && keys[i] > m_oversized[j])) {
+            key = keys[i--];
+        } else {
+            key = m_oversized[j--];
+        }
+        if (m_rects[key].contains(pos) && accept(key)) {
+            return key;
+        }
+    }
+    return -1;
+}
+
+} // namespace KWin
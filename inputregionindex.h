@@ -0,0 +1,77 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2020 KWin developers <kwin@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <kwin_export.h>
+
+#include <QHash>
+#include <QRect>
+#include <QVector>
+
+#include <functional>
+
+namespace KWin
+{
+
+/**
+ * The InputRegionIndex class answers which of a set of stacked rectangles contain a point.
+ *
+ * Every rectangle is identified by a non-negative key, a higher key means that it is stacked
+ * above rectangles with lower keys. The index divides the plane into square cells and keeps
+ * for every cell the keys of the rectangles intersecting it. A point query therefore only has
+ * to look at the rectangles sharing the cell with the point, rather than at all of them.
+ * Rectangles covering a lot of cells are kept in a separate list that is checked by every query.
+ */
+class KWIN_EXPORT InputRegionIndex
+{
+public:
+    using AcceptFunction = std::function<bool(int key)>;
+
+    /**
+     * Removes all rectangles.
+     */
+    void clear();
+
+    /**
+     * Adds the rectangle @p rect with the given @p key, replacing a previous one with that key.
+     */
+    void insert(int key, const QRect &rect);
+
+    /**
+     * Removes the rectangle with the given @p key.
+     */
+    void remove(int key);
+
+    /**
+     * Returns the rectangle with the given @p key, or an invalid rectangle if there is none.
+     */
+    QRect rect(int key) const;
+
+    /**
+     * Returns the key of the top-most rectangle that contains @p pos and is accepted
+     * by @p accept, or @c -1 if there is no such rectangle.
+     */
+    int find(const QPoint &pos, const AcceptFunction &accept) const;
+
+    static const int s_cellSize = 256;
+    static const int s_maxCellsPerRect = 256;
+
+private:
+    static quint64 cellKey(int column, int row);
+    static QRect cellRange(const QRect &rect);
+
+    QVector<QRect> m_rects;
+    // sorted keys of the rectangles intersecting a cell
+    QHash<quint64, QVector<int>> m_cells;
+    // sorted keys of the rectangles covering too many cells
+    QVector<int> m_oversized;
+};
+
+} // namespace KWin
@@ -84,6 +84,7 @@
 #include "screenedge.h"
 #include "wayland_server.h"
 #include "internal_client.h"
+#include "transientstacking.h"
 
 #include <QDebug>
 
@@ -520,90 +521,52 @@ QList<Toplevel *> Workspace::constrainedStackingOrder()
         stacking += layer[lay];
     }
     // now keep transients above their mainwindows
-    // TODO this could(?) use some optimization
-    for (int i = stacking.size() - 1; i >= 0;) {
-        // Index of the main window for the current transient window.
-        int i2 = -1;
-
-        // If the current transient has "child" transients, we'd like to restart
-        // construction of the constrained stacking order from the position where
-        // the current transient will be moved.
-        bool hasTransients = false;
-
-        // Find topmost client this one is transient for.
-        if (auto *client = qobject_cast<AbstractClient *>(stacking[i])) {
-            if (!client->isTransient()) {
-                --i;
-                continue;
-            }
-            for (i2 = stacking.size() - 1; i2 >= 0; --i2) {
-                auto *c2 = qobject_cast<AbstractClient *>(stacking[i2]);
-                if (!c2) {
-                    continue;
-                }
-                if (c2 == client) {
-                    i2 = -1; // Don't reorder, already on top of its main window.
-                    break;
-                }
-                if (c2->hasTransient(client, true)
-                        && keepTransientAbove(c2, client)) {
-                    break;
+    QSet<Toplevel *> hasDeletedTransients;
+    if (!deletedList().isEmpty()) {
+        for (const Toplevel *toplevel : qAsConst(stacking)) {
+            if (const Deleted *deleted = qobject_cast<const Deleted *>(toplevel)) {
+                for (Toplevel *mainWindow : deleted->mainWindows()) {
+                    hasDeletedTransients.insert(mainWindow);
                 }
             }
-
-            hasTransients = !client->transients().isEmpty();
-
-            // If the current transient doesn't have any "alive" transients, check
-            // whether it has deleted transients that have to be raised.
-            const bool searchForDeletedTransients = !hasTransients
-                && !deletedList().isEmpty();
-            if (searchForDeletedTransients) {
-                for (int j = i + 1; j < stacking.count(); ++j) {
-                    auto *deleted = qobject_cast<Deleted *>(stacking[j]);
-                    if (!deleted) {
-                        continue;
-                    }
-                    if (deleted->wasTransientFor(client)) {
-                        hasTransients = true;
-                        break;
+        }
+    }
+    constrainTransientStacking(stacking,
+        [](Toplevel *toplevel) {
+            QList<Toplevel *> mainWindows;
+            if (const AbstractClient *client = qobject_cast<AbstractClient *>(toplevel)) {
+                if (client->isTransient()) {
+                    // indirect main clients are only candidates, hasTransient() sorts them out below
+                    const QList<AbstractClient *> mainClients = client->allMainClients();
+                    mainWindows.reserve(mainClients.count());
+                    for (AbstractClient *mainClient : mainClients) {
+                        mainWindows.append(mainClient);
                     }
                 }
+            } else if (const Deleted *deleted = qobject_cast<Deleted *>(toplevel)) {
+                mainWindows = deleted->mainWindows();
             }
-        } else if (auto *deleted = qobject_cast<Deleted *>(stacking[i])) {
-            if (!deleted->wasTransient()) {
-                --i;
-                continue;
+            return mainWindows;
+        },
+        [this](Toplevel *mainWindow, Toplevel *transient) {
+            if (AbstractClient *client = qobject_cast<AbstractClient *>(transient)) {
+                const AbstractClient *mainClient = qobject_cast<AbstractClient *>(mainWindow);
+                return mainClient && mainClient->hasTransient(client, true)
+                    && keepTransientAbove(mainClient, client);
             }
-            for (i2 = stacking.size() - 1; i2 >= 0; --i2) {
-                Toplevel *c2 = stacking[i2];
-                if (c2 == deleted) {
-                    i2 = -1; // Don't reorder, already on top of its main window.
-                    break;
-                }
-                if (deleted->wasTransientFor(c2)
-                        && keepDeletedTransientAbove(c2, deleted)) {
-                    break;
-                }
+            const Deleted *deleted = qobject_cast<Deleted *>(transient);
+            return deleted && deleted->wasTransientFor(mainWindow)
+                && keepDeletedTransientAbove(mainWindow, deleted);
+        },
+        [&hasDeletedTransients](Toplevel *toplevel) {
+            if (const AbstractClient *client = qobject_cast<AbstractClient *>(toplevel)) {
+                return !client->transients().isEmpty() || hasDeletedTransients.contains(toplevel);
             }
-            hasTransients = !deleted->transients().isEmpty();
-        }
-
-        if (i2 == -1) {
-            --i;
-            continue;
-        }
-
-        Toplevel *current = stacking[i];
-
-        stacking.removeAt(i);
-        --i; // move onto the next item (for next for () iteration)
-        --i2; // adjust index of the mainwindow after the remove above
-        if (hasTransients) {  // this one now can be possibly above its transients,
-            i = i2; // so go again higher in the stack order and possibly move those transients again
-        }
-        ++i2; // insert after (on top of) the mainwindow, it's ok if it2 is now stacking.end()
-        stacking.insert(i2, current);
-    }
+            if (const Deleted *deleted = qobject_cast<Deleted *>(toplevel)) {
+                return !deleted->transients().isEmpty();
+            }
+            return false;
+        });
     return stacking;
 }
 
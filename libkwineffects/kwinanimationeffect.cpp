@@ -79,6 +79,12 @@ bool AnimationEffect::isActive() const
     return !d->m_animations.isEmpty() && !effects->isScreenLocked();
 }
 
+bool AnimationEffect::isActiveForWindow(EffectWindow *w) const
+{
+    Q_D(const AnimationEffect);
+    return d->m_animations.contains(w);
+}
+
 
 #define RELATIVE_XY(_FIELD_) const bool relative[2] = { static_cast<bool>(metaData(Relative##_FIELD_##X, meta)), \
                                                         static_cast<bool>(metaData(Relative##_FIELD_##Y, meta)) }
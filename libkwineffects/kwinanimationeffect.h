@@ -169,6 +169,7 @@ public:
     ~AnimationEffect() override;
 
     bool isActive() const override;
+    bool isActiveForWindow(EffectWindow *w) const override;
 
     /**
      * Gets stored metadata.
@@ -601,6 +601,17 @@ bool Effect::isActive() const
     return true;
 }
 
+bool Effect::isActiveForWindow(EffectWindow *w) const
+{
+    Q_UNUSED(w)
+    return true;
+}
+
+bool Effect::prePaintsAllWindows() const
+{
+    return false;
+}
+
 QString Effect::debug(const QString &) const
 {
     return QString();
@@ -654,6 +665,11 @@ int Effect::requestedEffectChainPosition() const
     return 0;
 }
 
+bool Effect::blocksDirectScanout() const
+{
+    return true;
+}
+
 xcb_connection_t *Effect::xcbConnection() const
 {
     return effects->xcbConnection();
@@ -928,6 +944,7 @@ bool WindowQuad::smoothNeeded() const
 WindowQuadList WindowQuadList::splitAtX(double x) const
 {
     WindowQuadList ret;
+    ret.reserve(count() * 2); // every quad is split at most once
     foreach (const WindowQuad & quad, *this) {
 #if !defined(QT_NO_DEBUG)
         if (quad.isTransformed())
@@ -960,6 +977,7 @@ WindowQuadList WindowQuadList::splitAtX(double x) const
 WindowQuadList WindowQuadList::splitAtY(double y) const
 {
     WindowQuadList ret;
+    ret.reserve(count() * 2); // every quad is split at most once
     foreach (const WindowQuad & quad, *this) {
 #if !defined(QT_NO_DEBUG)
         if (quad.isTransformed())
@@ -1012,6 +1030,8 @@ WindowQuadList WindowQuadList::makeGrid(int maxQuadSize) const
     }
 
     WindowQuadList ret;
+    // usually the quads cover the bounding rectangle, plus some cells split at their edges
+    ret.reserve(qCeil((right - left) / maxQuadSize) * qCeil((bottom - top) / maxQuadSize) + count());
 
     foreach (const WindowQuad &quad, *this) {
         const double quadLeft   = quad.left();
@@ -1072,6 +1092,8 @@ WindowQuadList WindowQuadList::makeRegularGrid(int xSubdivisions, int ySubdivisi
     double yIncrement = (bottom - top) / ySubdivisions;
 
     WindowQuadList ret;
+    // usually the quads cover the bounding rectangle, plus some cells split at their edges
+    ret.reserve(xSubdivisions * ySubdivisions + count());
 
     foreach (const WindowQuad &quad, *this) {
         const double quadLeft   = quad.left();
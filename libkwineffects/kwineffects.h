@@ -175,7 +175,7 @@ X-KDE-Library=kwin4_effect_cooleffect
 
 #define KWIN_EFFECT_API_MAKE_VERSION( major, minor ) (( major ) << 8 | ( minor ))
 #define KWIN_EFFECT_API_VERSION_MAJOR 0
-#define KWIN_EFFECT_API_VERSION_MINOR 230
+#define KWIN_EFFECT_API_VERSION_MINOR 234
 #define KWIN_EFFECT_API_VERSION KWIN_EFFECT_API_MAKE_VERSION( \
         KWIN_EFFECT_API_VERSION_MAJOR, KWIN_EFFECT_API_VERSION_MINOR )
 
@@ -531,6 +531,37 @@ public:
      */
     virtual bool isActive() const;
 
+    /**
+     * Overwrite this method to indicate whether your active effect wants to take part in
+     * painting the window @p w. If the method returns @c false, prePaintWindow(), paintWindow(),
+     * drawWindow() and postPaintWindow() are not called for that window in the next rendered
+     * frame, the window is passed on to the next effect in the chain instead. See
+     * prePaintsAllWindows() for effects which need to see every window in prePaintWindow().
+     *
+     * The method is called at most once per window and frame, and only if isActive() returned
+     * @c true. Effects which only animate a few windows should return whether @p w is one of
+     * them, e.g. by looking it up in their animation map.
+     *
+     * The default implementation of this method returns @c true.
+     * @since 5.20
+     */
+    virtual bool isActiveForWindow(EffectWindow *w) const;
+
+    /**
+     * Reimplement this method to indicate that prePaintWindow() has to be called for every
+     * window, even for the ones isActiveForWindow() returned @c false for. paintWindow(),
+     * drawWindow() and postPaintWindow() are still only called for the windows the effect
+     * is active for.
+     *
+     * This is meant for effects which keep track of the painted areas of all windows, e.g. to
+     * know what changed behind a window they paint. Such an effect must not change the mask
+     * of a window it is not active for, otherwise the scene might paint the window differently.
+     *
+     * The default implementation returns @c false.
+     * @since 5.20
+     */
+    virtual bool prePaintsAllWindows() const;
+
     /**
      * Reimplement this method to provide online debugging.
      * This could be as trivial as printing specific detail information about the effect state
@@ -558,6 +589,18 @@ public:
      */
     virtual int requestedEffectChainPosition() const;
 
+    /**
+     * Reimplement this method to indicate whether the effect can be bypassed while it is active
+     * and a fullscreen window is scanned out directly, i.e. without compositing.
+     *
+     * Effects which are active all the time, but only paint in the region of certain windows,
+     * should return @c false, so they don't prevent direct scanout of an unrelated window.
+     *
+     * The default implementation returns @c true.
+     * @since 5.20
+     */
+    virtual bool blocksDirectScanout() const;
+
 
     /**
      * A touch point was pressed.
@@ -2545,6 +2588,7 @@ private:
 class KWINEFFECTS_EXPORT WindowQuad
 {
 public:
+    WindowQuad();
     explicit WindowQuad(WindowQuadType type, int id = -1);
     WindowQuad makeSubQuad(double x1, double y1, double x2, double y2) const;
     WindowVertex& operator[](int index);
@@ -2573,8 +2617,20 @@ private:
     int quadID;
 };
 
+} // namespace KWin
+
+Q_DECLARE_TYPEINFO(KWin::WindowVertex, Q_MOVABLE_TYPE);
+Q_DECLARE_TYPEINFO(KWin::WindowQuad, Q_MOVABLE_TYPE);
+
+namespace KWin
+{
+
+/**
+ * The quads are stored contiguously, so that building and uploading them doesn't
+ * need an allocation per quad.
+ */
 class KWINEFFECTS_EXPORT WindowQuadList
-    : public QList< WindowQuad >
+    : public QVector< WindowQuad >
 {
 public:
     WindowQuadList splitAtX(double x) const;
@@ -3828,6 +3884,14 @@ void WindowVertex::setY(double y)
  WindowQuad
 ***************************************************************/
 
+inline
+WindowQuad::WindowQuad()
+    : quadType(WindowQuadError)
+    , uvSwapped(false)
+    , quadID(-1)
+{
+}
+
 inline
 WindowQuad::WindowQuad(WindowQuadType t, int id)
     : quadType(t)
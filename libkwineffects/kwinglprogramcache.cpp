@@ -0,0 +1,178 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2020 KWin developers <kwin@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "kwinglprogramcache_p.h"
+
+#include "kwinglplatform.h"
+#include "kwinglutils.h"
+#include "logging_p.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+namespace KWin
+{
+
+static const quint32 s_magic = 0x4b574750; // "KWGP"
+static const quint32 s_version = 1;
+
+GLProgramCache::GLProgramCache()
+{
+    if (qEnvironmentVariableIsSet("KWIN_NO_GL_PROGRAM_CACHE")) {
+        return;
+    }
+
+    GLPlatform *platform = GLPlatform::instance();
+    if (platform->isGLES()) {
+        m_supported = hasGLVersion(3, 0);
+    } else {
+        m_supported = hasGLVersion(4, 1) || hasGLExtension(QByteArrayLiteral("GL_ARB_get_program_binary"));
+    }
+    if (!m_supported) {
+        return;
+    }
+
+    // Drivers are allowed to support the extension without any binary format
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &count);
+    if (count > 0) {
+        m_formats.resize(count);
+        glGetIntegerv(GL_PROGRAM_BINARY_FORMATS, m_formats.data());
+    }
+
+    const QString cacheLocation = QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation);
+    m_supported = !m_formats.isEmpty() && !cacheLocation.isEmpty();
+    if (!m_supported) {
+        return;
+    }
+    m_directory = cacheLocation + QStringLiteral("/kwin/glprograms");
+
+    m_driver = platform->glVendorString() + '\n' +
+               platform->glRendererString() + '\n' +
+               platform->glVersionString() + '\n' +
+               platform->glShadingLanguageVersionString();
+}
+
+GLProgramCache::~GLProgramCache()
+{
+    if (m_loaded == 0 && m_compiled == 0) {
+        return;
+    }
+    qCInfo(LIBKWINGLUTILS) << "Loaded" << m_loaded << "shader programs from the cache, saving"
+                           << m_savedTime / 1000000 << "ms of compile time;"
+                           << m_compiled << "programs were compiled and added to the cache";
+}
+
+bool GLProgramCache::isSupported() const
+{
+    return m_supported;
+}
+
+QByteArray GLProgramCache::key(const QByteArray &vertexSource, const QByteArray &fragmentSource, const QByteArray &bindings) const
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(m_driver);
+    hash.addData("\0", 1);
+    hash.addData(bindings);
+    hash.addData("\0", 1);
+    hash.addData(vertexSource);
+    hash.addData("\0", 1);
+    hash.addData(fragmentSource);
+    return hash.result().toHex();
+}
+
+QString GLProgramCache::fileName(const QByteArray &key) const
+{
+    return m_directory + QLatin1Char('/') + QString::fromLatin1(key);
+}
+
+GLuint GLProgramCache::load(const QByteArray &key)
+{
+    QFile file(fileName(key));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return 0;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    quint32 magic = 0;
+    quint32 version = 0;
+    quint32 format = 0;
+    qint64 compileTime = 0;
+    QByteArray binary;
+
+    QDataStream stream(&file);
+    stream >> magic >> version >> format >> compileTime >> binary;
+    if (stream.status() != QDataStream::Ok || magic != s_magic || version != s_version ||
+            binary.isEmpty() || !m_formats.contains(GLint(format))) {
+        qCDebug(LIBKWINGLUTILS) << "Removing invalid shader program cache entry" << file.fileName();
+        file.remove();
+        return 0;
+    }
+
+    GLuint program = glCreateProgram();
+    glProgramBinary(program, format, binary.constData(), binary.size());
+
+    // The driver may reject the binary, e.g. after an update that kept the version string
+    GLint status = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if (status == 0) {
+        qCDebug(LIBKWINGLUTILS) << "Shader program binary was rejected by the driver" << file.fileName();
+        glDeleteProgram(program);
+        file.remove();
+        return 0;
+    }
+
+    ++m_loaded;
+    m_savedTime += compileTime - timer.nsecsElapsed();
+    return program;
+}
+
+void GLProgramCache::prepare(GLuint program) const
+{
+    glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+void GLProgramCache::store(GLuint program, const QByteArray &key, qint64 compileTime)
+{
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return;
+    }
+
+    QByteArray binary(length, Qt::Uninitialized);
+    GLenum format = 0;
+    glGetProgramBinary(program, length, &length, &format, binary.data());
+    binary.resize(length);
+
+    if (!QDir().mkpath(m_directory)) {
+        qCWarning(LIBKWINGLUTILS) << "Failed to create the shader program cache" << m_directory;
+        return;
+    }
+
+    QSaveFile file(fileName(key));
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(LIBKWINGLUTILS) << "Failed to write the shader program cache entry" << file.fileName();
+        return;
+    }
+    QDataStream stream(&file);
+    stream << s_magic << s_version << quint32(format) << compileTime << binary;
+    if (file.commit()) {
+        ++m_compiled;
+    }
+}
+
+} // namespace KWin
@@ -0,0 +1,80 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2020 KWin developers <kwin@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef KWIN_GLPROGRAMCACHE_P_H
+#define KWIN_GLPROGRAMCACHE_P_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+#include <epoxy/gl.h>
+
+namespace KWin
+{
+
+/**
+ * The GLProgramCache class stores linked shader programs on disk, so that they don't have
+ * to be compiled again in the next session.
+ *
+ * The programs are stored in the driver specific binary format returned by glGetProgramBinary.
+ * The cache key covers the GL vendor, renderer and version strings, so a driver update or a
+ * different GPU never picks up a stale binary. Should the driver reject a binary anyway, the
+ * entry is removed and the program is compiled from source.
+ */
+class GLProgramCache
+{
+public:
+    GLProgramCache();
+    ~GLProgramCache();
+
+    /**
+     * @returns @c true if the driver supports retrieving and loading program binaries.
+     */
+    bool isSupported() const;
+
+    /**
+     * Computes the key of the program built from the given sources. The @p bindings
+     * describe the attribute and fragment data locations which are bound before linking.
+     */
+    QByteArray key(const QByteArray &vertexSource, const QByteArray &fragmentSource, const QByteArray &bindings) const;
+
+    /**
+     * Creates a program from the binary stored for @p key.
+     * @returns the linked program or @c 0 if there is no usable binary.
+     */
+    GLuint load(const QByteArray &key);
+
+    /**
+     * Marks the @p program as retrievable. Has to be called before the program is linked.
+     */
+    void prepare(GLuint program) const;
+
+    /**
+     * Stores the binary of the linked @p program for @p key. The @p compileTime in
+     * nanoseconds is kept to report the time saved when the binary is loaded.
+     */
+    void store(GLuint program, const QByteArray &key, qint64 compileTime);
+
+private:
+    QString fileName(const QByteArray &key) const;
+
+    bool m_supported = false;
+    QVector<GLint> m_formats;
+    QByteArray m_driver;
+    QString m_directory;
+
+    int m_loaded = 0;
+    int m_compiled = 0;
+    qint64 m_savedTime = 0;
+};
+
+} // namespace KWin
+
+#endif // KWIN_GLPROGRAMCACHE_P_H
@@ -24,6 +24,8 @@
 #include <QVector4D>
 #include <QMatrix4x4>
 
+#include <cstring>
+
 namespace KWin
 {
 
@@ -37,8 +39,10 @@ bool GLTexturePrivate::s_supportsUnpack = false;
 bool GLTexturePrivate::s_supportsTextureStorage = false;
 bool GLTexturePrivate::s_supportsTextureSwizzle = false;
 bool GLTexturePrivate::s_supportsTextureFormatRG = false;
+bool GLTexturePrivate::s_supportsPixelBufferObjects = false;
 uint GLTexturePrivate::s_textureObjectCounter = 0;
 uint GLTexturePrivate::s_fbo = 0;
+uint GLTexturePrivate::s_pixelUnpackBuffer = 0;
 
 
 GLTexture::GLTexture()
@@ -288,6 +292,10 @@ GLTexturePrivate::~GLTexturePrivate()
         glDeleteFramebuffers(1, &s_fbo);
         s_fbo = 0;
     }
+    if (s_textureObjectCounter == 0 && s_pixelUnpackBuffer) {
+        glDeleteBuffers(1, &s_pixelUnpackBuffer);
+        s_pixelUnpackBuffer = 0;
+    }
 }
 
 void GLTexturePrivate::initStatic()
@@ -301,6 +309,8 @@ void GLTexturePrivate::initStatic()
         s_supportsTextureFormatRG = hasGLVersion(3, 0) || hasGLExtension(QByteArrayLiteral("GL_ARB_texture_rg"));
         s_supportsARGB32 = true;
         s_supportsUnpack = true;
+        s_supportsPixelBufferObjects = hasGLVersion(3, 0) ||
+            (hasGLExtension(QByteArrayLiteral("GL_ARB_pixel_buffer_object")) && hasGLExtension(QByteArrayLiteral("GL_ARB_map_buffer_range")));
     } else {
         s_supportsFramebufferObjects = true;
         s_supportsTextureStorage = hasGLVersion(3, 0) || hasGLExtension(QByteArrayLiteral("GL_EXT_texture_storage"));
@@ -313,7 +323,11 @@ void GLTexturePrivate::initStatic()
         s_supportsARGB32 = QSysInfo::ByteOrder == QSysInfo::LittleEndian &&
             hasGLExtension(QByteArrayLiteral("GL_EXT_texture_format_BGRA8888"));
 
-        s_supportsUnpack = hasGLExtension(QByteArrayLiteral("GL_EXT_unpack_subimage"));
+        s_supportsUnpack = hasGLVersion(3, 0) || hasGLExtension(QByteArrayLiteral("GL_EXT_unpack_subimage"));
+        s_supportsPixelBufferObjects = hasGLVersion(3, 0);
+    }
+    if (qgetenv("KWIN_GL_PBO_UPLOAD") == QByteArrayLiteral("0")) {
+        s_supportsPixelBufferObjects = false;
     }
 }
 
@@ -321,6 +335,92 @@ void GLTexturePrivate::cleanup()
 {
     s_supportsFramebufferObjects = false;
     s_supportsARGB32 = false;
+    s_supportsPixelBufferObjects = false;
+}
+
+// Returns the @p rect of @p image, sharing the pixel data where possible
+static QImage subImage(const QImage &image, const QRect &rect)
+{
+    if (image.depth() < 8 || image.colorCount() > 0) {
+        return image.copy(rect);
+    }
+    const uchar *data = image.constScanLine(rect.y()) + rect.x() * (image.depth() / 8);
+    return QImage(data, rect.width(), rect.height(), image.bytesPerLine(), image.format());
+}
+
+void GLTexturePrivate::updateRegion(const QImage &image, const QRegion &region, const QPoint &offset,
+                                    QImage::Format uploadFormat, GLenum format, GLenum type)
+{
+    const QRegion area = region & image.rect();
+    if (area.isEmpty()) {
+        return;
+    }
+    const bool direct = image.format() == uploadFormat && image.bytesPerLine() % 4 == 0;
+    const int bytesPerPixel = 4;
+
+    if (s_supportsPixelBufferObjects) {
+        qsizetype size = 0;
+        for (const QRect &rect : area) {
+            size += rect.width() * rect.height() * bytesPerPixel;
+        }
+
+        if (!s_pixelUnpackBuffer) {
+            glGenBuffers(1, &s_pixelUnpackBuffer);
+        }
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, s_pixelUnpackBuffer);
+        // orphan the previous storage, so that we don't have to wait for pending uploads
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+        uchar *map = static_cast<uchar *>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size,
+                                                           GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+        if (map) {
+            uchar *dest = map;
+            for (const QRect &rect : area) {
+                const int rowSize = rect.width() * bytesPerPixel;
+                if (direct) {
+                    for (int y = rect.top(); y <= rect.bottom(); ++y) {
+                        memcpy(dest, image.constScanLine(y) + rect.x() * bytesPerPixel, rowSize);
+                        dest += rowSize;
+                    }
+                } else {
+                    const QImage converted = subImage(image, rect).convertToFormat(uploadFormat);
+                    for (int y = 0; y < converted.height(); ++y) {
+                        memcpy(dest, converted.constScanLine(y), rowSize);
+                        dest += rowSize;
+                    }
+                }
+            }
+            if (glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER)) {
+                qsizetype bufferOffset = 0;
+                for (const QRect &rect : area) {
+                    glTexSubImage2D(m_target, 0, rect.x() + offset.x(), rect.y() + offset.y(),
+                                    rect.width(), rect.height(), format, type,
+                                    reinterpret_cast<const void *>(bufferOffset));
+                    bufferOffset += rect.width() * rect.height() * bytesPerPixel;
+                }
+                glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+                return;
+            }
+        }
+        // the buffer could not be mapped or its content got lost, upload from client memory
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+
+    if (direct && s_supportsUnpack) {
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, image.bytesPerLine() / bytesPerPixel);
+        for (const QRect &rect : area) {
+            glTexSubImage2D(m_target, 0, rect.x() + offset.x(), rect.y() + offset.y(),
+                            rect.width(), rect.height(), format, type,
+                            image.constScanLine(rect.y()) + rect.x() * bytesPerPixel);
+        }
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+        return;
+    }
+
+    for (const QRect &rect : area) {
+        const QImage im = direct ? image.copy(rect) : subImage(image, rect).convertToFormat(uploadFormat);
+        glTexSubImage2D(m_target, 0, rect.x() + offset.x(), rect.y() + offset.y(),
+                        rect.width(), rect.height(), format, type, im.constBits());
+    }
 }
 
 bool GLTexture::isNull() const
@@ -343,51 +443,22 @@ void GLTexture::update(const QImage &image, const QPoint &offset, const QRect &s
     Q_D(GLTexture);
     Q_ASSERT(!d->m_foreign);
 
-    bool useUnpack = !src.isNull() && d->s_supportsUnpack && d->s_supportsARGB32 && image.format() == QImage::Format_ARGB32_Premultiplied;
-
-    int width = image.width();
-    int height = image.height();
-    QImage tmpImage;
-
-    if (!src.isNull()) {
-        if (useUnpack) {
-            glPixelStorei(GL_UNPACK_ROW_LENGTH, image.width());
-            glPixelStorei(GL_UNPACK_SKIP_PIXELS, src.x());
-            glPixelStorei(GL_UNPACK_SKIP_ROWS, src.y());
-        } else {
-            tmpImage = image.copy(src);
-        }
-        width = src.width();
-        height = src.height();
-    }
-
-    const QImage &img = tmpImage.isNull() ? image : tmpImage;
+    const QRect source = src.isNull() ? image.rect() : src;
 
     bind();
 
     if (!GLPlatform::instance()->isGLES()) {
-        const QImage im = img.convertToFormat(QImage::Format_ARGB32_Premultiplied);
-        glTexSubImage2D(d->m_target, 0, offset.x(), offset.y(), width, height,
-                        GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV, im.bits());
+        d->updateRegion(image, source, offset - source.topLeft(), QImage::Format_ARGB32_Premultiplied,
+                        GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV);
+    } else if (d->s_supportsARGB32) {
+        d->updateRegion(image, source, offset - source.topLeft(), QImage::Format_ARGB32_Premultiplied,
+                        GL_BGRA_EXT, GL_UNSIGNED_BYTE);
     } else {
-        if (d->s_supportsARGB32) {
-            const QImage im = img.convertToFormat(QImage::Format_ARGB32_Premultiplied);
-            glTexSubImage2D(d->m_target, 0, offset.x(), offset.y(), width, height,
-                            GL_BGRA_EXT, GL_UNSIGNED_BYTE, im.bits());
-        } else {
-            const QImage im = img.convertToFormat(QImage::Format_RGBA8888_Premultiplied);
-            glTexSubImage2D(d->m_target, 0, offset.x(), offset.y(), width, height,
-                            GL_RGBA, GL_UNSIGNED_BYTE, im.bits());
-        }
+        d->updateRegion(image, source, offset - source.topLeft(), QImage::Format_RGBA8888_Premultiplied,
+                        GL_RGBA, GL_UNSIGNED_BYTE);
     }
 
     unbind();
-
-    if (useUnpack) {
-        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
-        glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
-        glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
-    }
 }
 
 void GLTexture::discard()
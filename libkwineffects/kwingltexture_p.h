@@ -16,6 +16,7 @@
 #include "kwinglutils.h"
 #include <kwinglutils_export.h>
 
+#include <QRegion>
 #include <QSize>
 #include <QSharedData>
 #include <QImage>
@@ -38,6 +39,17 @@ public:
 
     void updateMatrix();
 
+    /**
+     * Uploads the @p region of @p image into the bound texture, moved by @p offset.
+     *
+     * The pixels are passed to GL as @p format and @p type, which have to describe the
+     * memory layout of @p uploadFormat. If the image already has that format, the damaged
+     * rectangles are read straight from the image's memory, otherwise only they get
+     * converted. If supported, the pixels are streamed through a pixel buffer object.
+     */
+    void updateRegion(const QImage &image, const QRegion &region, const QPoint &offset,
+                      QImage::Format uploadFormat, GLenum format, GLenum type);
+
     GLuint m_texture;
     GLenum m_target;
     GLenum m_internalFormat;
@@ -68,7 +80,9 @@ public:
     static bool s_supportsTextureStorage;
     static bool s_supportsTextureSwizzle;
     static bool s_supportsTextureFormatRG;
+    static bool s_supportsPixelBufferObjects;
     static GLuint s_fbo;
+    static GLuint s_pixelUnpackBuffer;
     static uint s_textureObjectCounter;
 private:
     friend void KWin::cleanupGL();
@@ -15,10 +15,12 @@
 
 #include "kwineffects.h"
 #include "kwinglplatform.h"
+#include "kwinglprogramcache_p.h"
 #include "logging_p.h"
 
 #include <QPixmap>
 #include <QImage>
+#include <QElapsedTimer>
 #include <QHash>
 #include <QFile>
 #include <QVector2D>
@@ -542,6 +544,7 @@ void ShaderManager::cleanup()
 }
 
 ShaderManager::ShaderManager()
+    : m_programCache(new GLProgramCache)
 {
     const qint64 coreVersionNumber = GLPlatform::instance()->isGLES() ? kVersionNumber(3, 0) : kVersionNumber(1, 40);
     if (GLPlatform::instance()->glslVersion() >= coreVersionNumber) {
@@ -915,15 +918,7 @@ GLShader *ShaderManager::generateCustomShader(ShaderTraits traits, const QByteAr
     qCDebug(LIBKWINGLUTILS) << "**************";
 #endif
 
-    GLShader *shader = new GLShader(GLShader::ExplicitLinking);
-    shader->load(vertex, fragment);
-
-    shader->bindAttributeLocation("position", VA_Position);
-    shader->bindAttributeLocation("texcoord", VA_TexCoord);
-    shader->bindFragDataLocation("fragColor", 0);
-
-    shader->link();
-    return shader;
+    return linkShader(vertex, fragment, "position", "texcoord");
 }
 
 GLShader *ShaderManager::generateShaderFromResources(ShaderTraits traits, const QString &vertexFile, const QString &fragmentFile)
@@ -1011,24 +1006,44 @@ void ShaderManager::popShader()
     }
 }
 
-void ShaderManager::bindFragDataLocations(GLShader *shader)
-{
-    shader->bindFragDataLocation("fragColor", 0);
-}
-
-void ShaderManager::bindAttributeLocations(GLShader *shader) const
+GLShader *ShaderManager::loadShaderFromCode(const QByteArray &vertexSource, const QByteArray &fragmentSource)
 {
-    shader->bindAttributeLocation("vertex",   VA_Position);
-    shader->bindAttributeLocation("texCoord", VA_TexCoord);
+    return linkShader(vertexSource, fragmentSource, "vertex", "texCoord");
 }
 
-GLShader *ShaderManager::loadShaderFromCode(const QByteArray &vertexSource, const QByteArray &fragmentSource)
+GLShader *ShaderManager::linkShader(const QByteArray &vertexSource, const QByteArray &fragmentSource,
+                                    const char *positionName, const char *texCoordName)
 {
     GLShader *shader = new GLShader(GLShader::ExplicitLinking);
+
+    QByteArray key;
+    if (m_programCache->isSupported()) {
+        key = m_programCache->key(shader->prepareSource(GL_VERTEX_SHADER, vertexSource),
+                                  shader->prepareSource(GL_FRAGMENT_SHADER, fragmentSource),
+                                  QByteArray(positionName) + ',' + texCoordName + ",fragColor");
+        if (const GLuint program = m_programCache->load(key)) {
+            glDeleteProgram(shader->mProgram);
+            shader->mProgram = program;
+            shader->mValid = true;
+            return shader;
+        }
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
     shader->load(vertexSource, fragmentSource);
-    bindAttributeLocations(shader);
-    bindFragDataLocations(shader);
-    shader->link();
+
+    shader->bindAttributeLocation(positionName, VA_Position);
+    shader->bindAttributeLocation(texCoordName, VA_TexCoord);
+    shader->bindFragDataLocation("fragColor", 0);
+
+    if (!key.isEmpty()) {
+        m_programCache->prepare(shader->mProgram);
+    }
+    if (shader->link() && !key.isEmpty()) {
+        m_programCache->store(shader->mProgram, key, timer.nsecsElapsed());
+    }
     return shader;
 }
 
@@ -17,6 +17,7 @@
 #include "kwingltexture.h"
 
 // Qt
+#include <QScopedPointer>
 #include <QSize>
 #include <QStack>
 
@@ -34,6 +35,7 @@ template< class K, class V > class QHash;
 namespace KWin
 {
 
+class GLProgramCache;
 class GLVertexBuffer;
 class GLVertexBufferPrivate;
 
@@ -305,8 +307,8 @@ private:
     ShaderManager();
     ~ShaderManager();
 
-    void bindFragDataLocations(GLShader *shader);
-    void bindAttributeLocations(GLShader *shader) const;
+    GLShader *linkShader(const QByteArray &vertexSource, const QByteArray &fragmentSource,
+                         const char *positionName, const char *texCoordName);
 
     QByteArray generateVertexSource(ShaderTraits traits) const;
     QByteArray generateFragmentSource(ShaderTraits traits) const;
@@ -315,6 +317,7 @@ private:
     QStack<GLShader*> m_boundShaders;
     QHash<ShaderTraits, GLShader *> m_shaderHash;
     QString m_resourcePath;
+    QScopedPointer<GLProgramCache> m_programCache;
     static ShaderManager *s_shaderManager;
 };
 
@@ -0,0 +1,453 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2020 KWin developers <kwin@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "paintrecorder.h"
+
+#include <QGlyphRun>
+#include <QImage>
+#include <QPaintEngine>
+#include <QPainter>
+#include <QPainterPath>
+#include <QTextLayout>
+#include <QtConcurrentMap>
+
+#include <algorithm>
+
+namespace KWin
+{
+
+// Height of the tiles the target is split into during the replay
+static const int s_tileHeight = 64;
+
+/**
+ * Paint engine which turns every state change and drawing operation into a command
+ * of the PaintRecorder. It claims all features, so that QPainter passes primitives
+ * and transformations on unchanged instead of emulating them.
+ */
+class PaintRecorderEngine : public QPaintEngine
+{
+public:
+    explicit PaintRecorderEngine(PaintRecorder *recorder);
+
+    bool begin(QPaintDevice *device) override;
+    bool end() override;
+    Type type() const override;
+
+    void updateState(const QPaintEngineState &state) override;
+
+    void drawRects(const QRect *rects, int rectCount) override;
+    void drawRects(const QRectF *rects, int rectCount) override;
+    void drawLines(const QLine *lines, int lineCount) override;
+    void drawLines(const QLineF *lines, int lineCount) override;
+    void drawEllipse(const QRectF &rect) override;
+    void drawEllipse(const QRect &rect) override;
+    void drawPath(const QPainterPath &path) override;
+    void drawPoints(const QPointF *points, int pointCount) override;
+    void drawPoints(const QPoint *points, int pointCount) override;
+    void drawPolygon(const QPointF *points, int pointCount, PolygonDrawMode mode) override;
+    void drawPolygon(const QPoint *points, int pointCount, PolygonDrawMode mode) override;
+    void drawPixmap(const QRectF &r, const QPixmap &pm, const QRectF &sr) override;
+    void drawImage(const QRectF &r, const QImage &pm, const QRectF &sr, Qt::ImageConversionFlags flags) override;
+    void drawTextItem(const QPointF &p, const QTextItem &textItem) override;
+
+private:
+    static void replayPolygon(QPainter *painter, const QPolygonF &polygon, PolygonDrawMode mode);
+    static void replayPolygon(QPainter *painter, const QPolygon &polygon, PolygonDrawMode mode);
+
+    PaintRecorder *m_recorder;
+};
+
+PaintRecorderEngine::PaintRecorderEngine(PaintRecorder *recorder)
+    : QPaintEngine(QPaintEngine::AllFeatures)
+    , m_recorder(recorder)
+{
+}
+
+bool PaintRecorderEngine::begin(QPaintDevice *device)
+{
+    Q_UNUSED(device)
+    return true;
+}
+
+bool PaintRecorderEngine::end()
+{
+    return true;
+}
+
+QPaintEngine::Type PaintRecorderEngine::type() const
+{
+    return QPaintEngine::User;
+}
+
+void PaintRecorderEngine::updateState(const QPaintEngineState &state)
+{
+    const DirtyFlags flags = state.state();
+    if (flags & DirtyPen) {
+        const QPen pen = state.pen();
+        m_recorder->record([pen] (QPainter *painter, const QTransform &) {
+            painter->setPen(pen);
+        });
+    }
+    if (flags & DirtyBrush) {
+        const QBrush brush = state.brush();
+        m_recorder->record([brush] (QPainter *painter, const QTransform &) {
+            painter->setBrush(brush);
+        });
+    }
+    if (flags & DirtyBrushOrigin) {
+        const QPointF origin = state.brushOrigin();
+        m_recorder->record([origin] (QPainter *painter, const QTransform &) {
+            painter->setBrushOrigin(origin);
+        });
+    }
+    if (flags & DirtyFont) {
+        const QFont font = state.font();
+        m_recorder->record([font] (QPainter *painter, const QTransform &) {
+            painter->setFont(font);
+        });
+    }
+    if (flags & DirtyBackground) {
+        const QBrush background = state.backgroundBrush();
+        m_recorder->record([background] (QPainter *painter, const QTransform &) {
+            painter->setBackground(background);
+        });
+    }
+    if (flags & DirtyBackgroundMode) {
+        const Qt::BGMode mode = state.backgroundMode();
+        m_recorder->record([mode] (QPainter *painter, const QTransform &) {
+            painter->setBackgroundMode(mode);
+        });
+    }
+    if (flags & DirtyHints) {
+        const QPainter::RenderHints hints = state.renderHints();
+        m_recorder->record([hints] (QPainter *painter, const QTransform &) {
+            painter->setRenderHints(QPainter::RenderHints(~0), false);
+            painter->setRenderHints(hints, true);
+        });
+    }
+    if (flags & DirtyCompositionMode) {
+        const QPainter::CompositionMode mode = state.compositionMode();
+        m_recorder->record([mode] (QPainter *painter, const QTransform &) {
+            painter->setCompositionMode(mode);
+        });
+    }
+    if (flags & DirtyOpacity) {
+        const qreal opacity = state.opacity();
+        m_recorder->record([opacity] (QPainter *painter, const QTransform &) {
+            painter->setOpacity(opacity);
+        });
+    }
+    // QPainter hands a clip over as soon as it is set, so it is given in logical coordinates
+    // of the transformation current at this point. The clip keeps that transformation for the
+    // replay, a later change of the transformation must not move an already applied clip.
+    if (flags & DirtyClipRegion) {
+        const QRegion region = state.clipRegion();
+        const Qt::ClipOperation operation = state.clipOperation();
+        const QTransform transform = state.transform();
+        m_recorder->record([region, operation, transform] (QPainter *painter, const QTransform &base) {
+            const QTransform current = painter->transform();
+            painter->setTransform(transform * base);
+            painter->setClipRegion(region, operation);
+            painter->setTransform(current);
+        });
+    }
+    if (flags & DirtyClipPath) {
+        const QPainterPath path = state.clipPath();
+        const Qt::ClipOperation operation = state.clipOperation();
+        const QTransform transform = state.transform();
+        m_recorder->record([path, operation, transform] (QPainter *painter, const QTransform &base) {
+            const QTransform current = painter->transform();
+            painter->setTransform(transform * base);
+            painter->setClipPath(path, operation);
+            painter->setTransform(current);
+        });
+    }
+    if (flags & DirtyClipEnabled) {
+        const bool enabled = state.isClipEnabled();
+        m_recorder->record([enabled] (QPainter *painter, const QTransform &) {
+            painter->setClipping(enabled);
+        });
+    }
+    if (flags & DirtyTransform) {
+        const QTransform transform = state.transform();
+        m_recorder->record([transform] (QPainter *painter, const QTransform &base) {
+            painter->setTransform(transform * base);
+        });
+    }
+}
+
+void PaintRecorderEngine::drawRects(const QRect *rects, int rectCount)
+{
+    const QVector<QRect> recorded(rects, rects + rectCount);
+    m_recorder->record([recorded] (QPainter *painter, const QTransform &) {
+        painter->drawRects(recorded);
+    });
+}
+
+void PaintRecorderEngine::drawRects(const QRectF *rects, int rectCount)
+{
+    const QVector<QRectF> recorded(rects, rects + rectCount);
+    m_recorder->record([recorded] (QPainter *painter, const QTransform &) {
+        painter->drawRects(recorded);
+    });
+}
+
+void PaintRecorderEngine::drawLines(const QLine *lines, int lineCount)
+{
+    const QVector<QLine> recorded(lines, lines + lineCount);
+    m_recorder->record([recorded] (QPainter *painter, const QTransform &) {
+        painter->drawLines(recorded);
+    });
+}
+
+void PaintRecorderEngine::drawLines(const QLineF *lines, int lineCount)
+{
+    const QVector<QLineF> recorded(lines, lines + lineCount);
+    m_recorder->record([recorded] (QPainter *painter, const QTransform &) {
+        painter->drawLines(recorded);
+    });
+}
+
+void PaintRecorderEngine::drawEllipse(const QRectF &rect)
+{
+    m_recorder->record([rect] (QPainter *painter, const QTransform &) {
+        painter->drawEllipse(rect);
+    });
+}
+
+void PaintRecorderEngine::drawEllipse(const QRect &rect)
+{
+    m_recorder->record([rect] (QPainter *painter, const QTransform &) {
+        painter->drawEllipse(rect);
+    });
+}
+
+void PaintRecorderEngine::drawPath(const QPainterPath &path)
+{
+    m_recorder->record([path] (QPainter *painter, const QTransform &) {
+        painter->drawPath(path);
+    });
+}
+
+void PaintRecorderEngine::drawPoints(const QPointF *points, int pointCount)
+{
+    const QPolygonF recorded(QVector<QPointF>(points, points + pointCount));
+    m_recorder->record([recorded] (QPainter *painter, const QTransform &) {
+        painter->drawPoints(recorded);
+    });
+}
+
+void PaintRecorderEngine::drawPoints(const QPoint *points, int pointCount)
+{
+    const QPolygon recorded(QVector<QPoint>(points, points + pointCount));
+    m_recorder->record([recorded] (QPainter *painter, const QTransform &) {
+        painter->drawPoints(recorded);
+    });
+}
+
+void PaintRecorderEngine::drawPolygon(const QPointF *points, int pointCount, PolygonDrawMode mode)
+{
+    const QPolygonF recorded(QVector<QPointF>(points, points + pointCount));
+    m_recorder->record([recorded, mode] (QPainter *painter, const QTransform &) {
+        replayPolygon(painter, recorded, mode);
+    });
+}
+
+void PaintRecorderEngine::drawPolygon(const QPoint *points, int pointCount, PolygonDrawMode mode)
+{
+    const QPolygon recorded(QVector<QPoint>(points, points + pointCount));
+    m_recorder->record([recorded, mode] (QPainter *painter, const QTransform &) {
+        replayPolygon(painter, recorded, mode);
+    });
+}
+
+void PaintRecorderEngine::replayPolygon(QPainter *painter, const QPolygonF &polygon, PolygonDrawMode mode)
+{
+    switch (mode) {
+    case OddEvenMode:
+        painter->drawPolygon(polygon, Qt::OddEvenFill);
+        break;
+    case WindingMode:
+        painter->drawPolygon(polygon, Qt::WindingFill);
+        break;
+    case ConvexMode:
+        painter->drawConvexPolygon(polygon);
+        break;
+    case PolylineMode:
+        painter->drawPolyline(polygon);
+        break;
+    }
+}
+
+void PaintRecorderEngine::replayPolygon(QPainter *painter, const QPolygon &polygon, PolygonDrawMode mode)
+{
+    switch (mode) {
+    case OddEvenMode:
+        painter->drawPolygon(polygon, Qt::OddEvenFill);
+        break;
+    case WindingMode:
+        painter->drawPolygon(polygon, Qt::WindingFill);
+        break;
+    case ConvexMode:
+        painter->drawConvexPolygon(polygon);
+        break;
+    case PolylineMode:
+        painter->drawPolyline(polygon);
+        break;
+    }
+}
+
+void PaintRecorderEngine::drawPixmap(const QRectF &r, const QPixmap &pm, const QRectF &sr)
+{
+    // pixmaps must not be used outside of the gui thread, the raster engine
+    // paints them as images anyway
+    drawImage(r, pm.toImage(), sr, Qt::AutoColor);
+}
+
+void PaintRecorderEngine::drawImage(const QRectF &r, const QImage &pm, const QRectF &sr, Qt::ImageConversionFlags flags)
+{
+    m_recorder->record([r, pm, sr, flags] (QPainter *painter, const QTransform &) {
+        painter->drawImage(r, pm, sr, flags);
+    });
+}
+
+void PaintRecorderEngine::drawTextItem(const QPointF &p, const QTextItem &textItem)
+{
+    // the text item is only valid during this call, shape it once into glyph runs
+    // so that the replay of every tile only has to rasterize the glyphs
+    QTextOption option;
+    option.setTextDirection(textItem.renderFlags() & QTextItem::RightToLeft ? Qt::RightToLeft : Qt::LeftToRight);
+    QTextLayout layout(textItem.text(), textItem.font(), m_recorder);
+    layout.setTextOption(option);
+    layout.beginLayout();
+    const QTextLine line = layout.createLine();
+    layout.endLayout();
+    if (!line.isValid()) {
+        return;
+    }
+
+    // the glyph positions are relative to the top of the line, p is on the baseline
+    const QPointF position = p - QPointF(0, line.ascent());
+    const QList<QGlyphRun> runs = layout.glyphRuns();
+    m_recorder->record([position, runs] (QPainter *painter, const QTransform &) {
+        for (const QGlyphRun &run : runs) {
+            painter->drawGlyphRun(position, run);
+        }
+    });
+}
+
+PaintRecorder::PaintRecorder()
+    : m_engine(new PaintRecorderEngine(this))
+{
+}
+
+PaintRecorder::~PaintRecorder() = default;
+
+void PaintRecorder::setTarget(QImage *target)
+{
+    m_target = target;
+}
+
+QImage *PaintRecorder::target() const
+{
+    return m_target;
+}
+
+QPaintEngine *PaintRecorder::paintEngine() const
+{
+    return m_engine.data();
+}
+
+void PaintRecorder::record(Command &&command)
+{
+    m_commands.append(std::move(command));
+}
+
+void PaintRecorder::clear()
+{
+    m_commands.clear();
+}
+
+void PaintRecorder::replay(const QRegion &region, ReplayMode mode)
+{
+    if (!m_target || m_target->isNull() || m_commands.isEmpty()) {
+        clear();
+        return;
+    }
+
+    QVector<QRect> tiles;
+    const QRect bounds = m_target->rect();
+    for (int y = 0; y < bounds.height(); y += s_tileHeight) {
+        const QRect tile(0, y, bounds.width(), qMin(s_tileHeight, bounds.height() - y));
+        if (region.intersects(tile)) {
+            tiles << tile;
+        }
+    }
+
+    // detach once on this thread, the tiles only share the pixel data
+    uchar *bits = m_target->bits();
+    const int bytesPerLine = m_target->bytesPerLine();
+    const QImage::Format format = m_target->format();
+
+    auto replayTile = [this, bits, bytesPerLine, format] (const QRect &tile) {
+        QImage image(bits + tile.y() * bytesPerLine, tile.width(), tile.height(), bytesPerLine, format);
+        const QTransform base = QTransform::fromTranslate(-tile.x(), -tile.y());
+        QPainter painter(&image);
+        painter.setTransform(base);
+        for (const Command &command : qAsConst(m_commands)) {
+            command(&painter, base);
+        }
+    };
+
+    switch (mode) {
+    case ReplayMode::Parallel:
+        QtConcurrent::blockingMap(tiles, replayTile);
+        break;
+    case ReplayMode::Sequential:
+        std::for_each(tiles.constBegin(), tiles.constEnd(), replayTile);
+        break;
+    }
+
+    clear();
+}
+
+int PaintRecorder::metric(PaintDeviceMetric metric) const
+{
+    if (!m_target) {
+        return QPaintDevice::metric(metric);
+    }
+    switch (metric) {
+    case PdmWidth:
+        return m_target->width();
+    case PdmHeight:
+        return m_target->height();
+    case PdmWidthMM:
+        return m_target->widthMM();
+    case PdmHeightMM:
+        return m_target->heightMM();
+    case PdmNumColors:
+        return m_target->colorCount();
+    case PdmDepth:
+        return m_target->depth();
+    case PdmDpiX:
+        return m_target->logicalDpiX();
+    case PdmDpiY:
+        return m_target->logicalDpiY();
+    case PdmPhysicalDpiX:
+        return m_target->physicalDpiX();
+    case PdmPhysicalDpiY:
+        return m_target->physicalDpiY();
+    case PdmDevicePixelRatio:
+        return m_target->devicePixelRatio();
+    case PdmDevicePixelRatioScaled:
+        return int(m_target->devicePixelRatioF() * QPaintDevice::devicePixelRatioFScale());
+    }
+    return QPaintDevice::metric(metric);
+}
+
+}
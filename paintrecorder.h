@@ -0,0 +1,99 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2020 KWin developers <kwin@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include <kwin_export.h>
+
+#include <QPaintDevice>
+#include <QRegion>
+#include <QScopedPointer>
+#include <QTransform>
+#include <QVector>
+
+#include <functional>
+
+class QImage;
+class QPainter;
+
+namespace KWin
+{
+
+class PaintRecorderEngine;
+
+/**
+ * @brief Paint device which records all painting operations instead of rasterizing them.
+ *
+ * The recorded operations can be replayed later on into a QImage. The replay splits the
+ * image into horizontal tiles and rasterizes them on the global thread pool, every tile
+ * on its own QPainter. Every tile only touches its own rows of the image and the raster
+ * paint engine produces the same result for integer translations, so shapes, images,
+ * clips and transformations end up with the same pixels as when painting directly into
+ * the image.
+ *
+ * Text is not replayed as text: it is laid out once while recording with QTextLayout and
+ * stored as glyph runs. Justification, letter spacing or shaping the paint engine applies
+ * for QPainter::drawText() are not reproduced, so text can differ slightly from text
+ * painted directly.
+ *
+ * The recorder takes its metrics from the target image, so that font resolution and
+ * window-viewport mapping are the same as for the image itself.
+ */
+class KWIN_EXPORT PaintRecorder : public QPaintDevice
+{
+public:
+    using Command = std::function<void(QPainter *painter, const QTransform &base)>;
+
+    enum class ReplayMode {
+        /**
+         * The tiles are rasterized on the global thread pool, the call blocks until all are done.
+         */
+        Parallel,
+        /**
+         * The tiles are rasterized one after another on the calling thread. Use this if
+         * the replay itself already runs on the thread pool.
+         */
+        Sequential,
+    };
+
+    PaintRecorder();
+    ~PaintRecorder() override;
+
+    /**
+     * Sets the image the recorded operations will be replayed into. Must be called
+     * before a QPainter is started on the recorder.
+     */
+    void setTarget(QImage *target);
+    QImage *target() const;
+
+    QPaintEngine *paintEngine() const override;
+
+    /**
+     * Rasterizes all recorded operations into the target image. Only tiles which
+     * intersect @p region, in device coordinates of the target, are painted.
+     * Afterwards the recorded operations are discarded.
+     */
+    void replay(const QRegion &region, ReplayMode mode = ReplayMode::Parallel);
+
+    /**
+     * Discards the recorded operations without painting them.
+     */
+    void clear();
+
+    void record(Command &&command);
+
+protected:
+    int metric(PaintDeviceMetric metric) const override;
+
+private:
+    QScopedPointer<PaintRecorderEngine> m_engine;
+    QVector<Command> m_commands;
+    QImage *m_target = nullptr;
+};
+
+}
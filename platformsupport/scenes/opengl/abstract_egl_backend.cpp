@@ -426,7 +426,6 @@ void AbstractEglTexture::updateTexture(WindowPixmap *pixmap)
     const QRegion damage = s->mapToBuffer(s->trackedDamage());
     s->resetTrackedDamage();
 
-    // TODO: this should be shared with GLTexture::update
     createTextureSubImage(image, damage);
 }
 
@@ -471,6 +470,7 @@ bool AbstractEglTexture::createTextureImage(const QImage &image)
     q->unbind();
     q->setYInverted(true);
     m_size = size;
+    m_internalFormat = format;
     updateMatrix();
     return true;
 }
@@ -480,24 +480,15 @@ void AbstractEglTexture::createTextureSubImage(const QImage &image, const QRegio
     q->bind();
     if (GLPlatform::instance()->isGLES()) {
         if (s_supportsARGB32 && (image.format() == QImage::Format_ARGB32 || image.format() == QImage::Format_ARGB32_Premultiplied)) {
-            const QImage im = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
-            for (const QRect &rect : damage) {
-                glTexSubImage2D(m_target, 0, rect.x(), rect.y(), rect.width(), rect.height(),
-                                GL_BGRA_EXT, GL_UNSIGNED_BYTE, im.copy(rect).bits());
-            }
+            updateRegion(image, damage, QPoint(), QImage::Format_ARGB32_Premultiplied, GL_BGRA_EXT, GL_UNSIGNED_BYTE);
         } else {
-            const QImage im = image.convertToFormat(QImage::Format_RGBA8888_Premultiplied);
-            for (const QRect &rect : damage) {
-                glTexSubImage2D(m_target, 0, rect.x(), rect.y(), rect.width(), rect.height(),
-                                GL_RGBA, GL_UNSIGNED_BYTE, im.copy(rect).bits());
-            }
+            updateRegion(image, damage, QPoint(), QImage::Format_RGBA8888_Premultiplied, GL_RGBA, GL_UNSIGNED_BYTE);
         }
+    } else if (image.format() == QImage::Format_RGB32 && m_internalFormat == GL_RGB8) {
+        // the alpha channel is ignored by the texture, no need to fix it up
+        updateRegion(image, damage, QPoint(), QImage::Format_RGB32, GL_BGRA, GL_UNSIGNED_BYTE);
     } else {
-        const QImage im = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
-        for (const QRect &rect : damage) {
-            glTexSubImage2D(m_target, 0, rect.x(), rect.y(), rect.width(), rect.height(),
-                            GL_BGRA, GL_UNSIGNED_BYTE, im.copy(rect).bits());
-        }
+        updateRegion(image, damage, QPoint(), QImage::Format_ARGB32_Premultiplied, GL_BGRA, GL_UNSIGNED_BYTE);
     }
     q->unbind();
 }
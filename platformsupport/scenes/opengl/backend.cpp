@@ -92,6 +92,20 @@ bool OpenGLBackend::perScreenRendering() const
     return false;
 }
 
+bool OpenGLBackend::scanout(int screenId, KWaylandServer::SurfaceInterface *surface)
+{
+    Q_UNUSED(screenId)
+    Q_UNUSED(surface)
+    return false;
+}
+
+QVector<Toplevel *> OpenGLBackend::assignOverlayPlanes(int screenId, const QVector<Toplevel *> &windows)
+{
+    Q_UNUSED(screenId)
+    Q_UNUSED(windows)
+    return QVector<Toplevel *>();
+}
+
 void OpenGLBackend::copyPixels(const QRegion &region)
 {
     const int height = screens()->size().height();
@@ -12,9 +12,15 @@
 
 #include <QElapsedTimer>
 #include <QRegion>
+#include <QVector>
 
 #include <kwin_export.h>
 
+namespace KWaylandServer
+{
+class SurfaceInterface;
+}
+
 namespace KWin
 {
 class AbstractOutput;
@@ -23,6 +29,7 @@ class OverlayWindow;
 class SceneOpenGL;
 class SceneOpenGLTexture;
 class SceneOpenGLTexturePrivate;
+class Toplevel;
 class WindowPixmap;
 class GLTexture;
 
@@ -89,6 +96,24 @@ public:
      */
     virtual bool perScreenRendering() const;
     virtual QRegion prepareRenderingForScreen(int screenId);
+    /**
+     * Tries to present the current buffer of @p surface directly on the screen with the
+     * given @p screenId, bypassing composition. If @c true is returned, the screen must
+     * not be rendered in this frame.
+     *
+     * Default implementation returns @c false.
+     */
+    virtual bool scanout(int screenId, KWaylandServer::SurfaceInterface *surface);
+    /**
+     * Tries to show the current buffers of the given @p windows on hardware overlay planes
+     * of the screen with the given @p screenId. The windows have to be opaque and must neither
+     * overlap each other nor be covered by anything that gets composited. Overlay planes
+     * assigned in a previous frame are released if they are not needed anymore.
+     *
+     * Returns the windows which have been put on an overlay plane, they must not be composited
+     * on that screen. Default implementation returns an empty list.
+     */
+    virtual QVector<Toplevel *> assignOverlayPlanes(int screenId, const QVector<Toplevel *> &windows);
     /**
      * @brief Compositor is going into idle mode, flushes any pending paints.
      */
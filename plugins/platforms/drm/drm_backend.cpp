@@ -29,6 +29,7 @@
 #include "egl_stream_backend.h"
 #endif
 // KWayland
+#include <KWaylandServer/buffer_interface.h>
 #include <KWaylandServer/seat_interface.h>
 // KF5
 #include <KConfigGroup>
@@ -78,6 +79,7 @@ DrmBackend::DrmBackend(QObject *parent)
 DrmBackend::~DrmBackend()
 {
 #if HAVE_GBM
+    m_clientFramebuffers.clear();
     if (m_gbmDevice) {
         gbm_device_destroy(m_gbmDevice);
     }
@@ -198,6 +200,10 @@ void DrmBackend::reactivate()
     // restart compositor
     m_pageFlipsPending = 0;
     if (Compositor *compositor = Compositor::self()) {
+        // page flips scheduled before the VT switch won't complete anymore
+        for (auto it = m_outputs.constBegin(); it != m_outputs.constEnd(); ++it) {
+            compositor->bufferSwapComplete(*it);
+        }
         compositor->bufferSwapComplete();
         compositor->addRepaintFull();
     }
@@ -209,7 +215,7 @@ void DrmBackend::deactivate()
         return;
     }
     // block compositor
-    if (m_pageFlipsPending == 0 && Compositor::self()) {
+    if (Compositor::self()) {
         Compositor::self()->aboutToSwapBuffers();
     }
     // hide cursor and disable
@@ -230,13 +236,10 @@ void DrmBackend::pageFlipHandler(int fd, unsigned int frame, unsigned int sec, u
 
     output->pageFlipped();
     output->m_backend->m_pageFlipsPending--;
-    if (output->m_backend->m_pageFlipsPending == 0) {
-        // TODO: improve, this currently means we wait for all page flips or all outputs.
-        // It would be better to driver the repaint per output
 
-        if (Compositor::self()) {
-            Compositor::self()->bufferSwapComplete();
-        }
+    // Each output is repainted at its own refresh rate, only this output was blocked.
+    if (Compositor::self()) {
+        Compositor::self()->bufferSwapComplete(output);
     }
 }
 
@@ -608,8 +611,8 @@ bool DrmBackend::present(DrmBuffer *buffer, DrmOutput *output)
 
     if (output->present(buffer)) {
         m_pageFlipsPending++;
-        if (m_pageFlipsPending == 1 && Compositor::self()) {
-            Compositor::self()->aboutToSwapBuffers();
+        if (Compositor::self()) {
+            Compositor::self()->aboutToSwapBuffers(output);
         }
         return true;
     } else if (m_deleteBufferAfterPageFlip) {
@@ -767,6 +770,22 @@ DrmSurfaceBuffer *DrmBackend::createBuffer(const std::shared_ptr<GbmSurface> &su
     DrmSurfaceBuffer *b = new DrmSurfaceBuffer(m_fd, surface);
     return b;
 }
+
+DrmClientBuffer *DrmBackend::createBuffer(DmabufBuffer *dmabuf, KWaylandServer::BufferInterface *buffer)
+{
+    // the framebuffer is reused as long as the client keeps the buffer
+    std::shared_ptr<DrmClientFramebuffer> &framebuffer = m_clientFramebuffers[buffer];
+    if (!framebuffer) {
+        framebuffer = std::make_shared<DrmClientFramebuffer>(m_fd, m_gbmDevice, dmabuf);
+        connect(buffer, &KWaylandServer::BufferInterface::aboutToBeDestroyed, this,
+            [this, buffer] {
+                m_clientFramebuffers.remove(buffer);
+            }
+        );
+    }
+    DrmClientBuffer *b = new DrmClientBuffer(framebuffer, buffer);
+    return b;
+}
 #endif
 
 void DrmBackend::updateOutputsEnabled()
@@ -19,6 +19,7 @@
 #include "drm_pointer.h"
 
 #include <QElapsedTimer>
+#include <QHash>
 #include <QImage>
 #include <QPointer>
 #include <QSize>
@@ -64,6 +65,7 @@ public:
     DrmDumbBuffer *createBuffer(const QSize &size);
 #if HAVE_GBM
     DrmSurfaceBuffer *createBuffer(const std::shared_ptr<GbmSurface> &surface);
+    DrmClientBuffer *createBuffer(DmabufBuffer *dmabuf, KWaylandServer::BufferInterface *buffer);
 #endif
     bool present(DrmBuffer *buffer, DrmOutput *output);
 
@@ -187,6 +189,10 @@ private:
     QVector<DrmPlane*> m_overlayPlanes;
     QScopedPointer<DpmsInputEventFilter> m_dpmsFilter;
     gbm_device *m_gbmDevice = nullptr;
+#if HAVE_GBM
+    // imported client buffers, until the client destroys them
+    QHash<KWaylandServer::BufferInterface *, std::shared_ptr<DrmClientFramebuffer>> m_clientFramebuffers;
+#endif
 };
 
 
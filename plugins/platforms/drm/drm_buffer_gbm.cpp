@@ -10,15 +10,20 @@
 #include "drm_buffer_gbm.h"
 #include "gbm_surface.h"
 
+#include "linux_dmabuf.h"
 #include "logging.h"
 
+#include <KWaylandServer/buffer_interface.h>
+
 // system
 #include <sys/mman.h>
 // c++
 #include <cerrno>
+#include <cstring>
 // drm
 #include <xf86drm.h>
 #include <xf86drmMode.h>
+#include <drm_fourcc.h>
 #include <gbm.h>
 
 namespace KWin
@@ -55,4 +60,84 @@ void DrmSurfaceBuffer::releaseGbm()
     m_bo = nullptr;
 }
 
+// DrmClientFramebuffer
+DrmClientFramebuffer::DrmClientFramebuffer(int fd, gbm_device *device, DmabufBuffer *dmabuf)
+    : m_fd(fd)
+{
+    const auto planes = dmabuf->planes();
+    if (planes.isEmpty() || planes.count() > 4) {
+        return;
+    }
+    gbm_import_fd_modifier_data data = {};
+    data.width = dmabuf->size().width();
+    data.height = dmabuf->size().height();
+    data.format = dmabuf->format();
+    data.num_fds = planes.count();
+    data.modifier = planes.first().modifier;
+    for (int i = 0; i < planes.count(); ++i) {
+        data.fds[i] = planes[i].fd;
+        data.strides[i] = planes[i].stride;
+        data.offsets[i] = planes[i].offset;
+    }
+    m_bo = gbm_bo_import(device, GBM_BO_IMPORT_FD_MODIFIER, &data, GBM_BO_USE_SCANOUT);
+    if (!m_bo) {
+        qCDebug(KWIN_DRM) << "Importing client buffer for direct scanout failed:" << strerror(errno);
+        return;
+    }
+    m_size = dmabuf->size();
+
+    uint32_t handles[4] = {};
+    uint32_t strides[4] = {};
+    uint32_t offsets[4] = {};
+    uint64_t modifiers[4] = {};
+    for (int i = 0; i < gbm_bo_get_plane_count(m_bo); ++i) {
+        handles[i] = gbm_bo_get_handle_for_plane(m_bo, i).u32;
+        strides[i] = gbm_bo_get_stride_for_plane(m_bo, i);
+        offsets[i] = gbm_bo_get_offset(m_bo, i);
+        modifiers[i] = gbm_bo_get_modifier(m_bo);
+    }
+    int ret;
+    if (data.modifier != DRM_FORMAT_MOD_INVALID) {
+        ret = drmModeAddFB2WithModifiers(fd, m_size.width(), m_size.height(), data.format,
+                                         handles, strides, offsets, modifiers, &m_bufferId, DRM_MODE_FB_MODIFIERS);
+    } else {
+        ret = drmModeAddFB2(fd, m_size.width(), m_size.height(), data.format,
+                            handles, strides, offsets, &m_bufferId, 0);
+    }
+    if (ret != 0) {
+        qCDebug(KWIN_DRM) << "Adding framebuffer for direct scanout failed:" << strerror(errno);
+        m_bufferId = 0;
+    }
+}
+
+DrmClientFramebuffer::~DrmClientFramebuffer()
+{
+    if (m_bufferId) {
+        drmModeRmFB(m_fd, m_bufferId);
+    }
+    if (m_bo) {
+        gbm_bo_destroy(m_bo);
+    }
+}
+
+// DrmClientBuffer
+DrmClientBuffer::DrmClientBuffer(const std::shared_ptr<DrmClientFramebuffer> &framebuffer, KWaylandServer::BufferInterface *buffer)
+    : DrmBuffer(framebuffer->fd())
+    , m_framebuffer(framebuffer)
+    , m_clientBuffer(buffer)
+{
+    m_bufferId = m_framebuffer->bufferId();
+    m_size = m_framebuffer->size();
+    if (m_bufferId) {
+        m_clientBuffer->ref();
+    }
+}
+
+DrmClientBuffer::~DrmClientBuffer()
+{
+    if (m_bufferId && m_clientBuffer) {
+        m_clientBuffer->unref();
+    }
+}
+
 }
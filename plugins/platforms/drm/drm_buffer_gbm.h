@@ -12,13 +12,22 @@
 
 #include "drm_buffer.h"
 
+#include <QPointer>
+
 #include <memory>
 
 struct gbm_bo;
+struct gbm_device;
+
+namespace KWaylandServer
+{
+class BufferInterface;
+}
 
 namespace KWin
 {
 
+class DmabufBuffer;
 class GbmSurface;
 
 class DrmSurfaceBuffer : public DrmBuffer
@@ -50,6 +59,64 @@ private:
     gbm_bo *m_bo = nullptr;
 };
 
+/**
+ * @brief The framebuffer of a dmabuf provided by a Wayland client.
+ *
+ * Importing the dmabuf and adding a framebuffer for it is expensive, so it is done only
+ * once per client buffer and shared by all DrmClientBuffers showing it. The framebuffer
+ * is removed when the last of them is gone.
+ */
+class DrmClientFramebuffer
+{
+public:
+    DrmClientFramebuffer(int fd, gbm_device *device, DmabufBuffer *dmabuf);
+    ~DrmClientFramebuffer();
+
+    int fd() const {
+        return m_fd;
+    }
+    quint32 bufferId() const {
+        return m_bufferId;
+    }
+    const QSize &size() const {
+        return m_size;
+    }
+    gbm_bo *getBo() const {
+        return m_bo;
+    }
+
+private:
+    int m_fd;
+    gbm_bo *m_bo = nullptr;
+    quint32 m_bufferId = 0;
+    QSize m_size;
+};
+
+/**
+ * @brief A dmabuf provided by a Wayland client, which is scanned out directly.
+ *
+ * The client buffer is referenced for as long as this buffer exists, so the client does
+ * not reuse it while it is on screen.
+ */
+class DrmClientBuffer : public DrmBuffer
+{
+public:
+    DrmClientBuffer(const std::shared_ptr<DrmClientFramebuffer> &framebuffer, KWaylandServer::BufferInterface *buffer);
+    ~DrmClientBuffer() override;
+
+    bool needsModeChange(DrmBuffer *b) const override {
+        return !dynamic_cast<DrmClientBuffer*>(b) && !dynamic_cast<DrmSurfaceBuffer*>(b);
+    }
+
+    const std::shared_ptr<DrmClientFramebuffer> &framebuffer() const {
+        return m_framebuffer;
+    }
+
+private:
+    std::shared_ptr<DrmClientFramebuffer> m_framebuffer;
+    QPointer<KWaylandServer::BufferInterface> m_clientBuffer;
+};
+
 }
 
 #endif
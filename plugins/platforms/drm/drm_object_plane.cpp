@@ -119,6 +119,16 @@ bool DrmPlane::initProps()
         }
     }
 
+    // zpos is only read, it is immutable on many drivers and must not be part of a commit
+    for (uint32_t i = 0; i < properties->count_props; ++i) {
+        DrmScopedPointer<drmModePropertyRes> prop(drmModeGetProperty(fd(), properties->props[i]));
+        if (prop && qstrcmp(prop->name, "zpos") == 0) {
+            m_zpos = properties->prop_values[i];
+            m_hasZpos = true;
+            break;
+        }
+    }
+
     return true;
 }
 
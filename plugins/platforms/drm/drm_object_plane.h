@@ -72,6 +72,9 @@ public:
     QVector<uint32_t> formats() const {
         return m_formats;
     }
+    bool isFormatSupported(uint32_t format) const {
+        return m_formats.contains(format);
+    }
 
     DrmBuffer *current() const {
         return m_current;
@@ -93,6 +96,20 @@ public:
         return m_supportedTransformations;
     }
 
+    /**
+     * Whether the driver exposes the stacking position of the plane.
+     */
+    bool hasZpos() const {
+        return m_hasZpos;
+    }
+    /**
+     * The stacking position of the plane, planes with a higher value are shown above
+     * the ones with a lower value. Only meaningful if hasZpos() returns @c true.
+     */
+    uint64_t zpos() const {
+        return m_zpos;
+    }
+
     bool atomicPopulate(drmModeAtomicReq *req) const override;
 
 private:
@@ -103,9 +120,11 @@ private:
     QVector<uint32_t> m_formats;        // Possible formats, which can be presented on this plane
 
     // TODO: when using overlay planes in the future: restrict possible screens / crtcs of planes
-    uint32_t m_possibleCrtcs;
+    uint32_t m_possibleCrtcs = 0;
 
     Transformations m_supportedTransformations = Transformation::Rotate0;
+    uint64_t m_zpos = 0;
+    bool m_hasZpos = false;
 };
 
 }
@@ -72,6 +72,18 @@ void DrmOutput::teardown()
     if (m_cursorPlane) {
         m_cursorPlane->setOutput(nullptr);
     }
+    for (DrmPlane *plane : qAsConst(m_overlayPlanes)) {
+        plane->setOutput(nullptr);
+        if (m_backend->deleteBufferAfterPageFlip()) {
+            delete plane->current();
+            if (plane->next() != plane->current()) {
+                delete plane->next();
+            }
+        }
+        plane->setCurrent(nullptr);
+        plane->setNext(nullptr);
+    }
+    m_overlayPlanes.clear();
 
     m_crtc->setOutput(nullptr);
     m_conn->setOutput(nullptr);
@@ -745,6 +757,7 @@ void DrmOutput::pageFlipped()
                 p->flipBufferWithDelete();
             }
             m_nextPlanesFlipList.clear();
+            releaseOverlayPlanes();
         } else {
             if (!m_crtc->next()) {
                 // on manual vt switch
@@ -783,6 +796,120 @@ bool DrmOutput::present(DrmBuffer *buffer)
     }
 }
 
+bool DrmOutput::testScanout(DrmBuffer *buffer)
+{
+    if (!m_backend->atomicModeSetting() || !m_primaryPlane) {
+        return false;
+    }
+    if (m_pageFlipPending || m_modesetRequested || m_dpmsModePending != DpmsMode::On) {
+        return false;
+    }
+    if (transform() != Transform::Normal || buffer->size() != pixelSize()) {
+        return false;
+    }
+    // a buffer covering the whole output hides all overlays
+    disableOverlayPlanes();
+
+    DrmBuffer *next = m_primaryPlane->next();
+    m_primaryPlane->setNext(buffer);
+    m_nextPlanesFlipList << m_primaryPlane;
+
+    // on failure the planes get reset by doAtomicCommit
+    if (!doAtomicCommit(AtomicCommitMode::Test)) {
+        return false;
+    }
+    m_primaryPlane->setNext(next);
+    m_nextPlanesFlipList.removeOne(m_primaryPlane);
+    return true;
+}
+
+QVector<DrmPlane *> DrmOutput::assignOverlays(const QVector<DrmOverlayCandidate> &candidates)
+{
+    if (!m_backend->atomicModeSetting() || !m_primaryPlane) {
+        return QVector<DrmPlane *>(candidates.count(), nullptr);
+    }
+    disableOverlayPlanes();
+    if (candidates.isEmpty() || m_pageFlipPending || m_modesetRequested
+            || m_dpmsMode != DpmsMode::On || m_dpmsModePending != DpmsMode::On) {
+        return QVector<DrmPlane *>(candidates.count(), nullptr);
+    }
+
+    QVector<DrmPlane *> planes;
+    for (DrmPlane *plane : m_backend->overlayPlanes()) {
+        if (!plane->output() || plane->output() == this) {
+            planes << plane;
+        }
+    }
+    DrmOverlayAssigner assigner(planes, m_primaryPlane, m_crtc->resIndex(), m_crtc->id());
+    const QVector<DrmPlane *> assigned = assigner.assign(candidates, [this] (DrmPlane *plane) {
+        return testOverlayPlane(plane);
+    });
+
+    for (DrmPlane *plane : assigned) {
+        if (plane && !m_overlayPlanes.contains(plane)) {
+            plane->setOutput(this);
+            m_overlayPlanes << plane;
+        }
+    }
+    return assigned;
+}
+
+bool DrmOutput::testOverlayPlane(DrmPlane *plane)
+{
+    const QVector<DrmPlane *> flipList = m_nextPlanesFlipList;
+    QVector<DrmBuffer *> nextBuffers;
+    nextBuffers.reserve(flipList.count());
+    for (DrmPlane *p : flipList) {
+        nextBuffers << p->next();
+    }
+    if (!m_nextPlanesFlipList.contains(plane)) {
+        m_nextPlanesFlipList << plane;
+    }
+
+    if (doAtomicCommit(AtomicCommitMode::Test)) {
+        return true;
+    }
+    // doAtomicCommit drops the whole pending configuration on failure, but only
+    // the tested plane is supposed to be given up
+    for (int i = 0; i < flipList.count(); ++i) {
+        flipList[i]->setNext(nextBuffers[i]);
+    }
+    m_nextPlanesFlipList = flipList;
+    return false;
+}
+
+void DrmOutput::disableOverlayPlanes()
+{
+    for (DrmPlane *plane : qAsConst(m_overlayPlanes)) {
+        if (m_nextPlanesFlipList.contains(plane)) {
+            // assigned again before the last assignment was presented
+            if (m_backend->deleteBufferAfterPageFlip() && plane->next() != plane->current()) {
+                delete plane->next();
+            }
+        } else if (plane->current()) {
+            m_nextPlanesFlipList << plane;
+        } else {
+            continue;
+        }
+        plane->setValue(int(DrmPlane::PropertyIndex::CrtcId), 0);
+        plane->setNext(nullptr);
+    }
+}
+
+void DrmOutput::releaseOverlayPlanes()
+{
+    // planes are given back once they have been disabled on screen, so other outputs can use them
+    for (auto it = m_overlayPlanes.begin(); it != m_overlayPlanes.end();) {
+        DrmPlane *plane = *it;
+        if (!plane->current() && !plane->next() && !m_nextPlanesFlipList.contains(plane)) {
+            plane->setOutput(nullptr);
+            it = m_overlayPlanes.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
 bool DrmOutput::dpmsAtomicOff()
 {
     m_atomicOffPending = false;
@@ -830,7 +957,18 @@ bool DrmOutput::presentAtomically(DrmBuffer *buffer)
     m_primaryPlane->setNext(buffer);
     m_nextPlanesFlipList << m_primaryPlane;
 
+    // a failed commit forgets about the overlay buffers, they would leak otherwise
+    QVector<DrmBuffer *> overlayBuffers;
+    if (m_backend->deleteBufferAfterPageFlip()) {
+        for (DrmPlane *plane : qAsConst(m_overlayPlanes)) {
+            if (plane->next() && m_nextPlanesFlipList.contains(plane)) {
+                overlayBuffers << plane->next();
+            }
+        }
+    }
+
     if (!doAtomicCommit(AtomicCommitMode::Test)) {
+        qDeleteAll(overlayBuffers);
         //TODO: When we use planes for layered rendering, fallback to renderer instead. Also for direct scanout?
         //TODO: Probably should undo setNext and reset the flip list
         qCDebug(KWIN_DRM) << "Atomic test commit failed. Aborting present.";
@@ -856,6 +994,7 @@ bool DrmOutput::presentAtomically(DrmBuffer *buffer)
     }
     const bool wasModeset = m_modesetRequested;
     if (!doAtomicCommit(AtomicCommitMode::Real)) {
+        qDeleteAll(overlayBuffers);
         qCDebug(KWIN_DRM) << "Atomic commit failed. This should have never happened! Aborting present.";
         //TODO: Probably should undo setNext and reset the flip list
         return false;
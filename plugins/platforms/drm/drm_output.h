@@ -13,6 +13,7 @@
 #include "drm_pointer.h"
 #include "drm_object.h"
 #include "drm_object_plane.h"
+#include "drm_overlay_assigner.h"
 #include "edid.h"
 
 #include <QObject>
@@ -48,6 +49,22 @@ public:
     void moveCursor(Cursor* cursor, const QPoint &globalPos);
     bool init(drmModeConnector *connector);
     bool present(DrmBuffer *buffer);
+    /**
+     * Tests with an atomic test commit whether @p buffer can be put on the primary plane
+     * without any further adjustments. The state of the planes is not changed.
+     *
+     * Always returns @c false with legacy mode setting.
+     */
+    bool testScanout(DrmBuffer *buffer);
+    /**
+     * Puts the buffers of @p candidates on free overlay planes, verifying every assignment
+     * with an atomic test commit. Overlay planes used in the previous frame get disabled
+     * unless they are reused. The new configuration takes effect with the next present().
+     *
+     * Returns for each candidate the plane it has been put on, or @c nullptr if it has to
+     * be composited. Buffers put on a plane are owned by the output from now on.
+     */
+    QVector<DrmPlane *> assignOverlays(const QVector<DrmOverlayCandidate> &candidates);
     void pageFlipped();
 
     // These values are defined by the kernel
@@ -105,6 +122,9 @@ private:
         Real
     };
     bool doAtomicCommit(AtomicCommitMode mode);
+    bool testOverlayPlane(DrmPlane *plane);
+    void disableOverlayPlanes();
+    void releaseOverlayPlanes();
 
     bool presentLegacy(DrmBuffer *buffer);
     bool setModeLegacy(DrmBuffer *buffer);
@@ -152,6 +172,8 @@ private:
     uint32_t m_blobId = 0;
     DrmPlane* m_primaryPlane = nullptr;
     DrmPlane* m_cursorPlane = nullptr;
+    // Overlay planes are claimed on first use and given back after they got disabled
+    QVector<DrmPlane*> m_overlayPlanes;
     QVector<DrmPlane*> m_nextPlanesFlipList;
     bool m_pageFlipPending = false;
     bool m_atomicOffPending = false;
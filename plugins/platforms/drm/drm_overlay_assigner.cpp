@@ -0,0 +1,90 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2020 KWin developers <kwin@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "drm_overlay_assigner.h"
+#include "drm_buffer.h"
+#include "drm_object_plane.h"
+#include "logging.h"
+
+namespace KWin
+{
+
+DrmOverlayAssigner::DrmOverlayAssigner(const QVector<DrmPlane *> &planes, DrmPlane *primaryPlane, int crtcResIndex, uint32_t crtcId)
+    : m_planes(planes)
+    , m_primaryPlane(primaryPlane)
+    , m_crtcResIndex(crtcResIndex)
+    , m_crtcId(crtcId)
+{
+}
+
+QVector<DrmPlane *> DrmOverlayAssigner::assign(const QVector<DrmOverlayCandidate> &candidates, const TestFunction &test)
+{
+    QVector<DrmPlane *> assigned(candidates.count(), nullptr);
+    QVector<DrmPlane *> available;
+    for (DrmPlane *plane : qAsConst(m_planes)) {
+        if (isAbovePrimary(plane)) {
+            available << plane;
+        }
+    }
+
+    for (int i = 0; i < candidates.count(); ++i) {
+        const DrmOverlayCandidate &candidate = candidates[i];
+        if (!candidate.buffer || !candidate.buffer->bufferId() || candidate.destination.isEmpty()) {
+            continue;
+        }
+        for (auto it = available.begin(); it != available.end(); ++it) {
+            DrmPlane *plane = *it;
+            if (!plane->isCrtcSupported(m_crtcResIndex) || !plane->isFormatSupported(candidate.format)) {
+                continue;
+            }
+            setupPlane(plane, candidate);
+            if (test(plane)) {
+                qCDebug(KWIN_DRM) << "Assigned buffer" << candidate.buffer->bufferId() << "to overlay plane" << plane->id();
+                assigned[i] = plane;
+                available.erase(it);
+                break;
+            }
+            resetPlane(plane);
+        }
+    }
+    return assigned;
+}
+
+bool DrmOverlayAssigner::isAbovePrimary(DrmPlane *plane) const
+{
+    // without zpos the stacking is up to the driver, which usually puts overlays on top
+    if (!m_primaryPlane || !m_primaryPlane->hasZpos() || !plane->hasZpos()) {
+        return true;
+    }
+    return plane->zpos() > m_primaryPlane->zpos();
+}
+
+void DrmOverlayAssigner::setupPlane(DrmPlane *plane, const DrmOverlayCandidate &candidate) const
+{
+    const QSize sourceSize = candidate.buffer->size();
+    const QRect &destination = candidate.destination;
+
+    plane->setValue(int(DrmPlane::PropertyIndex::SrcX), 0);
+    plane->setValue(int(DrmPlane::PropertyIndex::SrcY), 0);
+    plane->setValue(int(DrmPlane::PropertyIndex::SrcW), sourceSize.width() << 16);
+    plane->setValue(int(DrmPlane::PropertyIndex::SrcH), sourceSize.height() << 16);
+    plane->setValue(int(DrmPlane::PropertyIndex::CrtcX), destination.x());
+    plane->setValue(int(DrmPlane::PropertyIndex::CrtcY), destination.y());
+    plane->setValue(int(DrmPlane::PropertyIndex::CrtcW), destination.width());
+    plane->setValue(int(DrmPlane::PropertyIndex::CrtcH), destination.height());
+    plane->setValue(int(DrmPlane::PropertyIndex::CrtcId), m_crtcId);
+    plane->setNext(candidate.buffer);
+}
+
+void DrmOverlayAssigner::resetPlane(DrmPlane *plane) const
+{
+    plane->setValue(int(DrmPlane::PropertyIndex::CrtcId), 0);
+    plane->setNext(nullptr);
+}
+
+}
@@ -0,0 +1,73 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2020 KWin developers <kwin@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include <QRect>
+#include <QVector>
+
+#include <functional>
+
+namespace KWin
+{
+
+class DrmBuffer;
+class DrmPlane;
+
+/**
+ * A buffer that could be shown on an overlay plane instead of being composited.
+ */
+struct DrmOverlayCandidate
+{
+    DrmBuffer *buffer = nullptr;
+    /**
+     * The DRM fourcc format of the buffer.
+     */
+    uint32_t format = 0;
+    /**
+     * The area on the CRTC, in device pixels, the buffer should be shown at.
+     */
+    QRect destination;
+};
+
+/**
+ * @brief Distributes overlay candidates over the free overlay planes of a CRTC.
+ *
+ * The assignment is greedy: every candidate gets the first plane that can show
+ * it on the CRTC, supports its format and is accepted by the hardware. The latter
+ * is decided by a test function, usually an atomic test commit, which is invoked
+ * after the plane has been set up for the candidate.
+ *
+ * The composited content on the primary plane is not aware of the overlays, so planes
+ * which are known to be stacked below the primary plane are never used.
+ */
+class DrmOverlayAssigner
+{
+public:
+    using TestFunction = std::function<bool(DrmPlane *plane)>;
+
+    DrmOverlayAssigner(const QVector<DrmPlane *> &planes, DrmPlane *primaryPlane, int crtcResIndex, uint32_t crtcId);
+
+    /**
+     * Returns for each of the @p candidates the plane it has been put on, or @c nullptr
+     * if it has to be composited. Planes which did not pass the @p test are left disabled.
+     */
+    QVector<DrmPlane *> assign(const QVector<DrmOverlayCandidate> &candidates, const TestFunction &test);
+
+private:
+    bool isAbovePrimary(DrmPlane *plane) const;
+    void setupPlane(DrmPlane *plane, const DrmOverlayCandidate &candidate) const;
+    void resetPlane(DrmPlane *plane) const;
+
+    QVector<DrmPlane *> m_planes;
+    DrmPlane *m_primaryPlane;
+    int m_crtcResIndex;
+    uint32_t m_crtcId;
+};
+
+}
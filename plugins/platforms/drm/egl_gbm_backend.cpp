@@ -10,17 +10,23 @@
 // kwin
 #include "composite.h"
 #include "drm_backend.h"
+#include "drm_buffer_gbm.h"
 #include "drm_output.h"
 #include "gbm_surface.h"
+#include "linux_dmabuf.h"
 #include "logging.h"
 #include "options.h"
 #include "screens.h"
+#include "toplevel.h"
 // kwin libs
 #include <kwinglplatform.h>
 #include <kwineglimagetexture.h>
 // system
 #include <gbm.h>
 
+#include <KWaylandServer/buffer_interface.h>
+#include <KWaylandServer/surface_interface.h>
+
 namespace KWin
 {
 
@@ -61,6 +67,7 @@ void EglGbmBackend::cleanupFramebuffer(Output &output)
 
 void EglGbmBackend::cleanupOutput(Output &output)
 {
+    output.scanoutFramebuffer.reset();
     cleanupFramebuffer(output);
     output.output->releaseGbm();
 
@@ -466,9 +473,11 @@ void EglGbmBackend::presentOnOutput(Output &output, const QRegion &damagedRegion
         eglSwapBuffers(eglDisplay(), output.eglSurface);
     }
     output.buffer = m_backend->createBuffer(output.gbmSurface);
+    output.scanoutFramebuffer.reset();
 
     Q_EMIT output.output->outputChange(damagedRegion);
     m_backend->present(output.buffer, output.output);
+    output.overlaysPending = false;
 
     if (supportsBufferAge()) {
         eglQuerySurface(eglDisplay(), output.eglSurface, EGL_BUFFER_AGE_EXT, &output.bufferAge);
@@ -526,6 +535,92 @@ QRegion EglGbmBackend::prepareRenderingForScreen(int screenId)
     return output.output->geometry();
 }
 
+bool EglGbmBackend::scanout(int screenId, KWaylandServer::SurfaceInterface *surface)
+{
+    Output &output = m_outputs[screenId];
+    KWaylandServer::BufferInterface *buffer = surface->buffer();
+    if (!buffer || !buffer->linuxDmabufBuffer()) {
+        return false;
+    }
+    DmabufBuffer *dmabuf = static_cast<DmabufBuffer *>(buffer->linuxDmabufBuffer());
+    if (dmabuf->size() != output.output->pixelSize()
+            || (dmabuf->flags() & KWaylandServer::LinuxDmabufUnstableV1Interface::YInverted)) {
+        return false;
+    }
+
+    DrmClientBuffer *clientBuffer = m_backend->createBuffer(dmabuf, buffer);
+    if (!clientBuffer->bufferId() || !output.output->testScanout(clientBuffer)) {
+        delete clientBuffer;
+        return false;
+    }
+
+    const std::shared_ptr<DrmClientFramebuffer> framebuffer = clientBuffer->framebuffer();
+    if (!m_backend->present(clientBuffer, output.output)) {
+        return false;
+    }
+
+    // The contents of the gbm surface are stale now, the next composited
+    // frame has to be repainted in full.
+    output.bufferAge = 0;
+    output.overlayCount = 0;
+    output.overlaysPending = false;
+
+    // screencasts of the output get the client buffer from textureForOutput()
+    output.scanoutFramebuffer = framebuffer;
+    Q_EMIT output.output->outputChange(output.output->geometry());
+    return true;
+}
+
+QVector<Toplevel *> EglGbmBackend::assignOverlayPlanes(int screenId, const QVector<Toplevel *> &windows)
+{
+    Output &output = m_outputs[screenId];
+    DrmOutput *drmOutput = output.output;
+
+    QVector<Toplevel *> candidateWindows;
+    QVector<DrmOverlayCandidate> candidates;
+    if (m_backend->atomicModeSetting() && drmOutput->transform() == DrmOutput::Transform::Normal) {
+        const QRect outputGeometry = drmOutput->geometry();
+        const qreal scale = drmOutput->scale();
+        for (Toplevel *window : windows) {
+            KWaylandServer::SurfaceInterface *surface = window->surface();
+            KWaylandServer::BufferInterface *buffer = surface ? surface->buffer() : nullptr;
+            if (!buffer || !buffer->linuxDmabufBuffer()) {
+                continue;
+            }
+            DmabufBuffer *dmabuf = static_cast<DmabufBuffer *>(buffer->linuxDmabufBuffer());
+            if (dmabuf->flags() & KWaylandServer::LinuxDmabufUnstableV1Interface::YInverted) {
+                continue;
+            }
+            const QRect geometry = window->bufferGeometry();
+            if (!outputGeometry.contains(geometry)) {
+                continue;
+            }
+            DrmOverlayCandidate candidate;
+            candidate.buffer = m_backend->createBuffer(dmabuf, buffer);
+            candidate.format = dmabuf->format();
+            candidate.destination = QRect((geometry.topLeft() - outputGeometry.topLeft()) * scale,
+                                          geometry.size() * scale);
+            candidates << candidate;
+            candidateWindows << window;
+        }
+    }
+
+    const QVector<DrmPlane *> planes = drmOutput->assignOverlays(candidates);
+    QVector<Toplevel *> assigned;
+    for (int i = 0; i < planes.count(); ++i) {
+        if (planes[i]) {
+            assigned << candidateWindows[i];
+        } else {
+            delete candidates[i].buffer;
+        }
+    }
+
+    // Planes which are not used anymore need a commit as well to be disabled.
+    output.overlaysPending = !assigned.isEmpty() || output.overlayCount > 0;
+    output.overlayCount = assigned.count();
+    return assigned;
+}
+
 void EglGbmBackend::endRenderingFrame(const QRegion &renderedRegion, const QRegion &damagedRegion)
 {
     Q_UNUSED(renderedRegion)
@@ -539,7 +634,8 @@ void EglGbmBackend::endRenderingFrameForScreen(int screenId,
     Output &output = m_outputs[screenId];
     renderFramebufferToSurface(output);
 
-    if (damagedRegion.intersected(output.output->geometry()).isEmpty() && screenId == 0) {
+    if (damagedRegion.intersected(output.output->geometry()).isEmpty() && screenId == 0
+            && !output.overlaysPending) {
 
         // If the damaged region of a window is fully occluded, the only
         // rendering done, if any, will have been to repair a reused back
@@ -596,6 +692,16 @@ QSharedPointer<GLTexture> EglGbmBackend::textureForOutput(AbstractOutput *abstra
     }
 
     DrmOutput *drmOutput = itOutput->output;
+    if (const std::shared_ptr<DrmClientFramebuffer> &framebuffer = itOutput->scanoutFramebuffer) {
+        // a client buffer is on screen, neither the render target nor the gbm surface hold the frame
+        EGLImageKHR image = eglCreateImageKHR(eglDisplay(), nullptr, EGL_NATIVE_PIXMAP_KHR, framebuffer->getBo(), nullptr);
+        if (image == EGL_NO_IMAGE_KHR) {
+            qCWarning(KWIN_DRM) << "Failed to record frame: Error creating EGLImageKHR - " << glGetError();
+            return {};
+        }
+        return QSharedPointer<EGLImageTexture>::create(eglDisplay(), image, GL_RGBA8, framebuffer->size());
+    }
+
     if (!drmOutput->hardwareTransforms()) {
         const auto glTexture = QSharedPointer<KWin::GLTexture>::create(itOutput->render.texture, GL_RGBA8, drmOutput->pixelSize());
         glTexture->setYInverted(true);
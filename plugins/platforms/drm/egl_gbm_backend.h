@@ -19,6 +19,7 @@ namespace KWin
 class AbstractOutput;
 class DrmBackend;
 class DrmBuffer;
+class DrmClientFramebuffer;
 class DrmSurfaceBuffer;
 class DrmOutput;
 class GbmSurface;
@@ -40,6 +41,8 @@ public:
     bool usesOverlayWindow() const override;
     bool perScreenRendering() const override;
     QRegion prepareRenderingForScreen(int screenId) override;
+    bool scanout(int screenId, KWaylandServer::SurfaceInterface *surface) override;
+    QVector<Toplevel *> assignOverlayPlanes(int screenId, const QVector<Toplevel *> &windows) override;
     void init() override;
 
     QSharedPointer<GLTexture> textureForOutput(AbstractOutput *requestedOutput) const override;
@@ -64,6 +67,18 @@ private:
          * @brief The damage history for the past 10 frames.
          */
         QList<QRegion> damageHistory;
+        /**
+         * @brief Number of windows shown on overlay planes in the last frame.
+         */
+        int overlayCount = 0;
+        /**
+         * @brief Whether the overlay planes changed and have to be presented.
+         */
+        bool overlaysPending = false;
+        /**
+         * @brief The client buffer scanned out directly instead of the gbm surface, if any.
+         */
+        std::shared_ptr<DrmClientFramebuffer> scanoutFramebuffer;
 
         struct {
             GLuint framebuffer = 0;
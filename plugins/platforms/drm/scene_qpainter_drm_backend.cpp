@@ -7,6 +7,7 @@
     SPDX-License-Identifier: GPL-2.0-or-later
 */
 #include "scene_qpainter_drm_backend.h"
+#include "composite.h"
 #include "drm_backend.h"
 #include "drm_output.h"
 #include "logind.h"
@@ -94,6 +95,10 @@ QImage *DrmQPainterBackend::buffer()
 QImage *DrmQPainterBackend::bufferForScreen(int screenId)
 {
     const Output &o = m_outputs.at(screenId);
+    if (!Compositor::self()->isOutputReady(o.output)) {
+        // the current buffer is still waiting to be scanned out
+        return nullptr;
+    }
     return o.buffer[o.index]->image();
 }
 
@@ -105,7 +110,9 @@ bool DrmQPainterBackend::needsFullRepaint() const
 void DrmQPainterBackend::prepareRenderingFrame()
 {
     for (auto it = m_outputs.begin(); it != m_outputs.end(); ++it) {
-        (*it).index = ((*it).index + 1) % 2;
+        if (Compositor::self()->isOutputReady((*it).output)) {
+            (*it).index = ((*it).index + 1) % 2;
+        }
     }
 }
 
@@ -118,7 +125,9 @@ void DrmQPainterBackend::present(int mask, const QRegion &damage)
     }
     for (auto it = m_outputs.begin(); it != m_outputs.end(); ++it) {
         const Output &o = *it;
-        m_backend->present(o.buffer[o.index], o.output);
+        if (Compositor::self()->isOutputReady(o.output)) {
+            m_backend->present(o.buffer[o.index], o.output);
+        }
     }
 }
 
@@ -0,0 +1,152 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2020 KWin developers <kwin@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "atlasallocator.h"
+
+#include <algorithm>
+
+namespace KWin
+{
+
+const int AtlasAllocator::s_shelfGranularity;
+
+AtlasAllocator::AtlasAllocator(const QSize &size)
+    : m_size(size)
+{
+}
+
+QSize AtlasAllocator::size() const
+{
+    return m_size;
+}
+
+void AtlasAllocator::grow(int height)
+{
+    m_size.setHeight(qMax(m_size.height(), height));
+}
+
+bool AtlasAllocator::isEmpty() const
+{
+    return m_allocations == 0;
+}
+
+QRect AtlasAllocator::allocateInShelf(Shelf &shelf, const QSize &size)
+{
+    for (int i = 0; i < shelf.free.count(); ++i) {
+        Span &span = shelf.free[i];
+        if (span.width < size.width()) {
+            continue;
+        }
+        const QRect rect(QPoint(span.x, shelf.y), size);
+        span.x += size.width();
+        span.width -= size.width();
+        if (span.width == 0) {
+            shelf.free.removeAt(i);
+        }
+        ++shelf.allocations;
+        ++m_allocations;
+        return rect;
+    }
+    return QRect();
+}
+
+QRect AtlasAllocator::allocate(const QSize &size)
+{
+    if (size.isEmpty() || size.width() > m_size.width()) {
+        return QRect();
+    }
+    const int height = (size.height() + s_shelfGranularity - 1) / s_shelfGranularity * s_shelfGranularity;
+
+    // the best fitting shelf which doesn't waste more than half of its height
+    Shelf *best = nullptr;
+    for (Shelf &shelf : m_shelves) {
+        if (shelf.height < height || shelf.height > height + height / 2) {
+            continue;
+        }
+        if (best && best->height <= shelf.height) {
+            continue;
+        }
+        const bool fits = std::any_of(shelf.free.constBegin(), shelf.free.constEnd(),
+            [&size](const Span &span) {
+                return span.width >= size.width();
+            });
+        if (fits) {
+            best = &shelf;
+        }
+    }
+    if (best) {
+        return allocateInShelf(*best, size);
+    }
+
+    // reuse an empty shelf, possibly after merging it with the empty ones below
+    for (int i = 0; i < m_shelves.count(); ++i) {
+        if (m_shelves[i].allocations) {
+            continue;
+        }
+        int j = i + 1;
+        int merged = m_shelves[i].height;
+        while (merged < height && j < m_shelves.count() && !m_shelves[j].allocations) {
+            merged += m_shelves[j++].height;
+        }
+        if (merged < height) {
+            continue;
+        }
+        m_shelves.remove(i + 1, j - i - 1);
+        Shelf &shelf = m_shelves[i];
+        shelf.height = merged;
+        shelf.free = QVector<Span>{{0, m_size.width()}};
+        return allocateInShelf(shelf, size);
+    }
+
+    // open a new shelf
+    const int y = m_shelves.isEmpty() ? 0 : m_shelves.last().y + m_shelves.last().height;
+    if (y + height > m_size.height()) {
+        return QRect();
+    }
+    m_shelves.append({y, height, 0, {{0, m_size.width()}}});
+    return allocateInShelf(m_shelves.last(), size);
+}
+
+void AtlasAllocator::deallocate(const QRect &rect)
+{
+    auto shelf = std::lower_bound(m_shelves.begin(), m_shelves.end(), rect.y(),
+        [](const Shelf &shelf, int y) {
+            return shelf.y < y;
+        });
+    if (shelf == m_shelves.end() || shelf->y != rect.y()) {
+        return;
+    }
+
+    // give the span back and merge it with its neighbours
+    auto next = std::lower_bound(shelf->free.begin(), shelf->free.end(), rect.x(),
+        [](const Span &span, int x) {
+            return span.x < x;
+        });
+    int index = next - shelf->free.begin();
+    shelf->free.insert(index, Span{rect.x(), rect.width()});
+    if (index + 1 < shelf->free.count()
+            && shelf->free[index].x + shelf->free[index].width == shelf->free[index + 1].x) {
+        shelf->free[index].width += shelf->free[index + 1].width;
+        shelf->free.removeAt(index + 1);
+    }
+    if (index > 0 && shelf->free[index - 1].x + shelf->free[index - 1].width == shelf->free[index].x) {
+        shelf->free[index - 1].width += shelf->free[index].width;
+        shelf->free.removeAt(index);
+    }
+
+    --shelf->allocations;
+    --m_allocations;
+
+    // close empty shelves at the bottom, so that the space can be used for any height again
+    while (!m_shelves.isEmpty() && !m_shelves.last().allocations) {
+        m_shelves.removeLast();
+    }
+}
+
+} // namespace KWin
@@ -0,0 +1,76 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2020 KWin developers <kwin@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QRect>
+#include <QVector>
+
+namespace KWin
+{
+
+/**
+ * The AtlasAllocator class hands out non-overlapping rectangles of a texture atlas.
+ *
+ * The atlas is divided into shelves, i.e. horizontal stripes spanning the whole width.
+ * A rectangle is placed into the lowest shelf that is high enough without wasting too
+ * much space, at the left-most free span that is wide enough. If there is no such shelf,
+ * a new one is opened below the existing ones. Decorations of the same style have the
+ * same height, so they usually end up packed next to each other in the same shelf.
+ */
+class AtlasAllocator
+{
+public:
+    explicit AtlasAllocator(const QSize &size = QSize());
+
+    QSize size() const;
+
+    /**
+     * Makes the atlas higher. Rectangles which have been handed out keep their position.
+     */
+    void grow(int height);
+
+    /**
+     * Returns a rectangle of the given @p size, or an invalid rectangle if the atlas is too full.
+     */
+    QRect allocate(const QSize &size);
+
+    /**
+     * Gives @p rect, which must have been returned by allocate(), back to the atlas.
+     */
+    void deallocate(const QRect &rect);
+
+    /**
+     * Returns @c true if no rectangle is handed out.
+     */
+    bool isEmpty() const;
+
+    // the heights of shelves are multiples of this
+    static const int s_shelfGranularity = 8;
+
+private:
+    struct Span {
+        int x;
+        int width;
+    };
+    struct Shelf {
+        int y;
+        int height;
+        int allocations;
+        QVector<Span> free; // sorted by x, never adjacent
+    };
+
+    QRect allocateInShelf(Shelf &shelf, const QSize &size);
+
+    QSize m_size;
+    QVector<Shelf> m_shelves; // sorted by y, without gaps
+    int m_allocations = 0;
+};
+
+} // namespace KWin
@@ -30,18 +30,21 @@
 #include "composite.h"
 #include "deleted.h"
 #include "effects.h"
+#include "atlasallocator.h"
 #include "lanczosfilter.h"
 #include "main.h"
 #include "overlaywindow.h"
 #include "screens.h"
 #include "cursor.h"
 #include "decorations/decoratedclient.h"
+#include "paintrecorder.h"
 #include <logging.h>
 
 #include <KWaylandServer/buffer_interface.h>
 #include <KWaylandServer/subcompositor_interface.h>
 #include <KWaylandServer/surface_interface.h>
 
+#include <algorithm>
 #include <array>
 #include <cmath>
 #include <cstddef>
@@ -53,9 +56,11 @@
 #include <QGraphicsScale>
 #include <QPainter>
 #include <QStringList>
+#include <QTimer>
 #include <QVector2D>
 #include <QVector4D>
 #include <QMatrix4x4>
+#include <QtConcurrentMap>
 
 #include <KLocalizedString>
 #include <KNotification>
@@ -350,6 +355,11 @@ SceneOpenGL::SceneOpenGL(OpenGLBackend *backend, QObject *parent)
             qCDebug(KWIN_OPENGL) << "Explicit synchronization with the X command stream disabled by environment variable";
         }
     }
+
+    // GPU timestamps are used to predict the render time of the next frame
+    if (!glPlatform->isGLES() && (hasGLVersion(3, 3) || hasGLExtension(QByteArrayLiteral("GL_ARB_timer_query")))) {
+        glGenQueries(2, m_timerQueries);
+    }
 }
 
 SceneOpenGL::~SceneOpenGL()
@@ -359,6 +369,10 @@ SceneOpenGL::~SceneOpenGL()
     }
     SceneOpenGL::EffectFrame::cleanup();
 
+    if (m_timerQueries[0]) {
+        glDeleteQueries(2, m_timerQueries);
+    }
+
     delete m_syncManager;
 
     // backend might be still needed for a different scene
@@ -615,6 +629,7 @@ qint64 SceneOpenGL::paint(const QRegion &damage, const QList<Toplevel *> &toplev
 {
     // actually paint the frame, flushed with the NEXT frame
     createStackingOrder(toplevels);
+    m_drawCalls = 0;
 
     // After this call, updateRegion will contain the damaged region in the
     // back buffer. This is the region that needs to be posted to repair
@@ -622,11 +637,53 @@ qint64 SceneOpenGL::paint(const QRegion &damage, const QList<Toplevel *> &toplev
     // by prepareRenderingFrame(). validRegion is the region that has been
     // repainted, and may be larger than updateRegion.
     QRegion updateRegion, validRegion;
+    // Presenting may block until the next vblank, that's not part of the render time.
+    qint64 presentTime = 0;
     if (m_backend->perScreenRendering()) {
         // trigger start render timer
         m_backend->prepareRenderingFrame();
+        m_overlayRegions.resize(screens()->count());
         for (int i = 0; i < screens()->count(); ++i) {
             const QRect &geo = screens()->geometry(i);
+            AbstractOutput *output = kwinApp()->platform()->findOutput(i);
+            if (output && !Compositor::self()->isOutputReady(output)) {
+                // It still waits for a page flip, the compositor carries its damage over.
+                continue;
+            }
+            if (!damage.intersects(geo) && !windowRepaints().intersects(geo)
+                    && !overlayPlanesOutdated(i, geo)) {
+                // Nothing changed on this output.
+                continue;
+            }
+            if (KWaylandServer::SurfaceInterface *surface = directScanoutCandidate(geo)) {
+                if (m_backend->scanout(i, surface)) {
+                    // The repaints have been taken care of by putting the buffer on screen.
+                    for (Window *window : stackingOrder()) {
+                        if (geo.contains(window->window()->visibleRect())) {
+                            window->window()->resetRepaints();
+                        }
+                    }
+                    // The next composited frame is a full repaint anyway.
+                    m_overlayRegions[i] = QRegion();
+                    continue;
+                }
+            }
+
+            // Windows shown on overlay planes are left out of the composition on this screen.
+            const QVector<Toplevel *> overlayWindows = m_backend->assignOverlayPlanes(i, overlayPlaneCandidates(geo));
+            QVector<Window *> disabledWindows;
+            QRegion overlayRegion;
+            for (Window *window : stackingOrder()) {
+                if (overlayWindows.contains(window->window())) {
+                    overlayRegion += window->window()->bufferGeometry();
+                    window->window()->resetRepaints();
+                    disabledWindows << window;
+                }
+            }
+            // Below windows which left an overlay plane the content is outdated.
+            const QRegion screenDamage = (damage.intersected(geo) | (m_overlayRegions[i] - overlayRegion)) - overlayRegion;
+            m_overlayRegions[i] = overlayRegion;
+
             const qreal scaling = screens()->scale(i);
             QRegion update;
             QRegion valid;
@@ -640,18 +697,29 @@ qint64 SceneOpenGL::paint(const QRegion &damage, const QList<Toplevel *> &toplev
             const GLenum status = glGetGraphicsResetStatus();
             if (status != GL_NO_ERROR) {
                 handleGraphicsReset(status);
+                abortGpuTimer();
+                clearStackingOrder();
                 return 0;
             }
+            beginGpuTimer();
 
             int mask = 0;
             updateProjectionMatrix();
 
-            paintScreen(&mask, damage.intersected(geo), repaint, &update, &valid, projectionMatrix(), geo, scaling);   // call generic implementation
+            for (Window *window : qAsConst(disabledWindows)) {
+                window->disablePainting(Window::PAINT_DISABLED_BY_OVERLAY);
+            }
+            paintScreen(&mask, screenDamage, repaint, &update, &valid, projectionMatrix(), geo, scaling);   // call generic implementation
             paintCursor();
+            for (Window *window : qAsConst(disabledWindows)) {
+                window->enablePainting(Window::PAINT_DISABLED_BY_OVERLAY);
+            }
 
             GLVertexBuffer::streamingBuffer()->endOfFrame();
 
+            const qint64 presentStart = m_backend->renderTime();
             m_backend->endRenderingFrameForScreen(i, valid, update);
+            presentTime += m_backend->renderTime() - presentStart;
 
             GLVertexBuffer::streamingBuffer()->framePosted();
         }
@@ -662,8 +730,11 @@ qint64 SceneOpenGL::paint(const QRegion &damage, const QList<Toplevel *> &toplev
         const GLenum status = glGetGraphicsResetStatus();
         if (status != GL_NO_ERROR) {
             handleGraphicsReset(status);
+            abortGpuTimer();
+            clearStackingOrder();
             return 0;
         }
+        beginGpuTimer();
         GLVertexBuffer::setVirtualScreenGeometry(screens()->geometry());
         GLRenderTarget::setVirtualScreenGeometry(screens()->geometry());
         GLVertexBuffer::setVirtualScreenScale(1);
@@ -690,7 +761,9 @@ qint64 SceneOpenGL::paint(const QRegion &damage, const QList<Toplevel *> &toplev
 
         GLVertexBuffer::streamingBuffer()->endOfFrame();
 
+        const qint64 presentStart = m_backend->renderTime();
         m_backend->endRenderingFrame(validRegion, updateRegion);
+        presentTime = m_backend->renderTime() - presentStart;
 
         GLVertexBuffer::streamingBuffer()->framePosted();
     }
@@ -705,11 +778,158 @@ qint64 SceneOpenGL::paint(const QRegion &damage, const QList<Toplevel *> &toplev
         m_currentFence = nullptr;
     }
 
+    endGpuTimer();
+    m_lastFrameDrawCalls = m_drawCalls;
+
+    setCpuRenderTime(m_backend->renderTime() - presentTime);
+
     // do cleanup
     clearStackingOrder();
     return m_backend->renderTime();
 }
 
+KWaylandServer::SurfaceInterface *SceneOpenGL::directScanoutCandidate(const QRect &geometry) const
+{
+    if (!waylandServer() || kwinApp()->platform()->usesSoftwareCursor()) {
+        return nullptr;
+    }
+    if (static_cast<EffectsHandlerImpl *>(effects)->blocksDirectScanout()) {
+        return nullptr;
+    }
+    // Find the topmost window on the screen, it has to cover the screen on its own.
+    const QVector<Window *> &windows = stackingOrder();
+    for (int i = windows.count() - 1; i >= 0; --i) {
+        Window *window = windows[i];
+        Toplevel *toplevel = window->window();
+        if (!toplevel->visibleRect().intersects(geometry)) {
+            continue;
+        }
+        window->resetPaintingEnabled();
+        if (!window->isPaintingEnabled()) {
+            continue;
+        }
+        AbstractClient *client = qobject_cast<AbstractClient *>(toplevel);
+        if (!client || !client->isFullScreen() || !window->isOpaque()) {
+            return nullptr;
+        }
+        if (client->frameGeometry() != geometry || client->bufferGeometry() != geometry) {
+            return nullptr;
+        }
+        KWaylandServer::SurfaceInterface *surface = client->surface();
+        if (!surface || !surface->childSubSurfaces().isEmpty()) {
+            return nullptr;
+        }
+        return surface;
+    }
+    return nullptr;
+}
+
+QVector<Toplevel *> SceneOpenGL::overlayPlaneCandidates(const QRect &geometry) const
+{
+    QVector<Toplevel *> candidates;
+    if (!waylandServer() || kwinApp()->platform()->usesSoftwareCursor()) {
+        return candidates;
+    }
+    if (static_cast<EffectsHandlerImpl *>(effects)->blocksDirectScanout()) {
+        return candidates;
+    }
+    // Overlay planes are stacked above the composited content, so a window can only go
+    // on one if nothing above it covers it. The order of the overlay planes among each
+    // other is not known either, so the candidates must not overlap.
+    QRegion covered;
+    const QVector<Window *> &windows = stackingOrder();
+    for (int i = windows.count() - 1; i >= 0; --i) {
+        Window *window = windows[i];
+        Toplevel *toplevel = window->window();
+        const QRect visibleRect = toplevel->visibleRect();
+        if (!visibleRect.intersects(geometry)) {
+            continue;
+        }
+        window->resetPaintingEnabled();
+        if (!window->isPaintingEnabled()) {
+            continue;
+        }
+        const bool isCandidate = !covered.intersects(visibleRect)
+                && window->isOpaque()
+                && geometry.contains(visibleRect)
+                // decorations and shadows have to be composited
+                && visibleRect == toplevel->bufferGeometry()
+                && toplevel->surface()
+                && toplevel->surface()->childSubSurfaces().isEmpty();
+        if (isCandidate) {
+            candidates << toplevel;
+        }
+        covered += visibleRect;
+    }
+    return candidates;
+}
+
+bool SceneOpenGL::overlayPlanesOutdated(int screenId, const QRect &geometry) const
+{
+    // A window can stop being a candidate without any damage on the screen, e.g. when an
+    // effect becomes active. It has to be composited again then.
+    if (m_overlayRegions.value(screenId).isEmpty()) {
+        return false;
+    }
+    QRegion candidatesRegion;
+    const QVector<Toplevel *> candidates = overlayPlaneCandidates(geometry);
+    for (Toplevel *candidate : candidates) {
+        candidatesRegion += candidate->bufferGeometry();
+    }
+    return !(m_overlayRegions.value(screenId) - candidatesRegion).isEmpty();
+}
+
+qint64 SceneOpenGL::gpuRenderTime() const
+{
+    return m_gpuRenderTime;
+}
+
+int SceneOpenGL::drawCallCount() const
+{
+    return m_lastFrameDrawCalls;
+}
+
+void SceneOpenGL::beginGpuTimer()
+{
+    if (!m_timerQueries[0] || m_timerQueryRunning) {
+        return;
+    }
+    if (m_timerQueryPending) {
+        // Don't stall on the result, the previous frame is usually finished by now.
+        // If it isn't, skip measuring this frame.
+        GLint available = 0;
+        glGetQueryObjectiv(m_timerQueries[1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) {
+            return;
+        }
+        GLuint64 start = 0;
+        GLuint64 end = 0;
+        glGetQueryObjectui64v(m_timerQueries[0], GL_QUERY_RESULT, &start);
+        glGetQueryObjectui64v(m_timerQueries[1], GL_QUERY_RESULT, &end);
+        m_gpuRenderTime = end > start ? end - start : 0;
+        m_timerQueryPending = false;
+    }
+    glQueryCounter(m_timerQueries[0], GL_TIMESTAMP);
+    m_timerQueryRunning = true;
+}
+
+void SceneOpenGL::endGpuTimer()
+{
+    if (!m_timerQueryRunning) {
+        return;
+    }
+    glQueryCounter(m_timerQueries[1], GL_TIMESTAMP);
+    m_timerQueryRunning = false;
+    m_timerQueryPending = true;
+}
+
+void SceneOpenGL::abortGpuTimer()
+{
+    // the queries of a lost context never deliver a result
+    m_timerQueryRunning = false;
+    m_timerQueryPending = false;
+}
+
 QMatrix4x4 SceneOpenGL::transformation(int mask, const ScreenPaintData &data) const
 {
     QMatrix4x4 matrix;
@@ -957,6 +1177,33 @@ SceneOpenGL2::SceneOpenGL2(OpenGLBackend *backend, QObject *parent)
 
     qCDebug(KWIN_OPENGL) << "OpenGL 2 compositing successfully initialized";
     init_ok = true;
+
+    QTimer::singleShot(0, this, &SceneOpenGL2::preloadShaders);
+}
+
+void SceneOpenGL2::preloadShaders()
+{
+    // The shader combinations used to paint translucent and transformed windows,
+    // which would otherwise be compiled during the first fade or animation
+    static const ShaderTraits traits[] = {
+        ShaderTrait::MapTexture | ShaderTrait::Modulate,
+        ShaderTrait::MapTexture | ShaderTrait::Modulate | ShaderTrait::AdjustSaturation,
+        ShaderTrait::MapTexture | ShaderTrait::ClampTexture,
+        ShaderTrait::MapTexture | ShaderTrait::ClampTexture | ShaderTrait::Modulate,
+        ShaderTrait::MapTexture | ShaderTrait::ClampTexture | ShaderTrait::Modulate | ShaderTrait::AdjustSaturation,
+        ShaderTrait::UniformColor | ShaderTrait::Modulate,
+    };
+    const int count = sizeof(traits) / sizeof(traits[0]);
+    if (m_preloadedShaders >= count || !makeOpenGLContextCurrent()) {
+        return;
+    }
+
+    // GL objects can only be created on the thread of the context, so the shaders are
+    // created one per event loop iteration to not hold up painting for long
+    ShaderManager::instance()->shader(traits[m_preloadedShaders++]);
+    if (m_preloadedShaders < count) {
+        QTimer::singleShot(0, this, &SceneOpenGL2::preloadShaders);
+    }
 }
 
 SceneOpenGL2::~SceneOpenGL2()
@@ -1009,7 +1256,10 @@ void SceneOpenGL2::paintSimpleScreen(int mask, const QRegion &region)
 {
     m_screenProjectionMatrix = m_projectionMatrix;
 
+    // The screen might be painted from within a window, e.g. for a desktop thumbnail.
+    flushBatchedDraws();
     Scene::paintSimpleScreen(mask, region);
+    flushBatchedDraws();
 }
 
 void SceneOpenGL2::paintGenericScreen(int mask, const ScreenPaintData &data)
@@ -1018,7 +1268,122 @@ void SceneOpenGL2::paintGenericScreen(int mask, const ScreenPaintData &data)
 
     m_screenProjectionMatrix = m_projectionMatrix * screenMatrix;
 
+    flushBatchedDraws();
     Scene::paintGenericScreen(mask, data);
+    flushBatchedDraws();
+}
+
+void SceneOpenGL2::paintWindow(Window *w, int mask, const QRegion &region, const WindowQuadList &quads)
+{
+    // Effects may paint on their own or read back the framebuffer before and after the
+    // window, so everything below has to be on screen by then.
+    Scene::Window *batchedWindow = m_batchedWindow;
+    if (static_cast<EffectsHandlerImpl *>(effects)->hasEffectsForWindow(effectWindow(w))) {
+        flushBatchedDraws();
+        m_batchedWindow = nullptr;
+    } else {
+        m_batchedWindow = w;
+    }
+    Scene::paintWindow(w, mask, region, quads);
+    m_batchedWindow = batchedWindow;
+}
+
+void SceneOpenGL2::addBatchedDraw(const GLTexture &texture, GLenum filter, ShaderTraits traits,
+                                  const QVector4D &modulation, float saturation, bool blend,
+                                  const QRect &bounds, const GLVertex2D *vertices, int vertexCount)
+{
+    // 16 bit indices for GL_QUADS limit the size of a draw
+    const int maximumVertexCount = 65536;
+
+    // A draw can be moved down to an earlier batch as long as it doesn't overlap any of
+    // the batches it skips; otherwise blending would give a different result.
+    DrawBatch *target = nullptr;
+    for (int i = m_drawBatches.count() - 1; i >= 0; --i) {
+        DrawBatch &batch = m_drawBatches[i];
+        if (batch.texture.texture() == texture.texture() && batch.filter == filter
+                && batch.traits == traits && batch.modulation == modulation
+                && batch.saturation == saturation && batch.blend == blend
+                && batch.vertices.count() + vertexCount <= maximumVertexCount) {
+            target = &batch;
+            break;
+        }
+        if (batch.bounds.intersects(bounds)) {
+            break;
+        }
+    }
+    if (!target) {
+        m_drawBatches.append(DrawBatch{texture, filter, traits, modulation, saturation, blend, QRect(), {}});
+        target = &m_drawBatches.last();
+    }
+    target->bounds |= bounds;
+    const int first = target->vertices.count();
+    target->vertices.resize(first + vertexCount);
+    std::copy(vertices, vertices + vertexCount, target->vertices.begin() + first);
+}
+
+void SceneOpenGL2::flushBatchedDraws()
+{
+    if (m_drawBatches.isEmpty()) {
+        return;
+    }
+
+    const GLVertexAttrib attribs[] = {
+        { VA_Position, 2, GL_FLOAT, offsetof(GLVertex2D, position) },
+        { VA_TexCoord, 2, GL_FLOAT, offsetof(GLVertex2D, texcoord) },
+    };
+
+    int vertexCount = 0;
+    for (const DrawBatch &batch : qAsConst(m_drawBatches)) {
+        vertexCount += batch.vertices.count();
+    }
+
+    GLVertexBuffer *vbo = GLVertexBuffer::streamingBuffer();
+    vbo->reset();
+    vbo->setAttribLayout(attribs, 2, sizeof(GLVertex2D));
+    GLVertex2D *map = (GLVertex2D *) vbo->map(vertexCount * sizeof(GLVertex2D));
+    for (const DrawBatch &batch : qAsConst(m_drawBatches)) {
+        map = std::copy(batch.vertices.constBegin(), batch.vertices.constEnd(), map);
+    }
+    vbo->unmap();
+    vbo->bindArrays();
+
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+    const GLenum primitiveType = GLVertexBuffer::supportsIndexedQuads() ? GL_QUADS : GL_TRIANGLES;
+    bool blend = false;
+    int first = 0;
+    for (DrawBatch &batch : m_drawBatches) {
+        if (batch.blend != blend) {
+            if (batch.blend) {
+                glEnable(GL_BLEND);
+            } else {
+                glDisable(GL_BLEND);
+            }
+            blend = batch.blend;
+        }
+
+        GLShader *shader = ShaderManager::instance()->pushShader(batch.traits);
+        shader->setUniform(GLShader::ModelViewProjectionMatrix, m_projectionMatrix);
+        shader->setUniform(GLShader::Saturation, batch.saturation);
+        shader->setUniform(GLShader::ModulationConstant, batch.modulation);
+        shader->setUniform(GLShader::TextureClamp, QVector4D({0, 0, 1, 1}));
+
+        batch.texture.setFilter(batch.filter);
+        batch.texture.setWrapMode(GL_CLAMP_TO_EDGE);
+        batch.texture.bind();
+
+        vbo->draw(primitiveType, first, batch.vertices.count());
+        ShaderManager::instance()->popShader();
+        first += batch.vertices.count();
+    }
+
+    vbo->unbindArrays();
+    if (blend) {
+        glDisable(GL_BLEND);
+    }
+
+    addDrawCalls(m_drawBatches.count());
+    m_drawBatches.clear();
 }
 
 void SceneOpenGL2::doPaintBackground(const QVector< float >& vertices)
@@ -1181,7 +1546,7 @@ void OpenGLWindow::endRenderWindow()
     }
 }
 
-GLTexture *OpenGLWindow::getDecorationTexture() const
+GLTexture *OpenGLWindow::getDecorationTexture(QPoint *offset) const
 {
     if (AbstractClient *client = dynamic_cast<AbstractClient *>(toplevel)) {
         if (client->noBorder()) {
@@ -1193,6 +1558,7 @@ GLTexture *OpenGLWindow::getDecorationTexture() const
         }
         if (SceneOpenGLDecorationRenderer *renderer = static_cast<SceneOpenGLDecorationRenderer*>(client->decoratedClient()->renderer())) {
             renderer->render();
+            *offset = renderer->textureRect().topLeft();
             return renderer->texture();
         }
     } else if (toplevel->isDeleted()) {
@@ -1201,6 +1567,7 @@ GLTexture *OpenGLWindow::getDecorationTexture() const
             return nullptr;
         }
         if (const SceneOpenGLDecorationRenderer *renderer = static_cast<const SceneOpenGLDecorationRenderer*>(deleted->decorationRenderer())) {
+            *offset = renderer->textureRect().topLeft();
             return renderer->texture();
         }
     }
@@ -1260,6 +1627,17 @@ void OpenGLWindow::initializeRenderContext(RenderContext &context, const WindowP
 
     QVector<RenderNode> &renderNodes = context.renderNodes;
     renderNodes.resize(nodeCount);
+    for (RenderNode &renderNode : renderNodes) {
+        // clearing keeps the allocated storage of the quads
+        renderNode.quads.clear();
+        renderNode.texture = nullptr;
+        renderNode.textureOffset = QPoint();
+        renderNode.firstVertex = 0;
+        renderNode.vertexCount = 0;
+        renderNode.opacity = 1.0;
+        renderNode.hasAlpha = false;
+        renderNode.coordinateType = UnnormalizedCoordinates;
+    }
 
     for (const WindowQuad &quad : data.quads) {
         switch (quad.type()) {
@@ -1293,7 +1671,7 @@ void OpenGLWindow::initializeRenderContext(RenderContext &context, const WindowP
 
     RenderNode &decorationRenderNode = renderNodes[context.decorationOffset];
     if (!decorationRenderNode.quads.isEmpty()) {
-        decorationRenderNode.texture = getDecorationTexture();
+        decorationRenderNode.texture = getDecorationTexture(&decorationRenderNode.textureOffset);
         decorationRenderNode.opacity = data.opacity();
         decorationRenderNode.hasAlpha = true;
         decorationRenderNode.coordinateType = UnnormalizedCoordinates;
@@ -1402,12 +1780,72 @@ QMatrix4x4 OpenGLWindow::modelViewProjectionMatrix(int mask, const WindowPaintDa
     return scene->projectionMatrix() * mvMatrix;
 }
 
+// Queues the render nodes of an untransformed window in the draw list of the scene.
+void OpenGLWindow::performBatchedPaint(const WindowPaintData &data)
+{
+    SceneOpenGL2 *scene = static_cast<SceneOpenGL2 *>(m_scene);
+    const GLenum filter = waylandServer() ? GL_LINEAR : GL_NEAREST;
+
+    ShaderTraits traits = ShaderTrait::MapTexture;
+    if (data.opacity() != 1.0 || data.brightness() != 1.0 || data.crossFadeProgress() != 1.0)
+        traits |= ShaderTrait::Modulate;
+    if (data.saturation() != 1.0)
+        traits |= ShaderTrait::AdjustSaturation;
+
+    RenderContext &renderContext = m_renderContext;
+    initializeRenderContext(renderContext, data);
+
+    const bool indexedQuads = GLVertexBuffer::supportsIndexedQuads();
+    const GLenum primitiveType = indexedQuads ? GL_QUADS : GL_TRIANGLES;
+    const int verticesPerQuad = indexedQuads ? 4 : 6;
+    const QVector2D offset(x(), y());
+
+    QVector<GLVertex2D> &vertices = m_batchedVertices;
+    for (RenderNode &renderNode : renderContext.renderNodes) {
+        if (renderNode.quads.isEmpty() || !renderNode.texture)
+            continue;
+
+        QMatrix4x4 matrix = renderNode.texture->matrix(renderNode.coordinateType);
+        if (!renderNode.textureOffset.isNull()) {
+            matrix.translate(renderNode.textureOffset.x(), renderNode.textureOffset.y());
+        }
+
+        vertices.resize(renderNode.quads.count() * verticesPerQuad);
+        renderNode.quads.makeInterleavedArrays(primitiveType, vertices.data(), matrix);
+
+        // the window translation is applied to the vertices, so all batched draws can
+        // share the projection matrix of the scene
+        QRectF bounds;
+        for (const WindowQuad &quad : qAsConst(renderNode.quads)) {
+            bounds |= QRectF(QPointF(quad.left(), quad.top()), QPointF(quad.right(), quad.bottom()));
+        }
+        for (GLVertex2D &vertex : vertices) {
+            vertex.position += offset;
+        }
+
+        scene->addBatchedDraw(*renderNode.texture, filter, traits,
+                              modulate(renderNode.opacity, data.brightness()), data.saturation(),
+                              renderNode.hasAlpha || renderNode.opacity < 1.0,
+                              bounds.translated(x(), y()).toAlignedRect(),
+                              vertices.constData(), vertices.count());
+    }
+}
+
 void OpenGLWindow::performPaint(int mask, const QRegion &region, const WindowPaintData &_data)
 {
     WindowPaintData data = _data;
     if (!beginRenderWindow(mask, region, data))
         return;
 
+    SceneOpenGL2 *scene = static_cast<SceneOpenGL2 *>(m_scene);
+    if (scene->isBatching(this) && !m_hardwareClipping && !data.shader
+            && !(mask & (Scene::PAINT_WINDOW_TRANSFORMED | Scene::PAINT_SCREEN_TRANSFORMED))
+            && data.projectionMatrix().isIdentity() && data.modelViewMatrix().isIdentity()) {
+        performBatchedPaint(data);
+        return;
+    }
+    scene->flushBatchedDraws();
+
     QMatrix4x4 windowMatrix = transformation(mask, data);
     const QMatrix4x4 modelViewProjection = modelViewProjectionMatrix(mask, data);
     const QMatrix4x4 mvpMatrix = modelViewProjection * windowMatrix;
@@ -1448,7 +1886,7 @@ void OpenGLWindow::performPaint(int mask, const QRegion &region, const WindowPai
 
     shader->setUniform(GLShader::Saturation, data.saturation());
 
-    RenderContext renderContext;
+    RenderContext &renderContext = m_renderContext;
     initializeRenderContext(renderContext, data);
 
     const bool indexedQuads = GLVertexBuffer::supportsIndexedQuads();
@@ -1468,7 +1906,10 @@ void OpenGLWindow::performPaint(int mask, const QRegion &region, const WindowPai
         renderNode.firstVertex = v;
         renderNode.vertexCount = renderNode.quads.count() * verticesPerQuad;
 
-        const QMatrix4x4 matrix = renderNode.texture->matrix(renderNode.coordinateType);
+        QMatrix4x4 matrix = renderNode.texture->matrix(renderNode.coordinateType);
+        if (!renderNode.textureOffset.isNull()) {
+            matrix.translate(renderNode.textureOffset.x(), renderNode.textureOffset.y());
+        }
 
         renderNode.quads.makeInterleavedArrays(primitiveType, &map[v], matrix);
         v += renderNode.quads.count() * verticesPerQuad;
@@ -1520,6 +1961,7 @@ void OpenGLWindow::performPaint(int mask, const QRegion &region, const WindowPai
 
         vbo->draw(region, primitiveType, renderNode.firstVertex,
                   renderNode.vertexCount, m_hardwareClipping);
+        m_scene->addDrawCalls(m_hardwareClipping ? region.rectCount() : 1);
     }
 
     vbo->unbindArrays();
@@ -2515,18 +2957,175 @@ bool SceneOpenGLShadow::prepareBackend()
     return true;
 }
 
+/**
+ * Packs the decorations of all windows into a few large textures, so that painting the
+ * decorations doesn't switch between lots of small textures. A texture starts small and
+ * grows up to the maximum page size, only then another one gets created.
+ */
+class DecorationAtlas
+{
+public:
+    ~DecorationAtlas();
+    DecorationAtlas(const DecorationAtlas&) = delete;
+    static DecorationAtlas &instance();
+
+    /**
+     * Reserves an area of the given @p size, which is stored in @p rect, and returns
+     * the texture it belongs to. Returns @c nullptr if the size is too large.
+     */
+    GLTexture *allocate(const QSize &size, QRect *rect);
+    void deallocate(GLTexture *texture, const QRect &rect);
+
+private:
+    DecorationAtlas() = default;
+    struct Page {
+        GLTexture texture;
+        AtlasAllocator allocator;
+    };
+    static GLTexture createTexture(const QSize &size);
+    bool grow(Page *page);
+
+    QVector<Page *> m_pages;
+
+    static const int s_pageWidth = 4096;
+    static const int s_initialPageHeight = 256;
+    static const int s_maximumPageHeight = 2048;
+};
+
+DecorationAtlas &DecorationAtlas::instance()
+{
+    static DecorationAtlas s_instance;
+    return s_instance;
+}
+
+DecorationAtlas::~DecorationAtlas()
+{
+    Q_ASSERT(m_pages.isEmpty());
+}
+
+GLTexture DecorationAtlas::createTexture(const QSize &size)
+{
+    GLTexture texture(GL_RGBA8, size);
+    texture.setYInverted(true);
+    texture.setWrapMode(GL_CLAMP_TO_EDGE);
+    texture.clear();
+    return texture;
+}
+
+bool DecorationAtlas::grow(Page *page)
+{
+    const QSize oldSize = page->allocator.size();
+    if (oldSize.height() >= s_maximumPageHeight) {
+        return false;
+    }
+    const QSize newSize(oldSize.width(), qMin(oldSize.height() * 2, int(s_maximumPageHeight)));
+
+    // the areas which have been handed out keep their position, so copy them over
+    GLTexture texture = createTexture(newSize);
+    GLRenderTarget target(page->texture);
+    if (!target.valid()) {
+        return false;
+    }
+    GLRenderTarget::pushRenderTarget(&target);
+    texture.bind();
+    glCopyTexSubImage2D(texture.target(), 0, 0, 0, 0, 0, oldSize.width(), oldSize.height());
+    texture.unbind();
+    GLRenderTarget::popRenderTarget();
+
+    page->texture = texture;
+    page->allocator.grow(newSize.height());
+    return true;
+}
+
+GLTexture *DecorationAtlas::allocate(const QSize &size, QRect *rect)
+{
+    for (Page *page : qAsConst(m_pages)) {
+        if (size.width() > page->allocator.size().width()) {
+            continue;
+        }
+        do {
+            *rect = page->allocator.allocate(size);
+            if (rect->isValid()) {
+                return &page->texture;
+            }
+        } while (grow(page));
+    }
+
+    GLint maxTextureSize = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+    if (size.width() > maxTextureSize || size.height() > maxTextureSize) {
+        return nullptr;
+    }
+
+    // decorations wider than a page, e.g. of maximized windows on large hidpi screens,
+    // get a wider page
+    QSize pageSize(qMax(qMin(int(s_pageWidth), int(maxTextureSize)), size.width()), s_initialPageHeight);
+    while (pageSize.height() < size.height() + AtlasAllocator::s_shelfGranularity) {
+        pageSize.rheight() *= 2;
+    }
+    pageSize.setHeight(qMin(pageSize.height(), int(maxTextureSize)));
+
+    Page *page = new Page{createTexture(pageSize), AtlasAllocator(pageSize)};
+    *rect = page->allocator.allocate(size);
+    if (!rect->isValid()) {
+        delete page;
+        return nullptr;
+    }
+    m_pages.append(page);
+    return &page->texture;
+}
+
+void DecorationAtlas::deallocate(GLTexture *texture, const QRect &rect)
+{
+    auto it = std::find_if(m_pages.begin(), m_pages.end(),
+        [texture](const Page *page) {
+            return &page->texture == texture;
+        });
+    if (it == m_pages.end()) {
+        return;
+    }
+    Page *page = *it;
+    page->allocator.deallocate(rect);
+    if (page->allocator.isEmpty()) {
+        m_pages.erase(it);
+        delete page;
+    }
+}
+
+struct SceneOpenGLDecorationRenderer::DirtyPart
+{
+    QImage image;
+    PaintRecorder recorder;
+    QRect geometry;
+    QRect viewport;
+    QSize size;
+    QPoint position;
+    bool rotated = false;
+};
+
 SceneOpenGLDecorationRenderer::SceneOpenGLDecorationRenderer(Decoration::DecoratedClientImpl *client)
     : Renderer(client)
-    , m_texture()
 {
     connect(this, &Renderer::renderScheduled, client->client(), static_cast<void (AbstractClient::*)(const QRect&)>(&AbstractClient::addRepaint));
+    connect(&m_rasterizer, &QFutureWatcher<void>::finished, this, [this] {
+        if (Scene *scene = Compositor::self()->scene()) {
+            scene->makeOpenGLContextCurrent();
+        }
+        const QRegion repaint = uploadDirtyParts();
+        if (this->client()) {
+            this->client()->client()->addRepaint(repaint);
+        }
+    });
 }
 
 SceneOpenGLDecorationRenderer::~SceneOpenGLDecorationRenderer()
 {
+    // the parts are still referenced by the thread pool
+    m_rasterizer.waitForFinished();
     if (Scene *scene = Compositor::self()->scene()) {
         scene->makeOpenGLContextCurrent();
     }
+    releaseTexture();
 }
 
 // Rotates the given source rect 90° counter-clockwise,
@@ -2602,13 +3201,25 @@ static void clamp(QImage &image, const QRect &viewport)
 
 void SceneOpenGLDecorationRenderer::render()
 {
+    if (!m_dirtyParts.isEmpty()) {
+        if (!m_rasterizer.isFinished()) {
+            // whatever got scheduled in the meantime is rendered once the
+            // running rasterization is uploaded and repaints the decoration
+            return;
+        }
+        // finished, but the watcher did not get to deliver it yet
+        uploadDirtyParts();
+    }
+
     const QRegion scheduled = getScheduled();
     if (scheduled.isEmpty()) {
         return;
     }
+    bool textureResized = false;
     if (areImageSizesDirty()) {
         resizeTexture();
         resetImageSizesDirty();
+        textureResized = true;
     }
 
     if (!m_texture) {
@@ -2622,7 +3233,9 @@ void SceneOpenGLDecorationRenderer::render()
     // We pad each part in the decoration atlas in order to avoid texture bleeding.
     const int padding = 1;
 
-    auto renderPart = [=](const QRect &geo, const QRect &partRect, const QPoint &position, bool rotated = false) {
+    // The decoration has to be painted on this thread, but the painting operations are
+    // only recorded here. The rasterization happens on the thread pool further down.
+    auto recordPart = [&](const QRect &geo, const QRect &partRect, const QPoint &position, bool rotated = false) {
         if (!geo.isValid()) {
             return;
         }
@@ -2645,31 +3258,28 @@ void SceneOpenGLDecorationRenderer::render()
             rect.setBottom(rect.bottom() + padding);
         }
 
-        QRect viewport = geo.translated(-rect.x(), -rect.y());
+        QSharedPointer<DirtyPart> part(new DirtyPart);
+        part->geometry = geo;
+        part->viewport = geo.translated(-rect.x(), -rect.y());
+        part->size = rect.size();
+        part->rotated = rotated;
+        part->position = position + geo.topLeft() - partRect.topLeft();
         const qreal devicePixelRatio = client()->client()->screenScale();
 
-        QImage image(rect.size() * devicePixelRatio, QImage::Format_ARGB32_Premultiplied);
-        image.setDevicePixelRatio(devicePixelRatio);
-        image.fill(Qt::transparent);
+        part->image = QImage(rect.size() * devicePixelRatio, QImage::Format_ARGB32_Premultiplied);
+        part->image.setDevicePixelRatio(devicePixelRatio);
+        part->image.fill(Qt::transparent);
+        part->recorder.setTarget(&part->image);
 
-        QPainter painter(&image);
+        QPainter painter(&part->recorder);
         painter.setRenderHint(QPainter::Antialiasing);
-        painter.setViewport(QRect(viewport.topLeft(), viewport.size() * devicePixelRatio));
+        painter.setViewport(QRect(part->viewport.topLeft(), part->viewport.size() * devicePixelRatio));
         painter.setWindow(QRect(geo.topLeft(), geo.size() * devicePixelRatio));
         painter.setClipRect(geo);
         renderToPainter(&painter, geo);
         painter.end();
 
-        clamp(image, QRect(viewport.topLeft(), viewport.size() * devicePixelRatio));
-
-        if (rotated) {
-            // TODO: get this done directly when rendering to the image
-            image = rotate(image, QRect(QPoint(), rect.size()));
-            viewport = QRect(viewport.y(), viewport.x(), viewport.height(), viewport.width());
-        }
-
-        const QPoint dirtyOffset = geo.topLeft() - partRect.topLeft();
-        m_texture->update(image, (position + dirtyOffset - viewport.topLeft()) * image.devicePixelRatio());
+        m_dirtyParts << part;
     };
 
     const QRect geometry = scheduled.boundingRect();
@@ -2679,10 +3289,49 @@ void SceneOpenGLDecorationRenderer::render()
     const QPoint leftPosition(padding, bottomPosition.y() + bottom.height() + 2 * padding);
     const QPoint rightPosition(padding, leftPosition.y() + left.width() + 2 * padding);
 
-    renderPart(left.intersected(geometry), left, leftPosition, true);
-    renderPart(top.intersected(geometry), top, topPosition);
-    renderPart(right.intersected(geometry), right, rightPosition, true);
-    renderPart(bottom.intersected(geometry), bottom, bottomPosition);
+    recordPart(left.intersected(geometry), left, leftPosition, true);
+    recordPart(top.intersected(geometry), top, topPosition);
+    recordPart(right.intersected(geometry), right, rightPosition, true);
+    recordPart(bottom.intersected(geometry), bottom, bottomPosition);
+
+    if (m_dirtyParts.isEmpty()) {
+        return;
+    }
+
+    // every part is a task of its own, so the tiles of a part are replayed on the same thread
+    m_rasterizer.setFuture(QtConcurrent::map(m_dirtyParts, [](const QSharedPointer<DirtyPart> &part) {
+        const qreal devicePixelRatio = part->image.devicePixelRatio();
+        part->recorder.replay(part->image.rect(), PaintRecorder::ReplayMode::Sequential);
+
+        clamp(part->image, QRect(part->viewport.topLeft(), part->viewport.size() * devicePixelRatio));
+
+        if (part->rotated) {
+            // TODO: get this done directly when rendering to the image
+            part->image = rotate(part->image, QRect(QPoint(), part->size));
+            part->viewport = QRect(part->viewport.y(), part->viewport.x(), part->viewport.height(), part->viewport.width());
+        }
+    }));
+
+    if (textureResized) {
+        // a freshly allocated texture has nothing to show until the parts are uploaded
+        m_rasterizer.waitForFinished();
+        uploadDirtyParts();
+    }
+}
+
+QRegion SceneOpenGLDecorationRenderer::uploadDirtyParts()
+{
+    // uploading has to happen on the main thread with the context current
+    QRegion uploaded;
+    for (const QSharedPointer<DirtyPart> &part : qAsConst(m_dirtyParts)) {
+        if (m_texture) {
+            m_texture->update(part->image, m_textureRect.topLeft()
+                              + (part->position - part->viewport.topLeft()) * part->image.devicePixelRatio());
+        }
+        uploaded += part->geometry;
+    }
+    m_dirtyParts.clear();
+    return uploaded;
 }
 
 static int align(int value, int align)
@@ -2709,22 +3358,43 @@ void SceneOpenGLDecorationRenderer::resizeTexture()
     size.rwidth() = align(size.width(), 128);
 
     size *= client()->client()->screenScale();
-    if (m_texture && m_texture->size() == size)
+    if (m_texture && m_textureRect.size() == size)
         return;
 
-    if (!size.isEmpty()) {
-        m_texture.reset(new GLTexture(GL_RGBA8, size.width(), size.height()));
-        m_texture->setYInverted(true);
-        m_texture->setWrapMode(GL_CLAMP_TO_EDGE);
-        m_texture->clear();
-    } else {
-        m_texture.reset();
+    releaseTexture();
+    if (size.isEmpty()) {
+        return;
+    }
+
+    m_texture = DecorationAtlas::instance().allocate(size, &m_textureRect);
+    if (m_texture) {
+        // get rid of what the previous user of the area left behind
+        QImage image(size, QImage::Format_ARGB32_Premultiplied);
+        image.fill(Qt::transparent);
+        m_texture->update(image, m_textureRect.topLeft());
+    }
+}
+
+void SceneOpenGLDecorationRenderer::releaseTexture()
+{
+    if (m_texture) {
+        DecorationAtlas::instance().deallocate(m_texture, m_textureRect);
+        m_texture = nullptr;
+        m_textureRect = QRect();
     }
 }
 
 void SceneOpenGLDecorationRenderer::reparent(Deleted *deleted)
 {
     render();
+    if (!m_dirtyParts.isEmpty()) {
+        // the deleted window is never rendered again, it has to show the final decoration
+        m_rasterizer.waitForFinished();
+        if (Scene *scene = Compositor::self()->scene()) {
+            scene->makeOpenGLContextCurrent();
+        }
+        uploadDirtyParts();
+    }
     Renderer::reparent(deleted);
 }
 
@@ -19,6 +19,9 @@
 #include "decorations/decorationrenderer.h"
 #include "platformsupport/scenes/opengl/backend.h"
 
+#include <QFutureWatcher>
+#include <QSharedPointer>
+
 namespace KWin
 {
 class LanczosFilter;
@@ -36,6 +39,8 @@ public:
     bool initFailed() const override;
     bool hasPendingFlush() const override;
     qint64 paint(const QRegion &damage, const QList<Toplevel *> &windows) override;
+    qint64 gpuRenderTime() const override;
+    int drawCallCount() const override;
     Scene::EffectFrame *createEffectFrame(EffectFrameImpl *frame) override;
     Shadow *createShadow(Toplevel *toplevel) override;
     void screenGeometryChanged(const QSize &size) override;
@@ -52,6 +57,13 @@ public:
 
     void insertWait();
 
+    /**
+     * Accounts @p count draw calls to the frame which is being painted.
+     */
+    void addDrawCalls(int count) {
+        m_drawCalls += count;
+    }
+
     void idle() override;
 
     bool debug() const { return m_debug; }
@@ -91,12 +103,26 @@ protected:
     bool init_ok;
 private:
     bool viewportLimitsMatched(const QSize &size) const;
+    KWaylandServer::SurfaceInterface *directScanoutCandidate(const QRect &geometry) const;
+    QVector<Toplevel *> overlayPlaneCandidates(const QRect &geometry) const;
+    bool overlayPlanesOutdated(int screenId, const QRect &geometry) const;
+    void beginGpuTimer();
+    void endGpuTimer();
+    void abortGpuTimer();
 
 private:
     bool m_debug;
     OpenGLBackend *m_backend;
     SyncManager *m_syncManager;
     SyncObject *m_currentFence;
+    GLuint m_timerQueries[2] = {0, 0};
+    bool m_timerQueryRunning = false;
+    bool m_timerQueryPending = false;
+    qint64 m_gpuRenderTime = 0;
+    int m_drawCalls = 0;
+    int m_lastFrameDrawCalls = 0;
+    // Per screen, the area shown on overlay planes in the last frame
+    QVector<QRegion> m_overlayRegions;
 };
 
 class SceneOpenGL2 : public SceneOpenGL
@@ -114,9 +140,31 @@ public:
     QMatrix4x4 projectionMatrix() const override { return m_projectionMatrix; }
     QMatrix4x4 screenProjectionMatrix() const override { return m_screenProjectionMatrix; }
 
+    /**
+     * Returns @c true if the draws of @p window may be queued in the draw list rather
+     * than being submitted right away. This is only the case while the scene paints
+     * the window itself and no effect takes part in painting it.
+     */
+    bool isBatching(const Scene::Window *window) const {
+        return m_batchedWindow == window;
+    }
+    /**
+     * Queues a draw of @p vertices, which are given in screen coordinates, using the
+     * default projection. The draw is merged with an earlier draw of the same state if
+     * no draw in between overlaps @p bounds.
+     */
+    void addBatchedDraw(const GLTexture &texture, GLenum filter, ShaderTraits traits,
+                        const QVector4D &modulation, float saturation, bool blend,
+                        const QRect &bounds, const GLVertex2D *vertices, int vertexCount);
+    /**
+     * Submits all queued draws.
+     */
+    void flushBatchedDraws();
+
 protected:
     void paintSimpleScreen(int mask, const QRegion &region) override;
     void paintGenericScreen(int mask, const ScreenPaintData &data) override;
+    void paintWindow(Window *w, int mask, const QRegion &region, const WindowQuadList &quads) override;
     void doPaintBackground(const QVector< float >& vertices) override;
     Scene::Window *createWindow(Toplevel *t) override;
     void finalDrawWindow(EffectWindowImpl* w, int mask, const QRegion &region, WindowPaintData& data) override;
@@ -126,6 +174,11 @@ protected:
 private:
     void performPaintWindow(EffectWindowImpl* w, int mask, const QRegion &region, WindowPaintData& data);
     QMatrix4x4 createProjectionMatrix() const;
+    /**
+     * Creates the next of the commonly used shaders, so that they are compiled, or loaded
+     * from the program cache, before they are needed for painting.
+     */
+    void preloadShaders();
 
 private:
     LanczosFilter *m_lanczosFilter;
@@ -133,6 +186,20 @@ private:
     QMatrix4x4 m_projectionMatrix;
     QMatrix4x4 m_screenProjectionMatrix;
     GLuint vao;
+
+    struct DrawBatch {
+        GLTexture texture;
+        GLenum filter;
+        ShaderTraits traits;
+        QVector4D modulation;
+        float saturation;
+        bool blend;
+        QRect bounds;
+        QVector<GLVertex2D> vertices;
+    };
+    QVector<DrawBatch> m_drawBatches;
+    Scene::Window *m_batchedWindow = nullptr;
+    int m_preloadedShaders = 0;
 };
 
 class OpenGLWindowPixmap;
@@ -157,6 +224,7 @@ public:
         }
 
         GLTexture *texture;
+        QPoint textureOffset; // where the unnormalized texture coordinates start in the texture
         WindowQuadList quads;
         int firstVertex;
         int vertexCount;
@@ -185,16 +253,20 @@ public:
 
 private:
     QMatrix4x4 transformation(int mask, const WindowPaintData &data) const;
-    GLTexture *getDecorationTexture() const;
+    GLTexture *getDecorationTexture(QPoint *offset) const;
     QMatrix4x4 modelViewProjectionMatrix(int mask, const WindowPaintData &data) const;
     QVector4D modulate(float opacity, float brightness) const;
     void setBlendEnabled(bool enabled);
     void initializeRenderContext(RenderContext &context, const WindowPaintData &data);
+    void performBatchedPaint(const WindowPaintData &data);
     bool beginRenderWindow(int mask, const QRegion &region, WindowPaintData &data);
     void endRenderWindow();
     bool bindTexture();
 
     SceneOpenGL *m_scene;
+    // reused by every paint, so that the quad lists keep their storage across frames
+    RenderContext m_renderContext;
+    QVector<GLVertex2D> m_batchedVertices;
     bool m_hardwareClipping = false;
     bool m_blendingEnabled = false;
 };
@@ -293,16 +365,32 @@ public:
     void render() override;
     void reparent(Deleted *deleted) override;
 
-    GLTexture *texture() {
-        return m_texture.data();
-    }
+    /**
+     * The texture the decoration is stored in, it's shared with other decorations.
+     */
     GLTexture *texture() const {
-        return m_texture.data();
+        return m_texture;
+    }
+    /**
+     * The area of texture() holding this decoration, in device pixels.
+     */
+    QRect textureRect() const {
+        return m_textureRect;
     }
 
 private:
+    struct DirtyPart;
+
     void resizeTexture();
-    QScopedPointer<GLTexture> m_texture;
+    void releaseTexture();
+    QRegion uploadDirtyParts();
+    GLTexture *m_texture = nullptr;
+    QRect m_textureRect;
+    /**
+     * The parts which are rasterized on the thread pool, they get uploaded once m_rasterizer finishes.
+     */
+    QVector<QSharedPointer<DirtyPart>> m_dirtyParts;
+    QFutureWatcher<void> m_rasterizer;
 };
 
 inline bool SceneOpenGL::hasPendingFlush() const
@@ -31,6 +31,7 @@
 #include <KDecoration2/Decoration>
 
 #include <cmath>
+#include <cstring>
 
 namespace KWin
 {
@@ -55,6 +56,10 @@ SceneQPainter::SceneQPainter(QPainterBackend *backend, QObject *parent)
     , m_backend(backend)
     , m_painter(new QPainter())
 {
+    if (qEnvironmentVariableIntValue("KWIN_QPAINTER_TILED") != 0) {
+        // the scene is recorded on the main thread and rasterized on the global thread pool
+        m_recorder.reset(new PaintRecorder);
+    }
 }
 
 SceneQPainter::~SceneQPainter()
@@ -99,13 +104,23 @@ qint64 SceneQPainter::paint(const QRegion &_damage, const QList<Toplevel *> &top
         QRegion overallUpdate;
         for (int i = 0; i < screens()->count(); ++i) {
             const QRect geometry = screens()->geometry(i);
+            if (!_damage.intersects(geometry) && !windowRepaints().intersects(geometry) && !needsFullRepaint) {
+                // Nothing changed on this output, or it still waits for a page flip.
+                continue;
+            }
             QImage *buffer = m_backend->bufferForScreen(i);
             if (!buffer || buffer->isNull()) {
                 continue;
             }
-            m_painter->begin(buffer);
+            if (m_recorder) {
+                m_recorder->setTarget(buffer);
+                m_painter->begin(m_recorder.data());
+            } else {
+                m_painter->begin(buffer);
+            }
             m_painter->save();
             m_painter->setWindow(geometry);
+            const QTransform toBuffer = m_painter->combinedTransform();
 
             QRegion updateRegion, validRegion;
             paintScreen(&mask, damage.intersected(geometry), QRegion(), &updateRegion, &validRegion);
@@ -114,8 +129,14 @@ qint64 SceneQPainter::paint(const QRegion &_damage, const QList<Toplevel *> &top
 
             m_painter->restore();
             m_painter->end();
+
+            if (m_recorder) {
+                m_recorder->replay(toBuffer.map((updateRegion | damage).intersected(geometry)));
+            }
         }
         m_backend->showOverlay();
+        // presenting may block until the next vblank, that's not part of the render time
+        setCpuRenderTime(renderTimer.nsecsElapsed());
         m_backend->present(mask, overallUpdate);
     } else {
         m_painter->begin(m_backend->buffer());
@@ -132,6 +153,7 @@ qint64 SceneQPainter::paint(const QRegion &_damage, const QList<Toplevel *> &top
         m_backend->showOverlay();
 
         m_painter->end();
+        setCpuRenderTime(renderTimer.nsecsElapsed());
         m_backend->present(mask, updateRegion);
     }
 
@@ -424,10 +446,33 @@ void QPainterWindowPixmap::update()
     if (b == oldBuffer) {
         return;
     }
-    // perform deep copy
-    m_image = b->data().copy();
-    if (auto s = surface()) {
-        s->resetTrackedDamage();
+    auto s = surface();
+    updateImage(b->data(), s->mapToBuffer(s->trackedDamage()));
+    s->resetTrackedDamage();
+}
+
+void QPainterWindowPixmap::updateImage(const QImage &data, const QRegion &damage)
+{
+    if (data.isNull() || m_image.size() != data.size() || m_image.format() != data.format()) {
+        // perform deep copy
+        m_image = data.copy();
+        return;
+    }
+    // The image mirrors the previously committed buffer, so only the parts
+    // the client damaged since then have to be copied over. The shm data itself
+    // cannot be referenced as only one shm buffer can be accessed at a time.
+    const int bytesPerPixel = data.depth() / 8;
+    const int sourceStride = data.bytesPerLine();
+    const int destinationStride = m_image.bytesPerLine();
+    const uchar *source = data.constBits();
+    uchar *destination = m_image.bits();
+    for (const QRect &rect : damage & data.rect()) {
+        const int offset = rect.x() * bytesPerPixel;
+        const int length = rect.width() * bytesPerPixel;
+        for (int y = rect.top(); y <= rect.bottom(); ++y) {
+            std::memcpy(destination + y * destinationStride + offset,
+                        source + y * sourceStride + offset, length);
+        }
     }
 }
 
@@ -10,6 +10,7 @@
 #define KWIN_SCENE_QPAINTER_H
 
 #include "scene.h"
+#include "paintrecorder.h"
 #include <platformsupport/scenes/qpainter/backend.h>
 #include "shadow.h"
 
@@ -57,6 +58,10 @@ private:
     explicit SceneQPainter(QPainterBackend *backend, QObject *parent = nullptr);
     QScopedPointer<QPainterBackend> m_backend;
     QScopedPointer<QPainter> m_painter;
+    /**
+     * Set if the screens are rendered tile-parallel, see KWIN_QPAINTER_TILED.
+     */
+    QScopedPointer<PaintRecorder> m_recorder;
     class Window;
 };
 
@@ -75,6 +80,7 @@ protected:
     WindowPixmap *createChild(const QPointer<KWaylandServer::SubSurfaceInterface> &subSurface) override;
 private:
     explicit QPainterWindowPixmap(const QPointer<KWaylandServer::SubSurfaceInterface> &subSurface, WindowPixmap *parent);
+    void updateImage(const QImage &data, const QRegion &damage);
     QImage m_image;
 };
 
@@ -251,6 +251,8 @@ qint64 SceneXrender::paint(const QRegion &damage, const QList<Toplevel *> &tople
 
     m_backend->showOverlay();
 
+    // presenting may block until the next vblank, that's not part of the render time
+    setCpuRenderTime(renderTimer.nsecsElapsed());
     m_backend->present(mask, updateRegion);
     // do cleanup
     clearStackingOrder();
@@ -0,0 +1,86 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2020 KWin developers <kwin@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "rendertimepredictor.h"
+
+namespace KWin
+{
+
+// Render times vary from frame to frame, e.g. because of a cache miss in the texture upload
+// or the driver flushing its command stream. Keep some headroom above the slowest recent
+// frame instead of aiming exactly at it.
+static const qint64 s_safetyMargin = 1000 * 1000; // 1ms
+
+const int RenderTimePredictor::s_historySize;
+
+RenderTimePredictor::RenderTimePredictor(qint64 fallbackTime)
+    : m_fallbackTime(fallbackTime)
+{
+}
+
+void RenderTimePredictor::addSample(qint64 cpuTime, qint64 gpuTime)
+{
+    m_lastCpuTime = qMax<qint64>(cpuTime, 0);
+    m_lastGpuTime = qMax<qint64>(gpuTime, 0);
+
+    // The GPU starts executing the commands while the CPU is still recording the frame,
+    // so the two times overlap and the slower of them bounds the frame.
+    m_samples[m_head] = qMax(m_lastCpuTime, m_lastGpuTime);
+    m_head = (m_head + 1) % s_historySize;
+    m_count = qMin(m_count + 1, s_historySize);
+}
+
+void RenderTimePredictor::reset()
+{
+    m_head = 0;
+    m_count = 0;
+    m_lastCpuTime = 0;
+    m_lastGpuTime = 0;
+}
+
+qint64 RenderTimePredictor::predict() const
+{
+    if (!m_count) {
+        return m_fallbackTime;
+    }
+    // A single slow frame shouldn't be forgotten too soon, a missed vblank is far more
+    // noticeable than a slightly increased latency. So we take the slowest recent frame.
+    qint64 slowest = 0;
+    for (int i = 0; i < m_count; ++i) {
+        slowest = qMax(slowest, m_samples[i]);
+    }
+    return slowest + s_safetyMargin;
+}
+
+void RenderTimePredictor::setFallbackTime(qint64 time)
+{
+    m_fallbackTime = time;
+}
+
+qint64 RenderTimePredictor::fallbackTime() const
+{
+    return m_fallbackTime;
+}
+
+qint64 RenderTimePredictor::lastCpuTime() const
+{
+    return m_lastCpuTime;
+}
+
+qint64 RenderTimePredictor::lastGpuTime() const
+{
+    return m_lastGpuTime;
+}
+
+int RenderTimePredictor::sampleCount() const
+{
+    return m_count;
+}
+
+} // namespace KWin
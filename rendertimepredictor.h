@@ -0,0 +1,82 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2020 KWin developers <kwin@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <kwin_export.h>
+
+#include <QtGlobal>
+
+namespace KWin
+{
+
+/**
+ * The RenderTimePredictor class estimates how long it will take to render the next frame.
+ *
+ * The estimation is based on the CPU and GPU time spent on the most recent frames. The
+ * compositor uses it to start compositing as late as possible, yet early enough so the
+ * frame is ready before the next vblank.
+ *
+ * All times are in nanoseconds.
+ */
+class KWIN_EXPORT RenderTimePredictor
+{
+public:
+    explicit RenderTimePredictor(qint64 fallbackTime = 0);
+
+    /**
+     * Records the render time of a frame. @p cpuTime must not include presenting the frame,
+     * which may block until the next vblank. @p gpuTime is 0 if it is unknown.
+     */
+    void addSample(qint64 cpuTime, qint64 gpuTime = 0);
+
+    /**
+     * Discards all recorded samples, e.g. after a mode change.
+     */
+    void reset();
+
+    /**
+     * Returns the predicted render time of the next frame. If no frame has been recorded
+     * yet, the fallback time is returned.
+     */
+    qint64 predict() const;
+
+    /**
+     * Sets the render time that is predicted while no frame has been recorded yet.
+     */
+    void setFallbackTime(qint64 time);
+    qint64 fallbackTime() const;
+
+    /**
+     * Returns the CPU time spent on the last recorded frame.
+     */
+    qint64 lastCpuTime() const;
+
+    /**
+     * Returns the GPU time spent on the last recorded frame.
+     */
+    qint64 lastGpuTime() const;
+
+    /**
+     * Returns the number of frames that are taken into account for the prediction.
+     */
+    int sampleCount() const;
+
+    static const int s_historySize = 32;
+
+private:
+    qint64 m_samples[s_historySize];
+    int m_head = 0;
+    int m_count = 0;
+    qint64 m_fallbackTime;
+    qint64 m_lastCpuTime = 0;
+    qint64 m_lastGpuTime = 0;
+};
+
+} // namespace KWin
@@ -11,7 +11,7 @@
 
 #include <kconfig.h>
 #include <KXMessages>
-#include <QRegExp>
+#include <QRegularExpression>
 #include <QTemporaryFile>
 #include <QFile>
 #include <QFileInfo>
@@ -124,6 +124,7 @@ void Rules::readFromSettings(const RuleSettings *settings)
     READ_MATCH_STRING(windowrole, .toLower().toLatin1());
     READ_MATCH_STRING(title,);
     READ_MATCH_STRING(clientmachine, .toLower().toLatin1());
+    compileRegExps();
     types = NET::WindowTypeMask(settings->types());
     READ_FORCE_RULE(placement,);
     READ_SET_RULE(position);
@@ -318,6 +319,24 @@ QString Rules::getDecoColor(const QString &themeName)
                                   QLatin1String("color-schemes/") + themeName + QLatin1String(".colors"));
 }
 
+static QRegularExpression compileRegExp(Rules::StringMatch match, const QString &pattern)
+{
+    if (match != Rules::RegExpMatch) {
+        return QRegularExpression();
+    }
+    QRegularExpression regExp(pattern);
+    regExp.optimize();
+    return regExp;
+}
+
+void Rules::compileRegExps()
+{
+    wmclassregexp = compileRegExp(wmclassmatch, QString::fromUtf8(wmclass));
+    windowroleregexp = compileRegExp(windowrolematch, QString::fromUtf8(windowrole));
+    titleregexp = compileRegExp(titlematch, title);
+    clientmachineregexp = compileRegExp(clientmachinematch, QString::fromUtf8(clientmachine));
+}
+
 bool Rules::matchType(NET::WindowType match_type) const
 {
     if (types != NET::AllTypesMask) {
@@ -332,10 +351,9 @@ bool Rules::matchType(NET::WindowType match_type) const
 bool Rules::matchWMClass(const QByteArray& match_class, const QByteArray& match_name) const
 {
     if (wmclassmatch != UnimportantMatch) {
-        // TODO optimize?
         QByteArray cwmclass = wmclasscomplete
                               ? match_name + ' ' + match_class : match_class;
-        if (wmclassmatch == RegExpMatch && QRegExp(QString::fromUtf8(wmclass)).indexIn(QString::fromUtf8(cwmclass)) == -1)
+        if (wmclassmatch == RegExpMatch && !wmclassregexp.match(QString::fromUtf8(cwmclass)).hasMatch())
             return false;
         if (wmclassmatch == ExactMatch && wmclass != cwmclass)
             return false;
@@ -348,7 +366,7 @@ bool Rules::matchWMClass(const QByteArray& match_class, const QByteArray& match_
 bool Rules::matchRole(const QByteArray& match_role) const
 {
     if (windowrolematch != UnimportantMatch) {
-        if (windowrolematch == RegExpMatch && QRegExp(QString::fromUtf8(windowrole)).indexIn(QString::fromUtf8(match_role)) == -1)
+        if (windowrolematch == RegExpMatch && !windowroleregexp.match(QString::fromUtf8(match_role)).hasMatch())
             return false;
         if (windowrolematch == ExactMatch && windowrole != match_role)
             return false;
@@ -361,7 +379,7 @@ bool Rules::matchRole(const QByteArray& match_role) const
 bool Rules::matchTitle(const QString& match_title) const
 {
     if (titlematch != UnimportantMatch) {
-        if (titlematch == RegExpMatch && QRegExp(title).indexIn(match_title) == -1)
+        if (titlematch == RegExpMatch && !titleregexp.match(match_title).hasMatch())
             return false;
         if (titlematch == ExactMatch && title != match_title)
             return false;
@@ -379,7 +397,7 @@ bool Rules::matchClientMachine(const QByteArray& match_machine, bool local) cons
                 && matchClientMachine("localhost", true))
             return true;
         if (clientmachinematch == RegExpMatch
-                && QRegExp(QString::fromUtf8(clientmachine)).indexIn(QString::fromUtf8(match_machine)) == -1)
+                && !clientmachineregexp.match(QString::fromUtf8(match_machine)).hasMatch())
             return false;
         if (clientmachinematch == ExactMatch
                 && clientmachine != match_machine)
@@ -394,10 +412,15 @@ bool Rules::matchClientMachine(const QByteArray& match_machine, bool local) cons
 #ifndef KCMRULES
 bool Rules::match(const AbstractClient* c) const
 {
-    if (!matchType(c->windowType(true)))
-        return false;
     if (!matchWMClass(c->resourceClass(), c->resourceName()))
         return false;
+    return matchExceptWMClass(c);
+}
+
+bool Rules::matchExceptWMClass(const AbstractClient* c) const
+{
+    if (!matchType(c->windowType(true)))
+        return false;
     if (!matchRole(c->windowRole().toLower()))
         return false;
     if (!matchClientMachine(c->clientMachine()->hostName(), c->clientMachine()->isLocal()))
@@ -958,29 +981,80 @@ void RuleBook::deleteAll()
 {
     qDeleteAll(m_rules);
     m_rules.clear();
+    invalidateIndex();
+}
+
+void RuleBook::invalidateIndex()
+{
+    m_indexValid = false;
+    m_exactClassRules.clear();
+    m_exactCompleteClassRules.clear();
+    m_unindexedRules.clear();
+    m_candidateRules.clear();
+}
+
+const QVector<Rules *> &RuleBook::candidateRules(const QByteArray &resourceClass, const QByteArray &resourceName)
+{
+    if (!m_indexValid) {
+        for (int i = 0; i < m_rules.count(); ++i) {
+            const Rules *rule = m_rules.at(i);
+            if (rule->wmclassmatch != Rules::ExactMatch) {
+                m_unindexedRules.append(i);
+            } else if (rule->wmclasscomplete) {
+                m_exactCompleteClassRules[rule->wmclass].append(i);
+            } else {
+                m_exactClassRules[rule->wmclass].append(i);
+            }
+        }
+        m_indexValid = true;
+    }
+
+    const QPair<QByteArray, QByteArray> key(resourceClass, resourceName);
+    auto it = m_candidateRules.constFind(key);
+    if (it != m_candidateRules.constEnd()) {
+        return *it;
+    }
+
+    // only the rules with a substring or regexp match have to be checked one by one, and only
+    // once per window class, since the result is cached until the rules change
+    QVector<int> positions = m_exactClassRules.value(resourceClass);
+    positions += m_exactCompleteClassRules.value(resourceName + ' ' + resourceClass);
+    for (int position : qAsConst(m_unindexedRules)) {
+        if (m_rules.at(position)->matchWMClass(resourceClass, resourceName)) {
+            positions.append(position);
+        }
+    }
+    std::sort(positions.begin(), positions.end());
+
+    QVector<Rules *> candidates;
+    candidates.reserve(positions.count());
+    for (int position : qAsConst(positions)) {
+        candidates.append(m_rules.at(position));
+    }
+    return *m_candidateRules.insert(key, candidates);
 }
 
 WindowRules RuleBook::find(const AbstractClient* c, bool ignore_temporary)
 {
     QVector< Rules* > ret;
-    for (QList< Rules* >::Iterator it = m_rules.begin();
-            it != m_rules.end();
-       ) {
-        if (ignore_temporary && (*it)->isTemporary()) {
-            ++it;
+    bool removedTemporary = false;
+    const QVector<Rules *> &candidates = candidateRules(c->resourceClass(), c->resourceName());
+    for (Rules *rule : candidates) {
+        if (ignore_temporary && rule->isTemporary()) {
             continue;
         }
-        if ((*it)->match(c)) {
-            Rules* rule = *it;
+        // the candidates are known to match the window class already
+        if (rule->matchExceptWMClass(c)) {
             qCDebug(KWIN_CORE) << "Rule found:" << rule << ":" << c;
-            if (rule->isTemporary())
-                it = m_rules.erase(it);
-            else
-                ++it;
+            if (rule->isTemporary()) {
+                m_rules.removeOne(rule);
+                removedTemporary = true;
+            }
             ret.append(rule);
-            continue;
         }
-        ++it;
+    }
+    if (removedTemporary) {
+        invalidateIndex();
     }
     return WindowRules(ret);
 }
@@ -1016,6 +1090,7 @@ void RuleBook::load()
         m_config->reparseConfiguration();
     }
     m_rules = RuleBookSettings(m_config).rules().toList();
+    invalidateIndex();
 }
 
 void RuleBook::save()
@@ -1046,6 +1121,7 @@ void RuleBook::temporaryRulesMessage(const QString& message)
             was_temporary = true;
     Rules* rule = new Rules(message, true);
     m_rules.prepend(rule);   // highest priority first
+    invalidateIndex();
     if (!was_temporary)
         QTimer::singleShot(60000, this, SLOT(cleanupTemporaryRules()));
 }
@@ -1058,6 +1134,7 @@ void RuleBook::cleanupTemporaryRules()
        ) {
         if ((*it)->discardTemporary(false)) { // deletes (*it)
             it = m_rules.erase(it);
+            invalidateIndex();
         } else {
             if ((*it)->isTemporary())
                 has_temporary = true;
@@ -1083,6 +1160,7 @@ void RuleBook::discardUsed(AbstractClient* c, bool withdrawn)
                 Rules* r = *it;
                 it = m_rules.erase(it);
                 delete r;
+                invalidateIndex();
                 continue;
             }
         }
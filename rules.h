@@ -12,7 +12,9 @@
 
 
 #include <netwm_def.h>
+#include <QHash>
 #include <QRect>
+#include <QRegularExpression>
 #include <QVector>
 
 #include "placement.h"
@@ -181,9 +183,12 @@ private:
     bool matchTitle(const QString& match_title) const;
     bool matchClientMachine(const QByteArray& match_machine, bool local) const;
     void readFromSettings(const RuleSettings *settings);
+    void compileRegExps();
     static ForceRule convertForceRule(int v);
     static QString getDecoColor(const QString &themeName);
 #ifndef KCMRULES
+    // match() without the window class, for rules already known to match it
+    bool matchExceptWMClass(const AbstractClient* c) const;
     static bool checkSetRule(SetRule rule, bool init);
     static bool checkForceRule(ForceRule rule);
     static bool checkSetStop(SetRule rule);
@@ -200,6 +205,11 @@ private:
     StringMatch titlematch;
     QByteArray clientmachine;
     StringMatch clientmachinematch;
+    // compiled once for the RegExpMatch matchers
+    QRegularExpression wmclassregexp;
+    QRegularExpression windowroleregexp;
+    QRegularExpression titleregexp;
+    QRegularExpression clientmachineregexp;
     NET::WindowTypes types; // types for matching
     Placement::Policy placement;
     ForceRule placementrule;
@@ -274,6 +284,9 @@ private:
     QString desktopfile;
     SetRule desktopfilerule;
     friend QDebug& operator<<(QDebug& stream, const Rules*);
+#ifndef KCMRULES
+    friend class RuleBook;
+#endif
 };
 
 #ifndef KCMRULES
@@ -303,9 +316,19 @@ private:
     void deleteAll();
     void initializeX11();
     void cleanupX11();
+    void invalidateIndex();
+    const QVector<Rules *> &candidateRules(const QByteArray &resourceClass, const QByteArray &resourceName);
     QTimer *m_updateTimer;
     bool m_updatesDisabled;
     QList<Rules*> m_rules;
+    // positions in m_rules of the rules with an exact wmclass match, by wmclass
+    QHash<QByteArray, QVector<int>> m_exactClassRules;
+    QHash<QByteArray, QVector<int>> m_exactCompleteClassRules;
+    // positions in m_rules of all other rules
+    QVector<int> m_unindexedRules;
+    // the rules whose wmclass matches, by resource class and name, in m_rules order
+    QHash<QPair<QByteArray, QByteArray>, QVector<Rules *>> m_candidateRules;
+    bool m_indexValid = false;
     QScopedPointer<KXMessages> m_temporaryRulesMessages;
     KSharedConfig::Ptr m_config;
 
@@ -153,6 +153,31 @@ void Scene::paintScreen(int* mask, const QRegion &damage, const QRegion &repaint
     Q_ASSERT(!PaintClipper::clip());
 }
 
+qint64 Scene::cpuRenderTime() const
+{
+    return m_cpuRenderTime;
+}
+
+void Scene::setCpuRenderTime(qint64 time)
+{
+    m_cpuRenderTime = time;
+}
+
+qint64 Scene::gpuRenderTime() const
+{
+    return 0;
+}
+
+int Scene::drawCallCount() const
+{
+    return 0;
+}
+
+int Scene::occludedWindowCount() const
+{
+    return m_occludedWindowCount;
+}
+
 // Compute time since the last painting pass.
 void Scene::updateTimeDiff()
 {
@@ -243,6 +268,32 @@ void Scene::paintGenericScreen(int orig_mask, const ScreenPaintData &)
     }
 }
 
+// The part of the window which hides everything below it, if it's painted untransformed
+// and the effects don't make it translucent.
+static QRegion opaqueRegion(Scene::Window *window)
+{
+    Toplevel *toplevel = window->window();
+    const WindowPixmap *windowPixmap = window->windowPixmap<WindowPixmap>();
+    QRegion clip;
+    if (window->isOpaque()) {
+        // Clip out the decoration for opaque windows; the decoration is drawn in the second pass
+        AbstractClient *client = dynamic_cast<AbstractClient *>(toplevel);
+        if (!(client && client->decorationHasAlpha())) {
+            clip = window->decorationShape().translated(window->pos());
+        }
+        if (windowPixmap) {
+            clip |= windowPixmap->mapToGlobal(windowPixmap->shape());
+        }
+    } else if (toplevel->hasAlpha() && toplevel->opacity() == 1.0) {
+        if (windowPixmap) {
+            const QRegion shape = windowPixmap->mapToGlobal(windowPixmap->shape());
+            const QRegion opaque = windowPixmap->mapToGlobal(windowPixmap->opaque());
+            clip = shape & opaque;
+        }
+    }
+    return clip;
+}
+
 // The optimized case without any transformations at all.
 // It can paint only the requested region and can use clipping
 // to reduce painting and improve performance.
@@ -256,48 +307,67 @@ void Scene::paintSimpleScreen(int orig_mask, const QRegion &region)
     QRegion dirtyArea = region;
     bool opaqueFullscreen = false;
 
+    // This is the occlusion pass. Traverse the scene windows from top to bottom and
+    // collect the areas covered by opaque windows, so windows which are completely
+    // hidden below them can be skipped before quads are built and effects see them.
+    // Windows which an effect takes part in painting neither hide other windows nor
+    // get skipped, the effect might make them translucent or rely on seeing them.
+    // Effects which merely pre-paint all windows (Effect::prePaintsAllWindows()) don't
+    // count, a hidden window adds nothing they could see.
+    EffectsHandlerImpl *effectsImpl = static_cast<EffectsHandlerImpl *>(effects);
+    QVector<QRegion> clips(stacking_order.count());
+    QVector<bool> occluded(stacking_order.count(), false);
+    QRegion occluder;
+    m_occludedWindowCount = 0;
+    for (int i = stacking_order.count() - 1; i >= 0; --i) {
+        Window *window = stacking_order[i];
+        window->resetPaintingEnabled();
+
+        // Let the scene window update the window pixmap tree.
+        window->preprocess();
+
+        clips[i] = opaqueRegion(window);
+        if (!window->isPaintingEnabled() || effectsImpl->hasEffectsForWindow(effectWindow(window))) {
+            continue;
+        }
+        // sub-surfaces may stick out of the visible rect
+        const WindowPixmap *windowPixmap = window->windowPixmap<WindowPixmap>();
+        if (windowPixmap && windowPixmap->children().isEmpty()) {
+            occluded[i] = (QRegion(window->window()->visibleRect()) - occluder).isEmpty();
+            if (occluded[i]) {
+                ++m_occludedWindowCount;
+            }
+        }
+        occluder |= clips[i];
+    }
+
     // Traverse the scene windows from bottom to top.
     for (int i = 0; i < stacking_order.count(); ++i) {
         Window *window = stacking_order[i];
         Toplevel *toplevel = window->window();
+
+        // Nothing of a hidden window can show up, so its repaints are dropped.
+        if (occluded[i]) {
+            toplevel->resetRepaints();
+            continue;
+        }
+
         WindowPrePaintData data;
         data.mask = orig_mask | (window->isOpaque() ? PAINT_WINDOW_OPAQUE : PAINT_WINDOW_TRANSLUCENT);
-        window->resetPaintingEnabled();
         data.paint = region;
-        data.paint |= toplevel->repaints();
-
-        // Let the scene window update the window pixmap tree.
-        window->preprocess();
+        data.paint |= window->repaints();
 
         // Reset the repaint_region.
         // This has to be done here because many effects schedule a repaint for
         // the next frame within Effects::prePaintWindow.
         toplevel->resetRepaints();
 
-        // Clip out the decoration for opaque windows; the decoration is drawn in the second pass
         opaqueFullscreen = false; // TODO: do we care about unmanged windows here (maybe input windows?)
         if (window->isOpaque()) {
             AbstractClient *client = dynamic_cast<AbstractClient *>(toplevel);
-            if (client) {
-                opaqueFullscreen = client->isFullScreen();
-            }
-            if (!(client && client->decorationHasAlpha())) {
-                data.clip = window->decorationShape().translated(window->pos());
-            }
-            const WindowPixmap *windowPixmap = window->windowPixmap<WindowPixmap>();
-            if (windowPixmap) {
-                data.clip |= windowPixmap->mapToGlobal(windowPixmap->shape());
-            }
-        } else if (toplevel->hasAlpha() && toplevel->opacity() == 1.0) {
-            const WindowPixmap *windowPixmap = window->windowPixmap<WindowPixmap>();
-            if (windowPixmap) {
-                const QRegion shape = windowPixmap->mapToGlobal(windowPixmap->shape());
-                const QRegion opaque = windowPixmap->mapToGlobal(windowPixmap->opaque());
-                data.clip = shape & opaque;
-            }
-        } else {
-            data.clip = QRegion();
+            opaqueFullscreen = client && client->isFullScreen();
         }
+        data.clip = clips[i];
         data.quads = window->buildQuads();
         // preparation step
         effects->prePaintWindow(effectWindow(window), data, time_diff);
@@ -468,13 +538,21 @@ void Scene::createStackingOrder(const QList<Toplevel *> &toplevels)
     // TODO: cache the stacking_order in case it has not changed
     foreach (Toplevel *c, toplevels) {
         Q_ASSERT(m_windows.contains(c));
-        stacking_order.append(m_windows[ c ]);
+        Window *window = m_windows[ c ];
+        stacking_order.append(window);
+
+        // The toplevel's repaints are reset when the window is painted on the first screen,
+        // remember them for the other screens. They are kept apart from the screen damage,
+        // so effects can tell which window damaged an area.
+        window->setRepaints(c->repaints());
+        m_windowRepaints |= window->repaints();
     }
 }
 
 void Scene::clearStackingOrder()
 {
     stacking_order.clear();
+    m_windowRepaints = QRegion();
 }
 
 static Scene::Window *s_recursionCheck = nullptr;
@@ -866,7 +944,7 @@ bool Scene::Window::isPaintingEnabled() const
 
 void Scene::Window::resetPaintingEnabled()
 {
-    disable_painting = 0;
+    disable_painting &= PAINT_DISABLED_BY_OVERLAY;
     if (toplevel->isDeleted())
         disable_painting |= PAINT_DISABLED_BY_DELETE;
     if (static_cast<EffectsHandlerImpl*>(effects)->isDesktopRendering()) {
@@ -1092,6 +1170,16 @@ void Scene::Window::preprocess()
     }
 }
 
+QRegion Scene::Window::repaints() const
+{
+    return m_repaints;
+}
+
+void Scene::Window::setRepaints(const QRegion &region)
+{
+    m_repaints = region;
+}
+
 //****************************************
 // WindowPixmap
 //****************************************
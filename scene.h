@@ -66,6 +66,34 @@ public:
     // ie. "what of this frame is lost to painting"
     virtual qint64 paint(const QRegion &damage, const QList<Toplevel *> &windows) = 0;
 
+    /**
+     * Returns the time in nanoseconds the CPU spent on rendering the most recently painted
+     * frame, without presenting it.
+     */
+    qint64 cpuRenderTime() const;
+
+    /**
+     * Returns the time in nanoseconds the GPU needed to execute the rendering commands
+     * of the most recent frame whose timing information is available.
+     *
+     * Default implementation returns 0, i.e. the GPU time is unknown.
+     */
+    virtual qint64 gpuRenderTime() const;
+
+    /**
+     * Returns the number of draw calls the scene issued for the windows of the most
+     * recently painted frame.
+     *
+     * Default implementation returns 0, i.e. the number is unknown.
+     */
+    virtual int drawCallCount() const;
+
+    /**
+     * Returns the number of windows which were skipped in the most recently painted frame,
+     * because they were completely hidden below opaque windows.
+     */
+    int occludedWindowCount() const;
+
     /**
      * Adds the Toplevel to the Scene.
      *
@@ -202,6 +230,16 @@ protected:
     virtual Window *createWindow(Toplevel *toplevel) = 0;
     void createStackingOrder(const QList<Toplevel *> &toplevels);
     void clearStackingOrder();
+    // windows in their stacking order, bottom to top
+    const QVector<Window *> &stackingOrder() const {
+        return stacking_order;
+    }
+    // the repaints of all windows in the stacking order, see Window::repaints()
+    const QRegion &windowRepaints() const {
+        return m_windowRepaints;
+    }
+    // to be called by paint() before the frame gets presented, see cpuRenderTime()
+    void setCpuRenderTime(qint64 time);
     // shared implementation, starts painting the screen
     void paintScreen(int *mask, const QRegion &damage, const QRegion &repaint,
                      QRegion *updateRegion, QRegion *validRegion, const QMatrix4x4 &projection = QMatrix4x4(), const QRect &outputGeometry = QRect(), const qreal screenScale = 1.0);
@@ -266,6 +304,9 @@ private:
     QHash< Toplevel*, Window* > m_windows;
     // windows in their stacking order
     QVector< Window* > stacking_order;
+    QRegion m_windowRepaints;
+    qint64 m_cpuRenderTime = 0;
+    int m_occludedWindowCount = 0;
     // how many times finalPaintScreen() has been called
     int m_paintScreenCount = 0;
 };
@@ -326,7 +367,10 @@ public:
         // Window will not be painted because it is minimized
         PAINT_DISABLED_BY_MINIMIZE     = 1 << 3,
         // Window will not be painted because it's not on the current activity
-        PAINT_DISABLED_BY_ACTIVITY     = 1 << 5
+        PAINT_DISABLED_BY_ACTIVITY     = 1 << 5,
+        // Window will not be painted because it is shown on a hardware overlay plane,
+        // set and cleared by the scene around painting a screen
+        PAINT_DISABLED_BY_OVERLAY      = 1 << 6
     };
     void enablePainting(int reason);
     void disablePainting(int reason);
@@ -352,6 +396,10 @@ public:
     void unreferencePreviousPixmap();
     void discardQuads();
     void preprocess();
+    // the repaints of the window when painting the frame started, in global coordinates;
+    // unlike the repaints of the toplevel they are kept until all screens are painted
+    QRegion repaints() const;
+    void setRepaints(const QRegion &region);
 
     virtual QSharedPointer<GLTexture> windowTexture() {
         return {};
@@ -393,6 +441,7 @@ private:
     QScopedPointer<WindowPixmap> m_previousPixmap;
     int m_referencePixmapCounter;
     int disable_painting;
+    QRegion m_repaints;
     mutable QRegion m_bufferShape;
     mutable bool m_bufferShapeIsValid = false;
     mutable QScopedPointer<WindowQuadList> cached_quad_list;
@@ -7,14 +7,17 @@
 */
 
 #include "pipewirestream.h"
+#include "composite.h"
 #include "cursor.h"
 #include "dmabuftexture.h"
+#include "kwinglplatform.h"
 #include "kwingltexture.h"
 #include "kwinglutils.h"
 #include "kwinscreencast_logging.h"
 #include "main.h"
 #include "pipewirecore.h"
 #include "platform.h"
+#include "scene.h"
 #include "utils.h"
 
 #include <KLocalizedString>
@@ -24,6 +27,8 @@
 
 #include <spa/buffer/meta.h>
 
+#include <cstring>
+
 #include <fcntl.h>
 #include <sys/mman.h>
 #include <unistd.h>
@@ -31,6 +36,26 @@
 namespace KWin
 {
 
+// Number of frames which can be read back from the GPU at the same time
+static const int s_readbackCount = 3;
+// Time in nanoseconds to wait for a readback when all pixel buffers are in use
+static const GLuint64 s_readbackTimeout = 1000000000;
+
+static int frameStride(const QSize &size, int bytesPerPixel)
+{
+    return SPA_ROUND_UP_N(size.width() * bytesPerPixel, 4);
+}
+
+static void copyRegion(uint8_t *dest, const uint8_t *src, int stride, int bytesPerPixel, const QRegion &region)
+{
+    for (const QRect &rect : region) {
+        for (int y = rect.top(); y <= rect.bottom(); ++y) {
+            const int offset = y * stride + rect.x() * bytesPerPixel;
+            memcpy(dest + offset, src + offset, rect.width() * bytesPerPixel);
+        }
+    }
+}
+
 void PipeWireStream::onStreamStateChanged(void *data, pw_stream_state old, pw_stream_state state, const char *error_message)
 {
     PipeWireStream *pw = static_cast<PipeWireStream*>(data);
@@ -85,9 +110,15 @@ void PipeWireStream::newStreamParams()
         (spa_pod*) spa_pod_builder_add_object (&pod_builder,
                                                SPA_TYPE_OBJECT_ParamMeta, SPA_PARAM_Meta,
                                                SPA_PARAM_META_type, SPA_POD_Id (SPA_META_Cursor),
-                                               SPA_PARAM_META_size, SPA_POD_Int (CURSOR_META_SIZE (cursorSize, cursorSize)))
+                                               SPA_PARAM_META_size, SPA_POD_Int (CURSOR_META_SIZE (cursorSize, cursorSize))),
+        (spa_pod*) spa_pod_builder_add_object (&pod_builder,
+                                               SPA_TYPE_OBJECT_ParamMeta, SPA_PARAM_Meta,
+                                               SPA_PARAM_META_type, SPA_POD_Id (SPA_META_VideoDamage),
+                                               SPA_PARAM_META_size, SPA_POD_CHOICE_RANGE_Int (sizeof(spa_meta_region) * 16,
+                                                                                              sizeof(spa_meta_region) * 1,
+                                                                                              sizeof(spa_meta_region) * 16))
     };
-    pw_stream_update_params(pwStream, params, 2);
+    pw_stream_update_params(pwStream, params, 3);
 }
 
 void PipeWireStream::onStreamParamChanged(void *data, uint32_t id, const struct spa_pod *format)
@@ -164,6 +195,7 @@ void PipeWireStream::onStreamRemoveBuffer(void *data, pw_buffer *buffer)
     if (spa_data->type == SPA_DATA_DmaBuf) {
         stream->m_dmabufDataForPwBuffer.remove(buffer);
     } else if (spa_data->type == SPA_DATA_MemFd) {
+        stream->m_bufferDamage.remove(buffer);
         munmap (spa_data->data, spa_data->maxsize);
         close (spa_data->fd);
     }
@@ -179,11 +211,20 @@ PipeWireStream::PipeWireStream(bool hasAlpha, const QSize &resolution, QObject *
     pwStreamEvents.remove_buffer = &PipeWireStream::onStreamRemoveBuffer;
     pwStreamEvents.state_changed = &PipeWireStream::onStreamStateChanged;
     pwStreamEvents.param_changed = &PipeWireStream::onStreamParamChanged;
+
+    m_readbacks.resize(s_readbackCount);
+    m_readbackTimer.setSingleShot(true);
+    m_readbackTimer.setInterval(1);
+    connect(&m_readbackTimer, &QTimer::timeout, this, &PipeWireStream::finishReadbacks);
 }
 
 PipeWireStream::~PipeWireStream()
 {
     m_stopped = true;
+    Scene *scene = Compositor::self() ? Compositor::self()->scene() : nullptr;
+    if (scene && scene->makeOpenGLContextCurrent()) {
+        releaseReadbacks();
+    }
     if (pwStream) {
         pw_stream_destroy(pwStream);
     }
@@ -300,6 +341,7 @@ void PipeWireStream::recordFrame(GLTexture *frameTexture, const QRegion &damaged
 
     if (frameTexture->size() != m_resolution) {
         m_resolution = frameTexture->size();
+        releaseReadbacks();
         newStreamParams();
         return;
     }
@@ -313,6 +355,10 @@ void PipeWireStream::recordFrame(GLTexture *frameTexture, const QRegion &damaged
         return;
     }
 
+    if (m_dmabufDataForPwBuffer.isEmpty() && readbackFrame(frameTexture, damagedRegion)) {
+        return;
+    }
+
     struct pw_buffer *buffer = pw_stream_dequeue_buffer(pwStream);
 
     if (!buffer) {
@@ -412,6 +458,238 @@ void PipeWireStream::recordFrame(GLTexture *frameTexture, const QRegion &damaged
     pw_stream_queue_buffer(pwStream, buffer);
 }
 
+bool PipeWireStream::readbackFrame(GLTexture *frameTexture, const QRegion &damagedRegion)
+{
+    // glGetTextureSubImage is needed to read back only the damaged areas
+    if (GLPlatform::instance()->isGLES() ||
+            !(hasGLVersion(4, 5) || (hasGLVersion(3, 2) && hasGLExtension(QByteArrayLiteral("GL_ARB_get_texture_sub_image"))))) {
+        return false;
+    }
+
+    if (m_readbacks[m_nextReadback].fence) {
+        // all pixel buffers are in use, the oldest frame has to be delivered first
+        finishReadback(m_nextReadback, true);
+    }
+    Readback &readback = m_readbacks[m_nextReadback];
+
+    const QSize size = frameTexture->size();
+    const int bpp = m_hasAlpha ? 4 : 3;
+    const int stride = frameStride(size, bpp);
+    const int frameSize = stride * size.height();
+
+    QRegion region = damagedRegion & QRect(QPoint(), size);
+    if (m_frame.size() != frameSize) {
+        // nothing has been read back yet, all buffers need to be filled completely
+        m_frame = QByteArray(frameSize, 0);
+        m_bufferDamage.clear();
+        region = QRect(QPoint(), size);
+    }
+
+    if (!readback.buffer) {
+        glGenBuffers(1, &readback.buffer);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+    if (readback.bufferSize != frameSize) {
+        glBufferData(GL_PIXEL_PACK_BUFFER, frameSize, nullptr, GL_STREAM_READ);
+        readback.bufferSize = frameSize;
+    }
+
+    // the pixel buffer has the same layout as the memfd buffers
+    glPixelStorei(GL_PACK_ROW_LENGTH, size.width());
+    for (const QRect &rect : region) {
+        const int offset = rect.y() * stride + rect.x() * bpp;
+        glGetTextureSubImage(frameTexture->texture(), 0, rect.x(), rect.y(), 0, rect.width(), rect.height(), 1,
+                             m_hasAlpha ? GL_BGRA : GL_BGR, GL_UNSIGNED_BYTE, frameSize - offset,
+                             reinterpret_cast<void *>(intptr_t(offset)));
+    }
+    glPixelStorei(GL_PACK_ROW_LENGTH, 0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    readback.damage = region;
+    m_nextReadback = (m_nextReadback + 1) % m_readbacks.count();
+
+    m_readbackTimer.start();
+    return true;
+}
+
+bool PipeWireStream::finishReadback(int slot, bool wait)
+{
+    Readback &readback = m_readbacks[slot];
+    const GLenum status = glClientWaitSync(readback.fence, GL_SYNC_FLUSH_COMMANDS_BIT, wait ? s_readbackTimeout : 0);
+    if (status == GL_TIMEOUT_EXPIRED && !wait) {
+        return false;
+    }
+    glDeleteSync(readback.fence);
+    readback.fence = nullptr;
+
+    if (status == GL_TIMEOUT_EXPIRED || status == GL_WAIT_FAILED) {
+        qCWarning(KWIN_SCREENCAST) << "Failed to read back frame, dropping it";
+        discardFrame();
+        return true;
+    }
+
+    if (m_frame.size() != readback.bufferSize) {
+        // the frame size has changed in the meantime
+        return true;
+    }
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+    const auto pixels = static_cast<const uint8_t *>(glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, readback.bufferSize, GL_MAP_READ_BIT));
+    if (pixels) {
+        const int bpp = m_hasAlpha ? 4 : 3;
+        copyRegion(reinterpret_cast<uint8_t *>(m_frame.data()), pixels, frameStride(m_resolution, bpp), bpp, readback.damage);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    if (!pixels) {
+        discardFrame();
+    }
+
+    if (pixels) {
+        deliverFrame(readback.damage);
+    }
+    return true;
+}
+
+void PipeWireStream::finishReadbacks()
+{
+    Scene *scene = Compositor::self()->scene();
+    if (!scene || !scene->makeOpenGLContextCurrent()) {
+        return;
+    }
+    // deliver the frames in the order they have been recorded, the oldest one is the next slot
+    for (int i = 0; i < m_readbacks.count(); ++i) {
+        const int slot = (m_nextReadback + i) % m_readbacks.count();
+        if (!m_readbacks[slot].fence) {
+            continue;
+        }
+        if (!finishReadback(slot, false)) {
+            m_readbackTimer.start();
+            return;
+        }
+    }
+}
+
+void PipeWireStream::discardFrame()
+{
+    // The damaged area is lost, the next frame is read back completely. The readbacks still
+    // in flight only hold the damage of their own frame, they must not end up on top of it.
+    for (Readback &readback : m_readbacks) {
+        if (readback.fence) {
+            glDeleteSync(readback.fence);
+            readback.fence = nullptr;
+        }
+    }
+    m_frame.clear();
+}
+
+void PipeWireStream::releaseReadbacks()
+{
+    m_readbackTimer.stop();
+    for (Readback &readback : m_readbacks) {
+        if (readback.fence) {
+            glDeleteSync(readback.fence);
+        }
+        if (readback.buffer) {
+            glDeleteBuffers(1, &readback.buffer);
+        }
+        readback = Readback();
+    }
+    m_nextReadback = 0;
+    m_frame.clear();
+}
+
+void PipeWireStream::deliverFrame(const QRegion &damagedRegion)
+{
+    for (QRegion &bufferDamage : m_bufferDamage) {
+        bufferDamage |= damagedRegion;
+    }
+    // consumers are told what changed since the last buffer they got, which might
+    // be several frames ago if they are slow or the stream was paused
+    m_pendingDamage |= damagedRegion;
+
+    if (m_stopped || pw_stream_get_state(pwStream, nullptr) != PW_STREAM_STATE_STREAMING) {
+        return;
+    }
+
+    struct pw_buffer *buffer = pw_stream_dequeue_buffer(pwStream);
+    if (!buffer) {
+        return;
+    }
+
+    struct spa_buffer *spa_buffer = buffer->buffer;
+    struct spa_data *spa_data = spa_buffer->datas;
+    uint8_t *data = (uint8_t *) spa_data->data;
+
+    const int bpp = m_hasAlpha ? 4 : 3;
+    const int stride = frameStride(m_resolution, bpp);
+    const int bufferSize = stride * m_resolution.height();
+    if (!data || bufferSize != m_frame.size() || uint(bufferSize) > spa_data->maxsize) {
+        qCWarning(KWIN_SCREENCAST) << "Failed to record frame: invalid buffer data";
+        pw_stream_queue_buffer(pwStream, buffer);
+        return;
+    }
+
+    // only the areas which changed since the buffer has been used last time need to be copied
+    const QRect frame(QPoint(), m_resolution);
+    auto it = m_bufferDamage.constFind(buffer);
+    copyRegion(data, reinterpret_cast<const uint8_t *>(m_frame.constData()), stride, bpp,
+               it != m_bufferDamage.constEnd() ? *it : QRegion(frame));
+
+    spa_data->chunk->offset = 0;
+    spa_data->chunk->size = bufferSize;
+    spa_data->chunk->stride = stride;
+
+    QRect cursorRect;
+    auto cursor = Cursors::self()->currentCursor();
+    if (m_cursor.mode == KWaylandServer::ScreencastV1Interface::Embedded && m_cursor.viewport.contains(cursor->pos())) {
+        QImage dest(data, m_resolution.width(), m_resolution.height(), stride, QImage::Format_RGBA8888_Premultiplied);
+        QPainter painter(&dest);
+        const auto position = (cursor->pos() - m_cursor.viewport.topLeft() - cursor->hotspot()) * m_cursor.scale;
+        painter.drawImage(QRect{position, cursor->image().size()}, cursor->image());
+        cursorRect = QRect(position, cursor->image().size()) & frame;
+    }
+    // the cursor has to be removed from the buffer next time
+    m_bufferDamage[buffer] = cursorRect;
+
+    addVideoDamage(spa_buffer, (m_pendingDamage & frame) | m_cursor.lastRect | cursorRect);
+    m_pendingDamage = QRegion();
+    m_cursor.lastRect = cursorRect;
+
+    if (m_cursor.mode == KWaylandServer::ScreencastV1Interface::Metadata) {
+        sendCursorData(cursor, (spa_meta_cursor *) spa_buffer_find_meta_data (spa_buffer, SPA_META_Cursor, sizeof (spa_meta_cursor)));
+    }
+
+    pw_stream_queue_buffer(pwStream, buffer);
+}
+
+void PipeWireStream::addVideoDamage(spa_buffer *spaBuffer, const QRegion &damagedRegion)
+{
+    spa_meta *damage = spa_buffer_find_meta(spaBuffer, SPA_META_VideoDamage);
+    if (!damage) {
+        return;
+    }
+    const int maxRects = damage->size / sizeof(spa_meta_region);
+    if (maxRects == 0) {
+        return;
+    }
+    spa_meta_region *regions = static_cast<spa_meta_region *>(damage->data);
+
+    QVector<QRect> rects(damagedRegion.begin(), damagedRegion.end());
+    if (rects.count() > maxRects) {
+        rects = {damagedRegion.boundingRect()};
+    }
+    for (int i = 0; i < rects.count(); ++i) {
+        const QRect &rect = rects[i];
+        regions[i].region = SPA_REGION(rect.x(), rect.y(), uint32_t(rect.width()), uint32_t(rect.height()));
+    }
+    // an empty region terminates the list
+    if (rects.count() < maxRects) {
+        regions[rects.count()].region = SPA_REGION(0, 0, 0, 0);
+    }
+}
+
 QRect PipeWireStream::cursorGeometry(Cursor *cursor) const
 {
     const auto position = (cursor->pos() - m_cursor.viewport.topLeft() - cursor->hotspot()) * m_cursor.scale;
@@ -17,6 +17,10 @@
 #include <QObject>
 #include <QSharedPointer>
 #include <QSize>
+#include <QTimer>
+#include <QVector>
+
+#include <epoxy/gl.h>
 
 #include <pipewire/pipewire.h>
 #include <spa/param/format-utils.h>
@@ -69,6 +73,14 @@ private:
     void sendCursorData(Cursor *cursor, spa_meta_cursor *spa_cursor);
     void newStreamParams();
 
+    bool readbackFrame(GLTexture *frameTexture, const QRegion &damagedRegion);
+    bool finishReadback(int slot, bool wait);
+    void finishReadbacks();
+    void discardFrame();
+    void releaseReadbacks();
+    void deliverFrame(const QRegion &damagedRegion);
+    void addVideoDamage(spa_buffer *spaBuffer, const QRegion &damagedRegion);
+
     QSharedPointer<PipeWireCore> pwCore;
     struct pw_stream *pwStream = nullptr;
     spa_hook streamListener;
@@ -96,6 +108,25 @@ private:
     QRect cursorGeometry(Cursor *cursor) const;
 
     QHash<struct pw_buffer *, QSharedPointer<DmaBufTexture>> m_dmabufDataForPwBuffer;
+
+    /**
+     * A frame which is being read back from the GPU into a pixel buffer object.
+     */
+    struct Readback {
+        GLuint buffer = 0;
+        int bufferSize = 0;
+        GLsync fence = nullptr;
+        QRegion damage;
+    };
+    QVector<Readback> m_readbacks;
+    int m_nextReadback = 0;
+    QTimer m_readbackTimer;
+    // the last frame read back, laid out like the memfd buffers
+    QByteArray m_frame;
+    // the areas in which a memfd buffer differs from m_frame
+    QHash<struct pw_buffer *, QRegion> m_bufferDamage;
+    // the damage of the frames since the last buffer has been queued
+    QRegion m_pendingDamage;
 };
 
 } // namespace KWin
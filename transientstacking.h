@@ -0,0 +1,79 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2020 KWin developers <kwin@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QHash>
+#include <QList>
+
+namespace KWin
+{
+
+/**
+ * Moves every transient in @p stacking directly above the top-most of its main windows,
+ * unless the transient is already stacked above all of them. Transients are visited from
+ * top to bottom; if a moved window has transients of its own, the windows it got moved
+ * past are visited again, so those transients end up above it.
+ *
+ * @p mainWindows returns the windows which can be main windows of the given window, directly
+ * or indirectly. It may return more windows than there actually are, e.g. all ancestors in
+ * the transient tree, as long as @p keepAbove filters out the wrong ones.
+ * @p keepAbove(main, transient) returns whether @p transient has to be kept above @p main.
+ * @p hasTransients returns whether moving the given window can affect its own transients.
+ *
+ * The positions of all windows are indexed, so finding the top-most main window costs
+ * a lookup per candidate rather than a scan of the whole stacking order.
+ */
+template<typename T, typename MainWindows, typename KeepAbove, typename HasTransients>
+void constrainTransientStacking(QList<T *> &stacking, MainWindows mainWindows,
+                                KeepAbove keepAbove, HasTransients hasTransients)
+{
+    QHash<T *, int> positions;
+    positions.reserve(stacking.count());
+    for (int i = 0; i < stacking.count(); ++i) {
+        positions.insert(stacking.at(i), i);
+    }
+
+    for (int i = stacking.count() - 1; i >= 0;) {
+        T *current = stacking.at(i);
+
+        // find the top-most main window which is stacked above the transient
+        int mainIndex = -1;
+        const auto candidates = mainWindows(current);
+        for (T *candidate : candidates) {
+            const int position = positions.value(candidate, -1);
+            if (position > i && position > mainIndex && keepAbove(candidate, current)) {
+                mainIndex = position;
+            }
+        }
+        if (mainIndex == -1) {
+            --i;
+            continue;
+        }
+
+        // move the transient right above its main window, the windows in between move down by one
+        for (int j = i; j < mainIndex; ++j) {
+            T *window = stacking.at(j + 1);
+            stacking[j] = window;
+            positions[window] = j;
+        }
+        stacking[mainIndex] = current;
+        positions[current] = mainIndex;
+
+        if (hasTransients(current)) {
+            // the transient can now be above its own transients, so go on from the main window
+            // and move them again if needed
+            i = mainIndex - 1;
+        } else {
+            --i;
+        }
+    }
+}
+
+} // namespace KWin
@@ -59,6 +59,8 @@
 #include <KStartupInfo>
 // Qt
 #include <QtConcurrentRun>
+// std
+#include <vector>
 
 namespace KWin
 {
@@ -372,18 +374,17 @@ void Workspace::initializeX11()
         Xcb::Tree tree(rootWindow());
         xcb_window_t *wins = xcb_query_tree_children(tree.data());
 
-        QVector<Xcb::WindowAttributes> windowAttributes(tree->children_len);
-        QVector<Xcb::WindowGeometry> windowGeometries(tree->children_len);
-
-        // Request the attributes and geometries of all toplevel windows
+        // Send the requests for all toplevel windows before waiting for the first reply,
+        // so that adopting the windows doesn't cost a round trip per window
+        std::vector<std::unique_ptr<X11ClientRequests>> requests;
+        requests.reserve(tree->children_len);
         for (int i = 0; i < tree->children_len; i++) {
-            windowAttributes[i] = Xcb::WindowAttributes(wins[i]);
-            windowGeometries[i] = Xcb::WindowGeometry(wins[i]);
+            requests.emplace_back(new X11ClientRequests(wins[i]));
         }
 
         // Get the replies
         for (int i = 0; i < tree->children_len; i++) {
-            Xcb::WindowAttributes attr(windowAttributes.at(i));
+            Xcb::WindowAttributes &attr = requests[i]->attributes;
 
             if (attr.isNull()) {
                 continue;
@@ -395,12 +396,12 @@ void Workspace::initializeX11()
                     // ### This will request the attributes again
                     createUnmanaged(wins[i]);
             } else if (attr->map_state != XCB_MAP_STATE_UNMAPPED) {
-                if (Application::wasCrash()) {
-                    fixPositionAfterCrash(wins[i], windowGeometries.at(i).data());
+                if (Application::wasCrash() && fixPositionAfterCrash(wins[i], requests[i]->geometry.data())) {
+                    // The geometry was fetched before the window got moved
+                    requests[i]->geometry = Xcb::WindowGeometry(wins[i]);
                 }
 
-                // ### This will request the attributes again
-                createClient(wins[i], true);
+                createClient(*requests[i], true);
             }
         }
 
@@ -527,6 +528,12 @@ void Workspace::setupClientConnections(AbstractClient *c)
 }
 
 X11Client *Workspace::createClient(xcb_window_t w, bool is_mapped)
+{
+    X11ClientRequests requests(w);
+    return createClient(requests, is_mapped);
+}
+
+X11Client *Workspace::createClient(X11ClientRequests &requests, bool is_mapped)
 {
     StackingUpdatesBlocker blocker(this);
     X11Client *c = nullptr;
@@ -540,7 +547,7 @@ X11Client *Workspace::createClient(xcb_window_t w, bool is_mapped)
         connect(c, &X11Client::blockingCompositingChanged, compositor, &X11Compositor::updateClientCompositeBlocking);
     }
     connect(c, SIGNAL(clientFullScreenSet(KWin::X11Client *,bool,bool)), ScreenEdges::self(), SIGNAL(checkBlocking()));
-    if (!c->manage(w, is_mapped)) {
+    if (!c->manage(requests, is_mapped)) {
         X11Client::deleteClient(c);
         return nullptr;
     }
@@ -974,6 +981,11 @@ void Workspace::updateClientVisibilityOnDesktopChange(uint newDesktop)
         if (c->isOnDesktop(newDesktop) && c->isOnCurrentActivity())
             c->updateVisibility();
     }
+    // None of the above waits for the X server, so send all the map and unmap requests
+    // in one go before anything else gets queued behind them
+    if (xcb_connection_t *c = connection()) {
+        xcb_flush(c);
+    }
     if (showingDesktop())   // Do this only after desktop change to avoid flicker
         setShowingDesktop(false);
 }
@@ -1615,6 +1627,8 @@ QString Workspace::supportInformation() const
                 support.append(QStringLiteral(" yes\n"));
             else
                 support.append(QStringLiteral(" no\n"));
+            support.append(QStringLiteral("Window draw calls in the last frame: %1\n").arg(m_compositor->scene()->drawCallCount()));
+            support.append(QStringLiteral("Hidden windows skipped in the last frame: %1\n").arg(m_compositor->scene()->occludedWindowCount()));
             break;
         }
         case XRenderCompositing:
@@ -2043,6 +2057,43 @@ QRect Workspace::adjustClientArea(AbstractClient *client, const QRect &area) con
     return adjustedArea;
 }
 
+Workspace::ClientStrut Workspace::clientStrut(AbstractClient *client, const QRect &desktopArea, const QVector<QRect> &screens) const
+{
+    ClientStrut strut;
+    strut.desktop = client->isOnAllDesktops() ? NETWinInfo::OnAllDesktops : client->desktop();
+
+    QRect r = adjustClientArea(client, desktopArea);
+    // sanity check that a strut doesn't exclude a complete screen geometry
+    // this is a violation to EWMH, as KWin just ignores the strut
+    for (int i = 0; i < screens.count(); i++) {
+        if (!r.intersects(screens[i])) {
+            qCDebug(KWIN_CORE) << "Adjusted client area would exclude a complete screen, ignore";
+            r = desktopArea;
+            break;
+        }
+    }
+
+    // Ignore offscreen xinerama struts. These interfere with the larger monitors on the setup
+    // and should be ignored so that applications that use the work area to work out where
+    // windows can go can use the entire visible area of the larger monitors.
+    // This goes against the EWMH description of the work area but it is a toss up between
+    // having unusable sections of the screen (Which can be quite large with newer monitors)
+    // or having some content appear offscreen (Relatively rare compared to other).
+    strut.workArea = hasOffscreenXineramaStrut(client) ? desktopArea : r;
+
+    strut.restrictedMoveArea = client->strutRects();
+    const QRect clientsScreenRect = KWin::screens()->geometry(client->screen());
+    for (auto it = strut.restrictedMoveArea.begin(); it != strut.restrictedMoveArea.end(); it++) {
+        *it = StrutRect((*it).intersected(clientsScreenRect), (*it).area());
+    }
+
+    strut.screenAreas.reserve(screens.count());
+    for (const QRect &screen : screens) {
+        strut.screenAreas.append(adjustClientArea(client, screen));
+    }
+    return strut;
+}
+
 /**
  * Updates the current client areas according to the current clients.
  *
@@ -2052,6 +2103,10 @@ QRect Workspace::adjustClientArea(AbstractClient *client, const QRect &area) con
  * which is not taken by windows like panels, the top-of-screen menu
  * etc).
  *
+ * The areas taken by the struts are kept from the previous update, so that only the
+ * desktops on which a strut changed are computed again, and only the clients on the
+ * desktops whose areas changed have to check their position.
+ *
  * @see clientArea()
  */
 void Workspace::updateClientArea(bool force)
@@ -2059,125 +2114,93 @@ void Workspace::updateClientArea(bool force)
     const Screens *s = Screens::self();
     int nscreens = s->count();
     const int numberOfDesktops = VirtualDesktopManager::self()->count();
-    QVector< QRect > new_wareas(numberOfDesktops + 1);
-    QVector< StrutRects > new_rmoveareas(numberOfDesktops + 1);
-    QVector< QVector< QRect > > new_sareas(numberOfDesktops + 1);
     QVector< QRect > screens(nscreens);
     QRect desktopArea;
-    for (int i = 0; i < nscreens; i++) {
-        desktopArea |= s->geometry(i);
-    }
     for (int iS = 0;
             iS < nscreens;
             iS ++) {
         screens [iS] = s->geometry(iS);
+        desktopArea |= screens [iS];
+    }
+
+    QVector<ClientStrut> struts;
+    for (AbstractClient *client : qAsConst(m_allClients)) {
+        if (client->hasStrut()) {
+            struts.append(clientStrut(client, desktopArea, screens));
+        }
     }
+
+    // Find the desktops on which the struts changed. The struts are compared in the order
+    // they are applied in, as a strut which would remove a whole screen is ignored depending
+    // on the struts applied before it.
+    QVector<bool> dirty(numberOfDesktops + 1, false);
+    const bool resized = screenarea.isEmpty() || workarea.size() != numberOfDesktops + 1;
+    const bool rebuild = force || resized || screens != m_strutScreens;
+    auto markDirty = [&dirty](const ClientStrut &strut) {
+        if (strut.desktop == NETWinInfo::OnAllDesktops) {
+            dirty.fill(true);
+        } else if (strut.desktop > 0 && strut.desktop < dirty.size()) {
+            dirty[strut.desktop] = true;
+        }
+    };
+    if (rebuild) {
+        dirty.fill(true);
+    } else {
+        for (int i = 0; i < std::max(struts.size(), m_clientStruts.size()); ++i) {
+            if (i >= struts.size()) {
+                markDirty(m_clientStruts[i]);
+            } else if (i >= m_clientStruts.size()) {
+                markDirty(struts[i]);
+            } else if (!(struts[i] == m_clientStruts[i])) {
+                markDirty(m_clientStruts[i]);
+                markDirty(struts[i]);
+            }
+        }
+    }
+    m_clientStruts = struts;
+    m_strutScreens = screens;
+
+    QVector< QRect > new_wareas = resized ? QVector<QRect>(numberOfDesktops + 1) : workarea;
+    QVector< StrutRects > new_rmoveareas = resized ? QVector<StrutRects>(numberOfDesktops + 1) : restrictedmovearea;
+    QVector< QVector< QRect > > new_sareas = resized ? QVector<QVector<QRect>>(numberOfDesktops + 1) : screenarea;
+    QVector<bool> changed(numberOfDesktops + 1, force);
+    bool anyChanged = force;
+
     for (int i = 1;
             i <= numberOfDesktops;
             ++i) {
-        new_wareas[ i ] = desktopArea;
-        new_sareas[ i ].resize(nscreens);
-        for (int iS = 0;
-                iS < nscreens;
-                iS ++)
-            new_sareas[ i ][ iS ] = screens[ iS ];
-    }
-    for (AbstractClient *client : qAsConst(m_allClients)) {
-        if (!client->hasStrut()) {
+        if (!dirty[ i ]) {
             continue;
         }
-        QRect r = adjustClientArea(client, desktopArea);
-        // sanity check that a strut doesn't exclude a complete screen geometry
-        // this is a violation to EWMH, as KWin just ignores the strut
-        for (int i = 0; i < Screens::self()->count(); i++) {
-            if (!r.intersects(Screens::self()->geometry(i))) {
-                qCDebug(KWIN_CORE) << "Adjusted client area would exclude a complete screen, ignore";
-                r = desktopArea;
-                break;
-            }
-        }
-        StrutRects strutRegion = client->strutRects();
-        const QRect clientsScreenRect = KWin::screens()->geometry(client->screen());
-        for (auto strut = strutRegion.begin(); strut != strutRegion.end(); strut++) {
-            *strut = StrutRect((*strut).intersected(clientsScreenRect), (*strut).area());
-        }
-
-        // Ignore offscreen xinerama struts. These interfere with the larger monitors on the setup
-        // and should be ignored so that applications that use the work area to work out where
-        // windows can go can use the entire visible area of the larger monitors.
-        // This goes against the EWMH description of the work area but it is a toss up between
-        // having unusable sections of the screen (Which can be quite large with newer monitors)
-        // or having some content appear offscreen (Relatively rare compared to other).
-        bool hasOffscreenStrut = hasOffscreenXineramaStrut(client);
-
-        if (client->isOnAllDesktops()) {
-            for (int i = 1;
-                    i <= numberOfDesktops;
-                    ++i) {
-                if (!hasOffscreenStrut)
-                    new_wareas[ i ] = new_wareas[ i ].intersected(r);
-                new_rmoveareas[ i ] += strutRegion;
-                for (int iS = 0;
-                        iS < nscreens;
-                        iS ++) {
-                    const auto geo = new_sareas[ i ][ iS ].intersected(
-                                                adjustClientArea(client, screens[ iS ]));
-                    // ignore the geometry if it results in the screen getting removed completely
-                    if (!geo.isEmpty()) {
-                        new_sareas[ i ][ iS ] = geo;
-                    }
-                }
+        QRect warea = desktopArea;
+        StrutRects rmovearea;
+        QVector< QRect > sareas = screens;
+        for (const ClientStrut &strut : qAsConst(struts)) {
+            if (strut.desktop != NETWinInfo::OnAllDesktops && strut.desktop != i) {
+                continue;
             }
-        } else {
-            if (!hasOffscreenStrut)
-                new_wareas[client->desktop()] = new_wareas[client->desktop()].intersected(r);
-            new_rmoveareas[client->desktop()] += strutRegion;
+            warea = warea.intersected(strut.workArea);
+            rmovearea += strut.restrictedMoveArea;
             for (int iS = 0;
                     iS < nscreens;
                     iS ++) {
-//                            qDebug() << "adjusting new_sarea: " << screens[ iS ];
-                const auto geo = new_sareas[client->desktop()][ iS ].intersected(
-                      adjustClientArea(client, screens[ iS ]));
+                const auto geo = sareas[ iS ].intersected(strut.screenAreas[ iS ]);
                 // ignore the geometry if it results in the screen getting removed completely
                 if (!geo.isEmpty()) {
-                    new_sareas[client->desktop()][ iS ] = geo;
+                    sareas[ iS ] = geo;
                 }
             }
         }
+        if (resized || warea != workarea[ i ] || rmovearea != restrictedmovearea[ i ] || sareas != screenarea[ i ]) {
+            new_wareas[ i ] = warea;
+            new_rmoveareas[ i ] = rmovearea;
+            new_sareas[ i ] = sareas;
+            changed[ i ] = true;
+            anyChanged = true;
+        }
     }
-#if 0
-    for (int i = 1;
-            i <= numberOfDesktops();
-            ++i) {
-        for (int iS = 0;
-                iS < nscreens;
-                iS ++)
-            qCDebug(KWIN_CORE) << "new_sarea: " << new_sareas[ i ][ iS ];
-    }
-#endif
-
-    bool changed = force;
 
-    if (screenarea.isEmpty())
-        changed = true;
-
-    for (int i = 1;
-            !changed && i <= numberOfDesktops;
-            ++i) {
-        if (workarea[ i ] != new_wareas[ i ])
-            changed = true;
-        if (restrictedmovearea[ i ] != new_rmoveareas[ i ])
-            changed = true;
-        if (screenarea[ i ].size() != new_sareas[ i ].size())
-            changed = true;
-        for (int iS = 0;
-                !changed && iS < nscreens;
-                iS ++)
-            if (new_sareas[ i ][ iS ] != screenarea [ i ][ iS ])
-                changed = true;
-    }
-
-    if (changed) {
+    if (anyChanged) {
         workarea = new_wareas;
         oldrestrictedmovearea = restrictedmovearea;
         restrictedmovearea = new_rmoveareas;
@@ -2185,6 +2208,9 @@ void Workspace::updateClientArea(bool force)
         if (rootInfo()) {
             NETRect r;
             for (int i = 1; i <= numberOfDesktops; i++) {
+                if (!changed[ i ]) {
+                    continue;
+                }
                 r.pos.x = workarea[ i ].x();
                 r.pos.y = workarea[ i ].y();
                 r.size.width = workarea[ i ].width();
@@ -2196,7 +2222,14 @@ void Workspace::updateClientArea(bool force)
         for (auto it = m_allClients.constBegin();
                 it != m_allClients.constEnd();
                 ++it) {
-            (*it)->checkWorkspacePosition();
+            AbstractClient *client = *it;
+            bool affected = client->isOnAllDesktops();
+            for (int i = 1; !affected && i <= numberOfDesktops; ++i) {
+                affected = changed[ i ] && client->isOnDesktop(i);
+            }
+            if (affected) {
+                client->checkWorkspacePosition();
+            }
         }
 
         oldrestrictedmovearea.clear(); // reset, no longer valid or needed
@@ -2767,7 +2800,7 @@ void Workspace::setMoveResizeClient(AbstractClient *c)
 // When kwin crashes, windows will not be gravitated back to their original position
 // and will remain offset by the size of the decoration. So when restarting, fix this
 // (the property with the size of the frame remains on the window after the crash).
-void Workspace::fixPositionAfterCrash(xcb_window_t w, const xcb_get_geometry_reply_t *geometry)
+bool Workspace::fixPositionAfterCrash(xcb_window_t w, const xcb_get_geometry_reply_t *geometry)
 {
     NETWinInfo i(connection(), w, rootWindow(), NET::WMFrameExtents, NET::Properties2());
     NETStrut frame = i.frameExtents();
@@ -2778,7 +2811,9 @@ void Workspace::fixPositionAfterCrash(xcb_window_t w, const xcb_get_geometry_rep
         const uint32_t top = frame.top;
         const uint32_t values[] = { geometry->x - left, geometry->y - top };
         xcb_configure_window(connection(), w, XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y, values);
+        return true;
     }
+    return false;
 }
 
 } // namespace
@@ -52,6 +52,7 @@ class Toplevel;
 class Unmanaged;
 class UserActionsMenu;
 class X11Client;
+class X11ClientRequests;
 class X11EventFilter;
 enum class Predicate;
 
@@ -541,11 +542,13 @@ private:
     bool keepDeletedTransientAbove(const Toplevel *mainWindow, const Deleted *transient) const;
     void blockStackingUpdates(bool block);
     void updateToolWindows(bool also_hide);
-    void fixPositionAfterCrash(xcb_window_t w, const xcb_get_geometry_reply_t *geom);
+    // returns whether the window has been moved
+    bool fixPositionAfterCrash(xcb_window_t w, const xcb_get_geometry_reply_t *geom);
     void saveOldScreenSizes();
 
     /// This is the right way to create a new client
     X11Client *createClient(xcb_window_t w, bool is_mapped);
+    X11Client *createClient(X11ClientRequests &requests, bool is_mapped);
     void setupClientConnections(AbstractClient *client);
     void addClient(X11Client *c);
     Unmanaged* createUnmanaged(xcb_window_t w);
@@ -637,6 +640,24 @@ private:
     QScopedPointer<KStartupInfo> m_startup;
     QScopedPointer<ColorMapper> m_colorMapper;
 
+    /**
+     * The areas taken by the strut of a client, as used by the last updateClientArea().
+     */
+    struct ClientStrut {
+        int desktop; // NETWinInfo::OnAllDesktops if the client is on all desktops
+        QRect workArea;
+        StrutRects restrictedMoveArea;
+        QVector<QRect> screenAreas;
+
+        bool operator==(const ClientStrut &other) const {
+            return desktop == other.desktop && workArea == other.workArea
+                && restrictedMoveArea == other.restrictedMoveArea && screenAreas == other.screenAreas;
+        }
+    };
+    ClientStrut clientStrut(AbstractClient *client, const QRect &desktopArea, const QVector<QRect> &screens) const;
+    QVector<ClientStrut> m_clientStruts;
+    QVector<QRect> m_strutScreens;
+
     QVector<QRect> workarea; // Array of workareas for virtual desktops
     // Array of restricted areas that window cannot be moved into
     QVector<StrutRects> restrictedmovearea;
@@ -663,6 +684,7 @@ private:
 private:
     friend bool performTransiencyCheck();
     friend Workspace *workspace();
+    friend class X11WindowAdoptionTest;
 };
 
 /**
@@ -316,12 +316,29 @@ void X11Client::destroyClient()
  * reparenting, initial geometry, initial state, placement, etc.
  * Returns false if KWin is not going to manage this window.
  */
-bool X11Client::manage(xcb_window_t w, bool isMapped)
+static Xcb::Property fetchSyncCounter(xcb_window_t window)
+{
+    if (!Xcb::Extensions::self()->isSyncAvailable()) {
+        return Xcb::Property();
+    }
+    return Xcb::Property(false, window, atoms->net_wm_sync_request_counter, XCB_ATOM_CARDINAL, 0, 1);
+}
+
+X11ClientRequests::X11ClientRequests(xcb_window_t window)
+    : window(window)
+    , attributes(window)
+    , geometry(window)
+    , syncCounter(fetchSyncCounter(window))
+{
+}
+
+bool X11Client::manage(X11ClientRequests &requests, bool isMapped)
 {
     StackingUpdatesBlocker stacking_blocker(workspace());
 
-    Xcb::WindowAttributes attr(w);
-    Xcb::WindowGeometry windowGeometry(w);
+    const xcb_window_t w = requests.window;
+    Xcb::WindowAttributes &attr = requests.attributes;
+    Xcb::WindowGeometry &windowGeometry = requests.geometry;
     if (attr.isNull() || windowGeometry.isNull()) {
         return false;
     }
@@ -394,7 +411,7 @@ bool X11Client::manage(xcb_window_t w, bool isMapped)
     getResourceClass();
     readWmClientLeader(wmClientLeaderCookie);
     getWmClientMachine();
-    getSyncCounter();
+    readSyncCounter(requests.syncCounter);
     // First only read the caption text, so that setupWindowRules() can use it for matching,
     // and only then really set the caption using setCaption(), which checks for duplicates etc.
     // and also relies on rules already existing
@@ -1522,7 +1539,7 @@ void X11Client::updateVisibility()
     if (isZombie())
         return;
     if (hidden) {
-        info->setState(NET::Hidden, NET::Hidden);
+        exportHiddenState(true);
         setSkipTaskbar(true);   // Also hide from taskbar
         if (compositing() && options->hiddenPreviews() == HiddenPreviewsAlways)
             internalKeep();
@@ -1532,14 +1549,14 @@ void X11Client::updateVisibility()
     }
     setSkipTaskbar(originalSkipTaskbar());   // Reset from 'hidden'
     if (isMinimized()) {
-        info->setState(NET::Hidden, NET::Hidden);
+        exportHiddenState(true);
         if (compositing() && options->hiddenPreviews() == HiddenPreviewsAlways)
             internalKeep();
         else
             internalHide();
         return;
     }
-    info->setState(NET::States(), NET::Hidden);
+    exportHiddenState(false);
     if (!isOnCurrentDesktop()) {
         if (compositing() && options->hiddenPreviews() != HiddenPreviewsNever)
             internalKeep();
@@ -1558,6 +1575,19 @@ void X11Client::updateVisibility()
 }
 
 
+/**
+ * Sets NET::Hidden in the client window's state. Desktop switches update the visibility
+ * of every window, most of which keep their state, so the property is only written
+ * when the state actually changes.
+ */
+void X11Client::exportHiddenState(bool isHidden)
+{
+    const NET::States state = isHidden ? NET::Hidden : NET::States();
+    if ((info->state() & NET::Hidden) != state) {
+        info->setState(state, NET::Hidden);
+    }
+}
+
 /**
  * Sets the client window's mapping state. Possible values are
  * WithdrawnState, IconicState, NormalState.
@@ -2293,14 +2323,19 @@ bool X11Client::wantsSyncCounter() const
 }
 
 void X11Client::getSyncCounter()
+{
+    Xcb::Property syncProp = fetchSyncCounter(window());
+    readSyncCounter(syncProp);
+}
+
+void X11Client::readSyncCounter(Xcb::Property &property)
 {
     if (!Xcb::Extensions::self()->isSyncAvailable())
         return;
     if (!wantsSyncCounter())
         return;
 
-    Xcb::Property syncProp(false, window(), atoms->net_wm_sync_request_counter, XCB_ATOM_CARDINAL, 0, 1);
-    const xcb_sync_counter_t counter = syncProp.value<xcb_sync_counter_t>(XCB_NONE);
+    const xcb_sync_counter_t counter = property.value<xcb_sync_counter_t>(XCB_NONE);
     if (counter != XCB_NONE) {
         m_syncRequest.counter = counter;
         m_syncRequest.value.hi = 0;
@@ -46,6 +46,24 @@ enum class Predicate {
     InputIdMatch
 };
 
+/**
+ * The requests X11Client::manage() waits for before it embeds a window.
+ *
+ * The requests are sent on construction. When the existing windows are adopted, they are
+ * sent for all windows before the first one is managed, so the replies arrive in one go
+ * instead of costing a round trip per window.
+ */
+class X11ClientRequests
+{
+public:
+    explicit X11ClientRequests(xcb_window_t window);
+
+    xcb_window_t window;
+    Xcb::WindowAttributes attributes;
+    Xcb::WindowGeometry geometry;
+    Xcb::Property syncCounter;
+};
+
 class KWIN_EXPORT X11Client : public AbstractClient
 {
     Q_OBJECT
@@ -118,7 +136,7 @@ public:
     bool windowEvent(xcb_generic_event_t *e);
     NET::WindowType windowType(bool direct = false, int supported_types = 0) const override;
 
-    bool manage(xcb_window_t w, bool isMapped);
+    bool manage(X11ClientRequests &requests, bool isMapped);
     void releaseWindow(bool on_shutdown = false);
     void destroyClient() override;
 
@@ -373,6 +391,7 @@ Q_SIGNALS:
 
 private:
     void exportMappingState(int s);   // ICCCM 4.1.3.1, 4.1.4, NETWM 2.5.1
+    void exportHiddenState(bool isHidden);
     bool isManaged() const; ///< Returns false if this client is not yet managed
     void updateAllowedActions(bool force = false);
     QRect fullscreenMonitorsArea(NETFullscreenMonitors topology) const;
@@ -391,6 +410,7 @@ private:
     NETExtendedStrut strut() const;
     int checkShadeGeometry(int w, int h);
     void getSyncCounter();
+    void readSyncCounter(Xcb::Property &property);
     void sendSyncRequest();
     void leaveMoveResize() override;
     void positionGeometryTip() override;
@@ -7,7 +7,10 @@
 #include "xcursortheme.h"
 #include "3rdparty/xcursor.h"
 
-#include <QMap>
+#include <QCache>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
 #include <QSharedData>
 
 namespace KWin
@@ -24,8 +27,12 @@ public:
 class KXcursorThemePrivate : public QSharedData
 {
 public:
-    QMap<QByteArray, QVector<KXcursorSprite>> registry;
+    // the file of every cursor in the theme and its inherited themes
+    QHash<QByteArray, QString> index;
+    // the cursors which have been requested so far
+    mutable QHash<QByteArray, QVector<KXcursorSprite>> registry;
     qreal devicePixelRatio = 1;
+    int size = 0;
 };
 
 KXcursorSprite::KXcursorSprite()
@@ -72,11 +79,60 @@ std::chrono::milliseconds KXcursorSprite::delay() const
     return d->delay;
 }
 
-static void load_callback(XcursorImages *images, void *data)
+struct KXcursorCacheKey
 {
-    KXcursorThemePrivate *themePrivate = static_cast<KXcursorThemePrivate *>(data);
-    QVector<KXcursorSprite> sprites;
+    QString filePath;
+    qint64 lastModified;
+    int size;
+};
+
+static bool operator==(const KXcursorCacheKey &a, const KXcursorCacheKey &b)
+{
+    return a.filePath == b.filePath && a.lastModified == b.lastModified && a.size == b.size;
+}
+
+static uint qHash(const KXcursorCacheKey &key, uint seed = 0)
+{
+    return ::qHash(key.filePath, seed) ^ ::qHash(key.lastModified, seed) ^ uint(key.size);
+}
+
+/**
+ * The decoded cursors are shared between all themes, so loading a theme again for another
+ * scale or device pixel ratio doesn't decode the cursors again if the size in device pixels
+ * matches. The hotspots of the cached sprites are in device pixels.
+ */
+static QCache<KXcursorCacheKey, QVector<KXcursorSprite>> &spriteCache()
+{
+    static QCache<KXcursorCacheKey, QVector<KXcursorSprite>> cache(4 * 1024 * 1024);
+    return cache;
+}
+
+static QVector<KXcursorSprite> loadSprites(const QString &filePath, int size)
+{
+    const QFileInfo fileInfo(filePath);
+    const KXcursorCacheKey key{filePath, fileInfo.lastModified().toMSecsSinceEpoch(), size};
+    if (const QVector<KXcursorSprite> *sprites = spriteCache().object(key)) {
+        return *sprites;
+    }
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QVector<KXcursorSprite>();
+    }
+    XcursorImages *images;
+    if (const uchar *data = file.map(0, file.size())) {
+        images = xcursor_load_images_from_memory(data, file.size(), size);
+    } else {
+        const QByteArray data = file.readAll();
+        images = xcursor_load_images_from_memory(reinterpret_cast<const unsigned char *>(data.constData()),
+                                                 data.size(), size);
+    }
+    if (!images) {
+        return QVector<KXcursorSprite>();
+    }
 
+    QVector<KXcursorSprite> sprites;
+    int cost = 0;
     for (int i = 0; i < images->nimage; ++i) {
         const XcursorImage *nativeCursorImage = images->images[i];
         const QPoint hotspot(nativeCursorImage->xhot, nativeCursorImage->yhot);
@@ -84,12 +140,25 @@ static void load_callback(XcursorImages *images, void *data)
 
         QImage data(nativeCursorImage->width, nativeCursorImage->height, QImage::Format_ARGB32);
         memcpy(data.bits(), nativeCursorImage->pixels, data.sizeInBytes());
+        cost += data.sizeInBytes();
 
-        sprites.append(KXcursorSprite(data, hotspot / themePrivate->devicePixelRatio, delay));
+        sprites.append(KXcursorSprite(data, hotspot, delay));
     }
-
-    themePrivate->registry.insert(images->name, sprites);
     XcursorImagesDestroy(images);
+
+    spriteCache().insert(key, new QVector<KXcursorSprite>(sprites), cost);
+    return sprites;
+}
+
+static void index_callback(const char *name, const char *filePath, void *data)
+{
+    KXcursorThemePrivate *themePrivate = static_cast<KXcursorThemePrivate *>(data);
+
+    // the first file wins, inherited themes come after the theme itself
+    const QByteArray cursorName(name);
+    if (!themePrivate->index.contains(cursorName)) {
+        themePrivate->index.insert(cursorName, QFile::decodeName(filePath));
+    }
 }
 
 KXcursorTheme::KXcursorTheme()
@@ -119,12 +188,28 @@ qreal KXcursorTheme::devicePixelRatio() const
 
 bool KXcursorTheme::isEmpty() const
 {
-    return d->registry.isEmpty();
+    return d->index.isEmpty();
 }
 
 QVector<KXcursorSprite> KXcursorTheme::shape(const QByteArray &name) const
 {
-    return d->registry.value(name);
+    auto it = d->registry.constFind(name);
+    if (it != d->registry.constEnd()) {
+        return *it;
+    }
+
+    QVector<KXcursorSprite> sprites;
+    const QString filePath = d->index.value(name);
+    if (!filePath.isEmpty()) {
+        const QVector<KXcursorSprite> nativeSprites = loadSprites(filePath, d->size);
+        sprites.reserve(nativeSprites.count());
+        for (const KXcursorSprite &sprite : nativeSprites) {
+            sprites.append(KXcursorSprite(sprite.data(), sprite.hotspot() / d->devicePixelRatio,
+                                          sprite.delay()));
+        }
+    }
+    d->registry.insert(name, sprites);
+    return sprites;
 }
 
 KXcursorTheme KXcursorTheme::fromTheme(const QString &themeName, int size, qreal dpr)
@@ -132,9 +217,11 @@ KXcursorTheme KXcursorTheme::fromTheme(const QString &themeName, int size, qreal
     KXcursorTheme theme;
     KXcursorThemePrivate *themePrivate = theme.d;
     themePrivate->devicePixelRatio = dpr;
+    themePrivate->size = size * dpr;
 
+    // Only index the files, cursors get decoded when they are requested for the first time.
     const QByteArray nativeThemeName = themeName.toUtf8();
-    xcursor_load_theme(nativeThemeName, size * dpr, load_callback, themePrivate);
+    xcursor_index_theme(nativeThemeName, index_callback, themePrivate);
 
     return theme;
 }
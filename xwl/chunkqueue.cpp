@@ -0,0 +1,92 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2020 KWin developers <kwin@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "chunkqueue.h"
+
+#include <unistd.h>
+
+namespace KWin
+{
+namespace Xwl
+{
+
+ChunkQueue::ChunkQueue(int chunkSize, int maximumChunkCount)
+    : m_chunkSize(chunkSize)
+    , m_maximumChunkCount(maximumChunkCount)
+{
+    m_chunks.reserve(maximumChunkCount);
+    m_freeBuffers.reserve(maximumChunkCount);
+}
+
+ssize_t ChunkQueue::readFrom(int fd)
+{
+    Q_ASSERT(!isFull() && !m_finished);
+
+    if (m_chunks.isEmpty() || m_chunks.last().size == m_chunkSize) {
+        QByteArray buffer;
+        if (m_freeBuffers.isEmpty()) {
+            buffer.resize(m_chunkSize);
+        } else {
+            buffer = m_freeBuffers.takeLast();
+        }
+        m_chunks.append(Chunk{buffer, 0});
+    }
+
+    Chunk &chunk = m_chunks.last();
+    const ssize_t readLength = read(fd, chunk.buffer.data() + chunk.size, m_chunkSize - chunk.size);
+    if (readLength > 0) {
+        chunk.size += readLength;
+    }
+    return readLength;
+}
+
+void ChunkQueue::finish()
+{
+    m_finished = true;
+}
+
+bool ChunkQueue::isFull() const
+{
+    return m_chunks.count() == m_maximumChunkCount && m_chunks.last().size == m_chunkSize;
+}
+
+bool ChunkQueue::isEmpty() const
+{
+    return m_chunks.isEmpty();
+}
+
+int ChunkQueue::count() const
+{
+    return m_chunks.count();
+}
+
+bool ChunkQueue::hasCompleteChunk() const
+{
+    if (m_chunks.isEmpty()) {
+        return false;
+    }
+    return m_chunks.count() > 1 || m_finished || m_chunks.first().size == m_chunkSize;
+}
+
+const char *ChunkQueue::firstData() const
+{
+    return m_chunks.first().buffer.constData();
+}
+
+int ChunkQueue::firstSize() const
+{
+    return m_chunks.first().size;
+}
+
+void ChunkQueue::removeFirst()
+{
+    m_freeBuffers.append(m_chunks.takeFirst().buffer);
+}
+
+} // namespace Xwl
+} // namespace KWin
@@ -0,0 +1,87 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2020 KWin developers <kwin@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#ifndef KWIN_XWL_CHUNKQUEUE
+#define KWIN_XWL_CHUNKQUEUE
+
+#include <QByteArray>
+#include <QVector>
+
+#include <sys/types.h>
+
+namespace KWin
+{
+namespace Xwl
+{
+
+/**
+ * A bounded queue of data chunks read from a file descriptor.
+ *
+ * Data is read directly into fixed size chunks. A chunk is complete once it is full, or
+ * once the end of the data has been reached. At most a given number of chunks is held,
+ * so a fast source can't make the queue grow without limits while the receiving end
+ * is slow. The buffers of removed chunks are reused for later chunks.
+ */
+class ChunkQueue
+{
+public:
+    ChunkQueue(int chunkSize, int maximumChunkCount);
+
+    /**
+     * Reads as much data from @p fd as fits into the current chunk, starting a new chunk
+     * if needed. Returns the number of bytes read, 0 at the end of the data or -1 on error.
+     *
+     * Must not be called if the queue is full.
+     */
+    ssize_t readFrom(int fd);
+
+    /**
+     * Marks the end of the data, which completes the last chunk.
+     */
+    void finish();
+
+    /**
+     * Returns @c true if no more data can be read before a chunk has been removed.
+     */
+    bool isFull() const;
+    bool isEmpty() const;
+    int count() const;
+
+    /**
+     * Returns @c true if the first chunk is complete and can be handed on.
+     */
+    bool hasCompleteChunk() const;
+
+    /**
+     * Returns the data of the first chunk, it's only valid until the chunk is removed.
+     */
+    const char *firstData() const;
+    int firstSize() const;
+
+    /**
+     * Removes the first chunk.
+     */
+    void removeFirst();
+
+private:
+    struct Chunk {
+        QByteArray buffer;
+        int size;
+    };
+
+    QVector<Chunk> m_chunks;
+    QVector<QByteArray> m_freeBuffers;
+    int m_chunkSize;
+    int m_maximumChunkCount;
+    bool m_finished = false;
+};
+
+} // namespace Xwl
+} // namespace KWin
+
+#endif
@@ -40,6 +40,8 @@ namespace Xwl
 
 // in Bytes: equals 64KB
 static const uint32_t s_incrChunkSize = 63 * 1024;
+// how many chunks a Wayland to X transfer buffers at most
+static const int s_maximumChunkCount = 4;
 
 Transfer::Transfer(xcb_atom_t selection, qint32 fd, xcb_timestamp_t timestamp, QObject *parent)
     : QObject(parent)
@@ -89,6 +91,7 @@ TransferWltoX::TransferWltoX(xcb_atom_t selection, xcb_selection_request_event_t
                              qint32 fd, QObject *parent)
     : Transfer(selection, fd, 0, parent)
     , m_request(request)
+    , m_chunks(s_incrChunkSize, s_maximumChunkCount)
 {
 }
 
@@ -119,20 +122,25 @@ int TransferWltoX::flushSourceData()
                         m_request->property,
                         m_request->target,
                         8,
-                        m_chunks.first().first.size(),
-                        m_chunks.first().first.data());
+                        m_chunks.firstSize(),
+                        m_chunks.firstData());
     xcb_flush(xcbConn);
 
     m_propertyIsSet = true;
     resetTimeout();
 
-    const auto rm = m_chunks.takeFirst();
-    return rm.first.size();
+    // xcb has copied the data, so the chunk can be reused
+    const int size = m_chunks.firstSize();
+    m_chunks.removeFirst();
+    if (socketNotifier()) {
+        socketNotifier()->setEnabled(true);
+    }
+    return size;
 }
 
 void TransferWltoX::startIncr()
 {
-    Q_ASSERT(m_chunks.size() == 1);
+    Q_ASSERT(m_chunks.count() == 1);
 
     xcb_connection_t *xcbConn = kwinApp()->x11Connection();
 
@@ -161,20 +169,7 @@ void TransferWltoX::startIncr()
 
 void TransferWltoX::readWlSource()
 {
-    if (m_chunks.size() == 0 ||
-            m_chunks.last().second == s_incrChunkSize) {
-        // append new chunk
-        auto next = QPair<QByteArray, int>();
-        next.first.resize(s_incrChunkSize);
-        next.second = 0;
-        m_chunks.append(next);
-    }
-
-    const auto oldLen = m_chunks.last().second;
-    const auto avail = s_incrChunkSize - m_chunks.last().second;
-    Q_ASSERT(avail > 0);
-
-    ssize_t readLen = read(fd(), m_chunks.last().first.data() + oldLen, avail);
+    const ssize_t readLen = m_chunks.readFrom(fd());
     if (readLen == -1) {
         qCWarning(KWIN_XWL) << "Error reading in Wl data.";
 
@@ -182,11 +177,10 @@ void TransferWltoX::readWlSource()
         endTransfer();
         return;
     }
-    m_chunks.last().second = oldLen + readLen;
 
     if (readLen == 0) {
         // at the fd end - complete transfer now
-        m_chunks.last().first.resize(m_chunks.last().second);
+        m_chunks.finish();
 
         if (incr()) {
             // incremental transfer is to be completed now
@@ -203,7 +197,10 @@ void TransferWltoX::readWlSource()
             Q_EMIT selectionNotify(m_request, true);
             endTransfer();
         }
-    } else if (m_chunks.last().second == s_incrChunkSize) {
+        return;
+    }
+
+    if (m_chunks.hasCompleteChunk()) {
         // first chunk full, but not yet at fd end -> go incremental
         if (incr()) {
             m_flushPropertyOnDelete = true;
@@ -216,6 +213,10 @@ void TransferWltoX::readWlSource()
             startIncr();
         }
     }
+    if (m_chunks.isFull()) {
+        // wait for the X client to catch up before reading more
+        socketNotifier()->setEnabled(false);
+    }
     resetTimeout();
 }
 
@@ -258,9 +259,10 @@ void TransferWltoX::handlePropertyDelete()
             xcb_flush(xcbConn);
             m_flushPropertyOnDelete = false;
             endTransfer();
-        } else {
+        } else if (m_chunks.hasCompleteChunk()) {
             flushSourceData();
         }
+        // otherwise the next chunk is flushed as soon as it's complete
     }
 }
 
@@ -9,6 +9,8 @@
 #ifndef KWIN_XWL_TRANSFER
 #define KWIN_XWL_TRANSFER
 
+#include "chunkqueue.h"
+
 #include <QObject>
 #include <QSocketNotifier>
 #include <QVector>
@@ -126,10 +128,8 @@ private:
 
     xcb_selection_request_event_t *m_request = nullptr;
 
-    /* contains all received data portioned in chunks
-     * TODO: explain second QPair component
-     */
-    QVector<QPair<QByteArray, int> > m_chunks;
+    // the received data which hasn't been sent to the X client yet
+    ChunkQueue m_chunks;
 
     bool m_propertyIsSet = false;
     bool m_flushPropertyOnDelete = false;